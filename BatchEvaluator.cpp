@@ -0,0 +1,201 @@
+/**
+ * Title: BatchEvaluator
+ * Many functions evaluated over the same x values.
+ * @author Mary Wyllie
+ */
+
+#include "BatchEvaluator.h"
+
+/**
+ * Constructor.
+ */
+BatchEvaluator::BatchEvaluator()
+{
+}
+
+/**
+ * Destructor.
+ */
+BatchEvaluator::~BatchEvaluator()
+{
+}
+
+/**
+ * Calculate every function at every point.
+ * @param x (input) x input values.
+ * @param y (output) y output values, count for each function in
+ * turn: function i at x[j] is y[i * count + j]. Left unchanged
+ * where undefined.
+ * @param status (output) TMathResult for each function and point,
+ * laid out as y.
+ * @param count (input) Number of points.
+ * @param constants (optional input) Constants from BindParameters,
+ * or NULL for the image's own.
+ */
+void
+BatchEvaluator::CalculateYBatch(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	EvaluateBatch(x, y, status, count, constants ? constants : m_Constants);
+}
+
+/**
+ * Calculate every function at every point in single precision.
+ * @param x (input) x input values.
+ * @param y (output) y output values, laid out as for double.
+ * @param status (output) TMathResult for each function and point.
+ * @param count (input) Number of points.
+ * @param constants (optional input) Constants from BindParameters,
+ * or NULL for the image's own.
+ */
+void
+BatchEvaluator::CalculateYBatch(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	EvaluateBatch(x, y, status, count, constants ? constants : m_Constants);
+}
+
+/**
+ * Calculate every function for either scalar type, a group of
+ * MATH_BATCH_GROUP functions at a time.
+ */
+template <class T>
+void
+BatchEvaluator::EvaluateBatch(
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	int functions = GetFunctionCount();
+	int groups = (functions + MATH_BATCH_GROUP - 1) / MATH_BATCH_GROUP;
+	if(count <= 0) return;
+
+	if((double) functions * count < MATH_BATCH_PARALLEL)
+	{
+		for(int group = 0; group < groups; group++)
+		{
+			int first = group * MATH_BATCH_GROUP;
+			int last = (first + MATH_BATCH_GROUP < functions) ?
+				first + MATH_BATCH_GROUP : functions;
+			EvaluateGroup(first, last, x, y, status, count, constants);
+		}
+		return;
+	}
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int group = 0; group < groups; group++)
+	{
+		int first = group * MATH_BATCH_GROUP;
+		int last = (first + MATH_BATCH_GROUP < functions) ?
+			first + MATH_BATCH_GROUP : functions;
+		EvaluateGroup(first, last, x, y, status, count, constants);
+	}
+}
+
+/**
+ * Calculate one group of functions over every tile of x. Every
+ * function of the group takes the tile before the next tile is read,
+ * and the group's shared nodes are calculated once per tile.
+ * @param first (input) First function of the group.
+ * @param last (input) One past the last function of the group.
+ */
+template <class T>
+void
+BatchEvaluator::EvaluateGroup(
+	int first,
+	int last,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	TImageCache<T> cache;
+	PrepareCache(first, last, &cache);
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		cache.m_X = x + start;
+		cache.m_Tile++;
+		for(int function = first; function < last; function++)
+		{
+			size_t offset = (size_t) function * count + start;
+			EvaluateNodeBlock(m_Roots[function], x + start, y + offset,
+				status + offset, n, constants, &cache);
+		}
+	}
+}
+
+/**
+ * Give a cache slot to every node used more than once by a group of
+ * functions: linked from two places within the group, or the root of
+ * two of its functions. The slots are counted while walking the
+ * group's nodes, each visited once.
+ * @param first (input) First function of the group.
+ * @param last (input) One past the last function of the group.
+ * @param cache (output) Cache with its slots laid out.
+ */
+template <class T>
+void
+BatchEvaluator::PrepareCache(
+	int first,
+	int last,
+	TImageCache<T> *cache) const
+{
+	std::vector<int32_t> visited, stack;
+	int32_t slots = 0;
+
+	//-----------------------------------------------
+	// Count the uses of each node, starting from -1
+	// so that a node used twice or more ends at 1+.
+	//-----------------------------------------------
+	cache->m_Slots.assign(m_Header->m_NodeCount, -1);
+	for(int function = first; function < last; function++)
+	{
+		stack.push_back(m_Roots[function]);
+		while(!stack.empty())
+		{
+			int32_t index = stack.back();
+			stack.pop_back();
+			if(++cache->m_Slots[index] > 0) continue;
+
+			visited.push_back(index);
+			const TImageNode& node = m_Nodes[index];
+			for(int32_t i = 0; i < node.m_LinkCount; i++)
+			{
+				int32_t link = m_Links[node.m_FirstLink + i];
+				if(link >= 0) stack.push_back(link);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < visited.size(); i++)
+	{
+		int32_t& slot = cache->m_Slots[visited[i]];
+		slot = (slot > 0) ? slots++ : -1;
+	}
+
+	cache->m_X = NULL;
+	cache->m_Tile = 0;
+	cache->m_Plans = NULL;
+	cache->m_Tiles.assign(slots, -1);
+	cache->m_Values.resize((size_t) slots * MATH_BLOCK_SIZE);
+	cache->m_Status.resize((size_t) slots * MATH_BLOCK_SIZE);
+}
+
+template void
+BatchEvaluator::PrepareCache<double>(
+	int first,
+	int last,
+	TImageCache<double> *cache) const;
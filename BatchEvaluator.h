@@ -0,0 +1,136 @@
+/**
+ * Title: BatchEvaluator
+ * Many functions evaluated over the same x values.
+ * @author Mary Wyllie
+ */
+
+#ifndef BATCHEVALUATOR_H
+#define BATCHEVALUATOR_H
+
+#include "FunctionImage.h"
+
+//-----------------------------------------------
+// Functions are evaluated in groups of this many,
+// each group taking every tile of x in turn; the
+// groups are shared between threads when there
+// are at least this many function points.
+//-----------------------------------------------
+const int MATH_BATCH_GROUP = 64;
+const double MATH_BATCH_PARALLEL = 65536;
+
+/**
+ * Evaluates every function of a set over one array of x values,
+ * giving a matrix of results with a row for each function. It is a
+ * FunctionImage, built from functions with Build or read with Load.
+ *
+ * Calculating each function over all of x in turn reads x once per
+ * function. Instead, x is taken a tile of MATH_BLOCK_SIZE points at a
+ * time, small enough to stay in the first level cache, and a group of
+ * functions is calculated over the tile before moving to the next.
+ *
+ * A node used by more than one function or operand, such as one
+ * sin(2 pi x) in several sums, is stored once in the image; here it is
+ * also calculated once per tile, and its results copied to each user.
+ * Functions built separately can be made to share their equal parts
+ * with FunctionRewriter::Share first.
+ * Groups of functions are shared between threads; a node shared
+ * between groups is calculated once for each group.
+ */
+class
+BatchEvaluator :
+	public FunctionImage
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	BatchEvaluator();
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~BatchEvaluator();
+
+	/**
+	 * Calculate every function at every point.
+	 * @param x (input) x input values.
+	 * @param y (output) y output values, count for each function in
+	 * turn: function i at x[j] is y[i * count + j]. Left unchanged
+	 * where undefined.
+	 * @param status (output) TMathResult for each function and point,
+	 * laid out as y.
+	 * @param count (input) Number of points.
+	 * @param constants (optional input) Constants from BindParameters,
+	 * or NULL for the image's own.
+	 */
+	void
+	CalculateYBatch(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count,
+		const double *constants = NULL) const;
+
+	/**
+	 * Calculate every function at every point in single precision.
+	 * @param x (input) x input values.
+	 * @param y (output) y output values, laid out as for double.
+	 * @param status (output) TMathResult for each function and point.
+	 * @param count (input) Number of points.
+	 * @param constants (optional input) Constants from BindParameters,
+	 * or NULL for the image's own.
+	 */
+	void
+	CalculateYBatch(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count,
+		const double *constants = NULL) const;
+
+protected:
+
+	/**
+	 * Calculate every function for either scalar type.
+	 */
+	template <class T>
+	void
+	EvaluateBatch(
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count,
+		const double *constants) const;
+
+	/**
+	 * Calculate one group of functions over every tile of x.
+	 */
+	template <class T>
+	void
+	EvaluateGroup(
+		int first,
+		int last,
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count,
+		const double *constants) const;
+
+	/**
+	 * Give a cache slot to every node used more than once by a group
+	 * of functions.
+	 * @param first (input) First function of the group.
+	 * @param last (input) One past the last function of the group.
+	 * @param cache (output) Cache with its slots laid out.
+	 */
+	template <class T>
+	void
+	PrepareCache(
+		int first,
+		int last,
+		TImageCache<T> *cache) const;
+};
+
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include "CompositeFunction.h"
+#include "MathKernels.h"
 
 /**
  * Constructor.
@@ -61,14 +62,222 @@ CompositeFunction::CalculateY(
 	double x,
 	double *y)
 {
-	TMathResult status;
+	TMathResult status = MATH_UNDEFINED;
 	double result = 0;
 
 	if(m_Inside)
 		status = m_Inside->CalculateY(x, &result);
-	if(m_Outside && status)
+	if(m_Outside && status == MATH_SUCCESS)
 		status = m_Outside->CalculateY(result, y);
 
 	return status;
 }
 
+/**
+ * Calculate a block of points in single precision. The inside
+ * function is calculated a block at a time and its results passed
+ * to the outside function as a block.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+CompositeFunction::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	float inside[MATH_BLOCK_SIZE], outside[MATH_BLOCK_SIZE];
+	TMathResult outsideStatus[MATH_BLOCK_SIZE];
+
+	if(!m_Inside || !m_Outside)
+	{
+		for(int i = 0; i < count; i++) status[i] = MATH_UNDEFINED;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+
+		m_Inside->CalculateYBlock(x + start, inside, blockStatus, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] != MATH_SUCCESS) inside[j] = 0;
+		}
+
+		m_Outside->CalculateYBlock(inside, outside, outsideStatus, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] != MATH_SUCCESS) continue;
+			blockStatus[j] = outsideStatus[j];
+			if(outsideStatus[j] == MATH_SUCCESS) y[start + j] = outside[j];
+		}
+	}
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. The
+ * inside function's NaNs are passed to the outside function, and
+ * selected again afterwards since some outside functions, such as a
+ * constant polynomial, give a value at NaN.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+CompositeFunction::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	double inside[MATH_BLOCK_SIZE];
+	double nan = KernelNaN<double>();
+
+	if(!m_Inside || !m_Outside)
+	{
+		for(int i = 0; i < count; i++) y[i] = nan;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		double *yb = y + start;
+
+		m_Inside->CalculateYBlockNaN(x + start, inside, n);
+		m_Outside->CalculateYBlockNaN(inside, yb, n);
+		for(int j = 0; j < n; j++)
+		{
+			yb[j] = (inside[j] != inside[j]) ? nan : yb[j];
+		}
+	}
+}
+
+/**
+ * Calculate points at equally spaced x values. A linear polynomial
+ * inside, a + b x, keeps the spacing, so the outside function is
+ * sampled from a + b xStart in steps of b step. Otherwise only the
+ * inside function sees equally spaced points.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+CompositeFunction::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	MathOperation *inside = m_Inside ? m_Inside->GetMathOperation() : NULL;
+	bool isLinear = (m_Outside && inside &&
+		inside->GetOperatorType() == MATH_POLYNOMIAL);
+
+	for(int i = 2; isLinear && i < inside->GetConstantCount(); i++)
+	{
+		if(inside->GetConstant(i) != 0) isLinear = false;
+	}
+	if(!isLinear)
+	{
+		SampleInside(xStart, step, y, status, count);
+		return;
+	}
+
+	int constants = inside->GetConstantCount();
+	double a = (constants > 0) ? inside->GetConstant(0) : 0;
+	double b = (constants > 1) ? inside->GetConstant(1) : 0;
+	m_Outside->SampleUniform(a + b * xStart, b * step, y, status, count);
+}
+
+/**
+ * Sample the inside function at equally spaced x values, and pass its
+ * results to the outside function as a block.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+CompositeFunction::SampleInside(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	double inside[MATH_BLOCK_SIZE], outside[MATH_BLOCK_SIZE];
+	TMathResult outsideStatus[MATH_BLOCK_SIZE];
+
+	if(!m_Inside || !m_Outside)
+	{
+		for(int i = 0; i < count; i++) status[i] = MATH_UNDEFINED;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+
+		m_Inside->SampleUniform(xStart + (double) start * step, step,
+			inside, blockStatus, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] != MATH_SUCCESS) inside[j] = 0;
+		}
+
+		m_Outside->CalculateYBlock(inside, outside, outsideStatus, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] != MATH_SUCCESS) continue;
+			blockStatus[j] = outsideStatus[j];
+			if(outsideStatus[j] == MATH_SUCCESS) y[start + j] = outside[j];
+		}
+	}
+}
+
+/**
+ * Bound this function over a range of x, by bounding the outside
+ * function over the bounds of the inside function.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+CompositeFunction::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	Interval inside;
+	if(!m_Inside || !m_Outside) return MATH_UNDEFINED;
+
+	TMathResult status = m_Inside->CalculateInterval(x, &inside);
+	if(status != MATH_SUCCESS) return status;
+
+	status = m_Outside->CalculateInterval(inside, y);
+	if(status == MATH_SUCCESS && inside.MayBeUndefined())
+		y->SetMayBeUndefined(true);
+	return status;
+}
+
+/**
+ * Get the functions: outside, then inside.
+ * @param children (output) Operand functions.
+ */
+void
+CompositeFunction::GetChildren(
+	std::vector<MathFunction*> *children)
+{
+	children->clear();
+	children->push_back(m_Outside);
+	children->push_back(m_Inside);
+}
+
@@ -75,6 +75,86 @@ public:
 		double x,
 		double *y);
 
+	using MathOperation::CalculateYBlock;
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values. A linear
+	 * polynomial inside keeps the spacing, so the outside function is
+	 * sampled over the equally spaced values it gives; otherwise only
+	 * the inside function sees equally spaced points.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Get the functions: outside, then inside.
+	 * @param children (output) Operand functions.
+	 */
+	virtual void
+	GetChildren(
+		std::vector<MathFunction*> *children);
+
+protected:
+
+	/**
+	 * Sample the inside function at equally spaced x values, and pass
+	 * its results to the outside function as a block.
+	 */
+	void
+	SampleInside(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
 protected:
 	/**
 	 * Functions to be combined, as m_Outside( m_inside );
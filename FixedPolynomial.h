@@ -0,0 +1,256 @@
+/**
+ * Title: FixedPolynomial
+ * Polynomial whose degree is fixed when it is compiled.
+ * @author Mary Wyllie
+ */
+
+#ifndef FIXEDPOLYNOMIAL_H
+#define FIXEDPOLYNOMIAL_H
+
+#include "MathOperation.h"
+#include "Polynomial.h"
+#include <vector>
+
+/**
+ * Horner's rule for the coefficients from K up, unrolled by the
+ * compiler: FixedHorner<N, 0>::Evaluate is
+ * (...(c[N] x + c[N-1]) x + ...) x + c[0] with no loop.
+ */
+template <int N, int K>
+struct
+FixedHorner
+{
+	template <class T>
+	static inline T
+	Evaluate(
+		const T *c,
+		T x)
+		{ return FixedHorner<N, K + 1>::Evaluate(c, x) * x + c[K]; };
+};
+
+template <int N>
+struct
+FixedHorner<N, N>
+{
+	template <class T>
+	static inline T
+	Evaluate(
+		const T *c,
+		T)
+		{ return c[N]; };
+};
+
+/**
+ * Class for a polynomial of degree N, known when compiled. The
+ * coefficients are held in the object rather than on the heap, and
+ * Horner's rule is unrolled, so evaluating it has no loop or memory
+ * indirection; calibration curves of a set degree are the intended
+ * use. It is a MATH_POLYNOMIAL like Polynomial, and is given to a
+ * MathFunction as an operation:
+ *
+ *	double coefficients[4] = {1, 2, 3, 4};
+ *	MathFunction cubic(new FixedPolynomial<3>(coefficients));
+ *
+ * The coefficients cannot be changed once it is built.
+ */
+template <int N>
+class
+FixedPolynomial :
+	public MathOperation
+{
+public:
+
+	/**
+	 * Constructor. Every coefficient is 0.
+	 */
+	FixedPolynomial()
+	{
+		m_Operator = MATH_POLYNOMIAL;
+		for(int i = 0; i <= N; i++)
+		{
+			m_Coefficients[i] = 0;
+			m_FloatCoefficients[i] = 0;
+		}
+	};
+
+	/**
+	 * Constructor.
+	 * @param coefficients (input) N + 1 coefficients, lowest power first.
+	 */
+	FixedPolynomial(
+		const double *coefficients)
+	{
+		m_Operator = MATH_POLYNOMIAL;
+		for(int i = 0; i <= N; i++)
+		{
+			m_Coefficients[i] = coefficients[i];
+			m_FloatCoefficients[i] = (float) coefficients[i];
+		}
+	};
+
+	/**
+	 * Constructor.
+	 * @param coefficients (input) Coefficients, lowest power first.
+	 * Missing coefficients are 0 and extra ones are ignored.
+	 */
+	FixedPolynomial(
+		const std::vector<double>& coefficients)
+	{
+		m_Operator = MATH_POLYNOMIAL;
+		for(int i = 0; i <= N; i++)
+		{
+			m_Coefficients[i] = (i < (int) coefficients.size()) ? coefficients[i] : 0;
+			m_FloatCoefficients[i] = (float) m_Coefficients[i];
+		}
+	};
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~FixedPolynomial()
+		{};
+
+	/**
+	 * Calculate the value of the polynomial.
+	 * @param x (input) x input value.
+	 * @return Polynomial value at x.
+	 */
+	inline double
+	Evaluate(
+		double x) const
+		{ return FixedHorner<N, 0>::Evaluate(m_Coefficients, x); };
+
+	/**
+	 * Virtual function to calculate a point for this function.
+	 * @param x (input) x input value for this function.
+	 * @return Y value corresponding to the x input.
+	 */
+	virtual TMathResult
+	CalculateY(
+		double x,
+		double *y)
+	{
+		*y = Evaluate(x);
+		return MATH_SUCCESS;
+	};
+
+	/**
+	 * Calculate a block of points, the unrolled Horner's rule applied
+	 * across the block.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count)
+		{ EvaluateBlock(m_Coefficients, x, y, status, count); };
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count)
+		{ EvaluateBlock(m_FloatCoefficients, x, y, status, count); };
+
+	/**
+	 * Calculate points at equally spaced x values by forward
+	 * differences (see Polynomial::SampleUniform).
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count)
+	{
+		Polynomial::EvaluateUniform(m_Coefficients, N + 1, xStart, step,
+			y, status, count);
+	};
+
+	/**
+	 * Bound this function over a range of x (see
+	 * Polynomial::EvaluateInterval).
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) for every x in the range.
+	 * @return MATH_SUCCESS
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y)
+	{
+		Polynomial::EvaluateInterval(m_Coefficients, N + 1, x, y);
+		return MATH_SUCCESS;
+	};
+
+	/**
+	 * Constants are the coefficients, lowest power first.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return N + 1; };
+
+	/**
+	 * Get a coefficient.
+	 * @param i (input) Power of x.
+	 * @return Coefficient value.
+	 */
+	virtual double
+	GetConstant(
+		int i)
+		{ return m_Coefficients[i]; };
+
+protected:
+
+	/**
+	 * Polynomial at a block of points for either scalar type.
+	 */
+	template <class T>
+	static void
+	EvaluateBlock(
+		const T *coefficients,
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count)
+	{
+		#pragma omp simd
+		for(int i = 0; i < count; i++)
+		{
+			y[i] = FixedHorner<N, 0>::Evaluate(coefficients, x[i]);
+		}
+		for(int i = 0; i < count; i++) status[i] = MATH_SUCCESS;
+	};
+
+protected:
+	double m_Coefficients[N + 1];
+
+	//------------------------------------------
+	// Rounded once when built, for the float
+	// block kernel.
+	//------------------------------------------
+	float m_FloatCoefficients[N + 1];
+};
+
+#endif
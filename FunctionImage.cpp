@@ -0,0 +1,1139 @@
+/**
+ * Title: FunctionImage
+ * Flat binary form of a set of function graphs.
+ * @author Mary Wyllie
+ */
+
+#include "FunctionImage.h"
+#include "SimpleOperator.h"
+#include "Polynomial.h"
+#include "TrigFunction.h"
+#include "LogFunction.h"
+#include "NaryOperator.h"
+#include "Spline.h"
+#include "Transform.h"
+#include "MathKernels.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MATH_IMAGE_MAGIC[4] = {'M', 'F', 'I', 'M'};
+static const int32_t MATH_IMAGE_BYTE_ORDER = 0x01020304;
+
+/**
+ * Round a byte count up to a multiple of 8, so sections of doubles
+ * stay aligned.
+ */
+static int32_t
+AlignImageOffset(int32_t offset)
+{
+	return (offset + 7) & ~7;
+}
+
+/**
+ * Check that a section of count elements of a given size lies inside
+ * the image and is aligned for its elements.
+ */
+static bool
+IsImageSection(
+	const TImageHeader *header,
+	int32_t offset,
+	int32_t count,
+	size_t elementSize,
+	size_t alignment)
+{
+	if(count < 0 || offset < (int32_t) sizeof(TImageHeader)) return false;
+	if(offset % alignment) return false;
+	return((size_t) offset + (size_t) count * elementSize <=
+		(size_t) header->m_Size);
+}
+
+/**
+ * Constructor.
+ */
+FunctionImage::FunctionImage() :
+	m_Header(NULL),
+	m_Settings(NULL),
+	m_Nodes(NULL),
+	m_Links(NULL),
+	m_Roots(NULL),
+	m_Constants(NULL),
+	m_Parameters(NULL),
+	m_Bindings(NULL),
+	m_Map(NULL),
+	m_MapSize(0)
+{
+}
+
+/**
+ * Destructor.
+ */
+FunctionImage::~FunctionImage()
+{
+	Clear();
+}
+
+/**
+ * Discard the image.
+ */
+void
+FunctionImage::Clear()
+{
+#ifndef _WIN32
+	if(m_Map) munmap(m_Map, m_MapSize);
+#endif
+	m_Map = NULL;
+	m_MapSize = 0;
+	m_Buffer.clear();
+	m_Plans.clear();
+
+	m_Header = NULL;
+	m_Settings = NULL;
+	m_Nodes = NULL;
+	m_Links = NULL;
+	m_Roots = NULL;
+	m_Constants = NULL;
+	m_Parameters = NULL;
+	m_Bindings = NULL;
+}
+
+/**
+ * Build an image of a set of functions and everything they are
+ * made from. Any previous image is discarded.
+ * @param functions (input) Functions to store, in index order.
+ * @return False if a function has no operation.
+ */
+bool
+FunctionImage::Build(
+	const std::vector<MathFunction*>& functions)
+{
+	return Build(functions, std::vector<TFunctionParameter>());
+}
+
+/**
+ * Build an image of a set of functions with some of their constants
+ * as named parameters. Any previous image is discarded.
+ * @param functions (input) Functions to store, in index order.
+ * @param parameters (input) Constants to name.
+ * @return False if a function or parameter cannot be stored.
+ */
+bool
+FunctionImage::Build(
+	const std::vector<MathFunction*>& functions,
+	const std::vector<TFunctionParameter>& parameters)
+{
+	bool isValid = true;
+	std::vector<int32_t> roots;
+
+	Clear();
+	for(size_t i = 0; i < functions.size() && isValid; i++)
+	{
+		int32_t node = AddNode(functions[i]);
+		roots.push_back(node);
+		isValid = (node >= 0);
+	}
+	for(size_t i = 0; i < parameters.size() && isValid; i++)
+	{
+		isValid = AddParameter(parameters[i]);
+	}
+
+	//---------------------------------------
+	// Lay out the sections one after another.
+	//---------------------------------------
+	TImageHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_Magic, MATH_IMAGE_MAGIC, sizeof(header.m_Magic));
+	header.m_Version = MATH_IMAGE_VERSION;
+	header.m_ByteOrder = MATH_IMAGE_BYTE_ORDER;
+	header.m_SettingCount = (int32_t) m_BuildSettingData.size();
+	header.m_NodeCount = (int32_t) m_BuildNodes.size();
+	header.m_LinkCount = (int32_t) m_BuildLinks.size();
+	header.m_RootCount = (int32_t) roots.size();
+	header.m_ConstantCount = (int32_t) m_BuildConstants.size();
+	header.m_ParameterCount = (int32_t) m_BuildParameters.size();
+	header.m_BindingCount = (int32_t) m_BuildBindings.size();
+
+	header.m_SettingOffset = AlignImageOffset(sizeof(TImageHeader));
+	header.m_NodeOffset = AlignImageOffset(header.m_SettingOffset +
+		header.m_SettingCount * sizeof(TImageSetting));
+	header.m_LinkOffset = AlignImageOffset(header.m_NodeOffset +
+		header.m_NodeCount * sizeof(TImageNode));
+	header.m_RootOffset = AlignImageOffset(header.m_LinkOffset +
+		header.m_LinkCount * sizeof(int32_t));
+	header.m_ConstantOffset = AlignImageOffset(header.m_RootOffset +
+		header.m_RootCount * sizeof(int32_t));
+	header.m_ParameterOffset = AlignImageOffset(header.m_ConstantOffset +
+		header.m_ConstantCount * sizeof(double));
+	header.m_BindingOffset = AlignImageOffset(header.m_ParameterOffset +
+		header.m_ParameterCount * sizeof(TImageParameter));
+	header.m_Size = AlignImageOffset(header.m_BindingOffset +
+		header.m_BindingCount * sizeof(TImageBinding));
+
+	if(isValid)
+	{
+		m_Buffer.assign(header.m_Size / sizeof(double), 0);
+		char *data = (char*) &m_Buffer[0];
+
+		memcpy(data, &header, sizeof(header));
+		if(header.m_SettingCount)
+			memcpy(data + header.m_SettingOffset, &m_BuildSettingData[0],
+				header.m_SettingCount * sizeof(TImageSetting));
+		if(header.m_NodeCount)
+			memcpy(data + header.m_NodeOffset, &m_BuildNodes[0],
+				header.m_NodeCount * sizeof(TImageNode));
+		if(header.m_LinkCount)
+			memcpy(data + header.m_LinkOffset, &m_BuildLinks[0],
+				header.m_LinkCount * sizeof(int32_t));
+		if(header.m_RootCount)
+			memcpy(data + header.m_RootOffset, &roots[0],
+				header.m_RootCount * sizeof(int32_t));
+		if(header.m_ConstantCount)
+			memcpy(data + header.m_ConstantOffset, &m_BuildConstants[0],
+				header.m_ConstantCount * sizeof(double));
+		if(header.m_ParameterCount)
+			memcpy(data + header.m_ParameterOffset, &m_BuildParameters[0],
+				header.m_ParameterCount * sizeof(TImageParameter));
+		if(header.m_BindingCount)
+			memcpy(data + header.m_BindingOffset, &m_BuildBindings[0],
+				header.m_BindingCount * sizeof(TImageBinding));
+
+		isValid = Attach(data, header.m_Size);
+	}
+
+	m_BuildSettings.clear();
+	m_BuildFunctions.clear();
+	m_BuildSettingData.clear();
+	m_BuildNodes.clear();
+	m_BuildLinks.clear();
+	m_BuildConstants.clear();
+	m_BuildParameters.clear();
+	m_BuildBindings.clear();
+	if(!isValid) Clear();
+	return isValid;
+}
+
+/**
+ * Add a function and everything it is made from to the arrays
+ * being built. Children are added first, so every node links only
+ * to nodes before it.
+ * @return Node index, -1 if the function cannot be stored.
+ */
+int
+FunctionImage::AddNode(
+	MathFunction *function)
+{
+	if(!function) return -1;
+
+	std::map<MathFunction*, int32_t>::iterator found =
+		m_BuildFunctions.find(function);
+	if(found != m_BuildFunctions.end()) return found->second;
+
+	MathOperation *operation = function->GetMathOperation();
+	if(!operation) return -1;
+
+	std::vector<MathFunction*> children;
+	std::vector<int32_t> links;
+	operation->GetChildren(&children);
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		int32_t link = -1;
+		if(children[i])
+		{
+			link = AddNode(children[i]);
+			if(link < 0) return -1;
+		}
+		links.push_back(link);
+	}
+
+	TImageNode node;
+	node.m_Type = operation->GetOperatorType();
+	node.m_Setting = -1;
+	node.m_FirstLink = (int32_t) m_BuildLinks.size();
+	node.m_LinkCount = (int32_t) links.size();
+	node.m_FirstConstant = (int32_t) m_BuildConstants.size();
+	node.m_ConstantCount = operation->GetConstantCount();
+
+	MathSetting *setting = operation->GetMathSetting();
+	if(setting)
+	{
+		std::map<MathSetting*, int32_t>::iterator known =
+			m_BuildSettings.find(setting);
+		if(known == m_BuildSettings.end())
+		{
+			TImageSetting data;
+			data.m_Epsilon = setting->GetEpsilon();
+			data.m_IsDegrees = setting->GetAngleMode() ? 1 : 0;
+			data.m_Reserved = 0;
+			known = m_BuildSettings.insert(std::make_pair(setting,
+				(int32_t) m_BuildSettingData.size())).first;
+			m_BuildSettingData.push_back(data);
+		}
+		node.m_Setting = known->second;
+	}
+
+	m_BuildLinks.insert(m_BuildLinks.end(), links.begin(), links.end());
+	for(int i = 0; i < node.m_ConstantCount; i++)
+	{
+		m_BuildConstants.push_back(operation->GetConstant(i));
+	}
+
+	int32_t index = (int32_t) m_BuildNodes.size();
+	m_BuildNodes.push_back(node);
+	m_BuildFunctions[function] = index;
+	return index;
+}
+
+/**
+ * Add a named parameter to the arrays being built. A name already
+ * added is the same parameter, bound to one more constant.
+ * @return False if the name is too long, the function is not part of
+ * the image or the constant cannot be changed.
+ */
+bool
+FunctionImage::AddParameter(
+	const TFunctionParameter& parameter)
+{
+	if(!parameter.m_Name ||
+		strlen(parameter.m_Name) >= (size_t) MATH_PARAMETER_NAME_SIZE)
+		return false;
+
+	std::map<MathFunction*, int32_t>::iterator found =
+		m_BuildFunctions.find(parameter.m_Function);
+	if(found == m_BuildFunctions.end()) return false;
+
+	//-----------------------------------------------
+	// A spline's knots and coefficients are fitted
+	// together, so none of them can change alone.
+	//-----------------------------------------------
+	const TImageNode& node = m_BuildNodes[found->second];
+	if(node.m_Type == MATH_SPLINE) return false;
+	if(parameter.m_Constant < 0 || parameter.m_Constant >= node.m_ConstantCount)
+		return false;
+
+	TImageBinding binding;
+	binding.m_Constant = node.m_FirstConstant + parameter.m_Constant;
+	binding.m_Parameter = -1;
+	for(size_t i = 0; i < m_BuildParameters.size(); i++)
+	{
+		if(strcmp(m_BuildParameters[i].m_Name, parameter.m_Name) == 0)
+			binding.m_Parameter = (int32_t) i;
+	}
+	if(binding.m_Parameter < 0)
+	{
+		TImageParameter data;
+		memset(&data, 0, sizeof(data));
+		strcpy(data.m_Name, parameter.m_Name);
+		data.m_Value = m_BuildConstants[binding.m_Constant];
+		binding.m_Parameter = (int32_t) m_BuildParameters.size();
+		m_BuildParameters.push_back(data);
+	}
+	m_BuildBindings.push_back(binding);
+	return true;
+}
+
+/**
+ * Write the image to a file.
+ * @param path (input) File name.
+ * @return False if the file could not be written.
+ */
+bool
+FunctionImage::Write(
+	const char *path) const
+{
+	if(!m_Header || !path) return false;
+
+	FILE *file = fopen(path, "wb");
+	if(!file) return false;
+
+	size_t written = fwrite(m_Header, 1, m_Header->m_Size, file);
+	bool isWritten = (written == (size_t) m_Header->m_Size);
+	if(fclose(file) != 0) isWritten = false;
+	return isWritten;
+}
+
+/**
+ * Load an image from a file written by Write. Any previous image
+ * is discarded. The file is mapped read only and used in place.
+ * @param path (input) File name.
+ * @return False if the file could not be read or is not a valid
+ * image of this version.
+ */
+bool
+FunctionImage::Load(
+	const char *path)
+{
+	Clear();
+	if(!path) return false;
+
+#ifndef _WIN32
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(TImageHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+		fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) return false;
+
+	m_Map = map;
+	m_MapSize = (size_t) info.st_size;
+	if(!Attach((const char*) m_Map, m_MapSize))
+	{
+		Clear();
+		return false;
+	}
+	return true;
+#else
+	//------------------------------------------
+	// No mapping available; read the file into
+	// the buffer instead.
+	//------------------------------------------
+	FILE *file = fopen(path, "rb");
+	if(!file) return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if(size < (long) sizeof(TImageHeader))
+	{
+		fclose(file);
+		return false;
+	}
+
+	m_Buffer.assign((size + sizeof(double) - 1) / sizeof(double), 0);
+	size_t read = fread(&m_Buffer[0], 1, size, file);
+	fclose(file);
+	if(read != (size_t) size || !Attach((const char*) &m_Buffer[0], size))
+	{
+		Clear();
+		return false;
+	}
+	return true;
+#endif
+}
+
+/**
+ * Check an image and point the section pointers into it.
+ * Every index in the image is checked here, so evaluation need not.
+ * @param data (input) Start of the image.
+ * @param size (input) Bytes available.
+ * @return False if the image is not valid.
+ */
+bool
+FunctionImage::Attach(
+	const char *data,
+	size_t size)
+{
+	const TImageHeader *header = (const TImageHeader*) data;
+
+	if(size < sizeof(TImageHeader)) return false;
+	if(memcmp(header->m_Magic, MATH_IMAGE_MAGIC, sizeof(header->m_Magic)))
+		return false;
+	if(header->m_Version != MATH_IMAGE_VERSION) return false;
+	if(header->m_ByteOrder != MATH_IMAGE_BYTE_ORDER) return false;
+	if(header->m_Size < 0 || (size_t) header->m_Size > size) return false;
+
+	if(!IsImageSection(header, header->m_SettingOffset,
+			header->m_SettingCount, sizeof(TImageSetting), 8) ||
+		!IsImageSection(header, header->m_NodeOffset,
+			header->m_NodeCount, sizeof(TImageNode), 4) ||
+		!IsImageSection(header, header->m_LinkOffset,
+			header->m_LinkCount, sizeof(int32_t), 4) ||
+		!IsImageSection(header, header->m_RootOffset,
+			header->m_RootCount, sizeof(int32_t), 4) ||
+		!IsImageSection(header, header->m_ConstantOffset,
+			header->m_ConstantCount, sizeof(double), 8) ||
+		!IsImageSection(header, header->m_ParameterOffset,
+			header->m_ParameterCount, sizeof(TImageParameter), 8) ||
+		!IsImageSection(header, header->m_BindingOffset,
+			header->m_BindingCount, sizeof(TImageBinding), 4))
+		return false;
+
+	const TImageNode *nodes =
+		(const TImageNode*) (data + header->m_NodeOffset);
+	const int32_t *links = (const int32_t*) (data + header->m_LinkOffset);
+	const int32_t *roots = (const int32_t*) (data + header->m_RootOffset);
+	const double *constants =
+		(const double*) (data + header->m_ConstantOffset);
+	const TImageParameter *parameters =
+		(const TImageParameter*) (data + header->m_ParameterOffset);
+	const TImageBinding *bindings =
+		(const TImageBinding*) (data + header->m_BindingOffset);
+	std::vector<bool> isFixed(header->m_ConstantCount, false);
+
+	for(int32_t i = 0; i < header->m_NodeCount; i++)
+	{
+		const TImageNode& node = nodes[i];
+		int32_t expectedLinks = 0;
+		int32_t expectedConstants = -1;
+
+		if(node.m_Setting < -1 || node.m_Setting >= header->m_SettingCount)
+			return false;
+		if(node.m_FirstLink < 0 || node.m_LinkCount < 0 ||
+			node.m_FirstLink > header->m_LinkCount - node.m_LinkCount)
+			return false;
+		if(node.m_FirstConstant < 0 || node.m_ConstantCount < 0 ||
+			node.m_FirstConstant > header->m_ConstantCount - node.m_ConstantCount)
+			return false;
+
+		//-----------------------------------------------
+		// Links must be to earlier nodes, which also
+		// rules out cycles.
+		//-----------------------------------------------
+		for(int32_t j = 0; j < node.m_LinkCount; j++)
+		{
+			int32_t link = links[node.m_FirstLink + j];
+			if(link < -1 || link >= i) return false;
+		}
+
+		switch(node.m_Type)
+		{
+		case MATH_ADD:
+		case MATH_SUBTRACT:
+		case MATH_MULTIPLY:
+		case MATH_DIVIDE:
+		case MATH_POWER:
+			expectedLinks = 2;
+			expectedConstants = 2;
+			break;
+		case MATH_POLYNOMIAL:
+			break;
+		case MATH_COMPOSITE:
+			expectedLinks = 2;
+			expectedConstants = 0;
+			break;
+		case MATH_SIN:
+		case MATH_COS:
+		case MATH_TAN:
+		case MATH_COT:
+		case MATH_SEC:
+		case MATH_CSC:
+			expectedConstants = 0;
+			break;
+		case MATH_LOG:
+		case MATH_LN:
+			expectedConstants = 1;
+			break;
+		case MATH_SUM:
+		case MATH_PRODUCT:
+			expectedLinks = node.m_ConstantCount;
+			break;
+		case MATH_MULADD:
+			expectedLinks = 3;
+			expectedConstants = 3;
+			break;
+		case MATH_SPLINE:
+			{
+				//---------------------------------------
+				// Knot count, inverse spacing, knots and
+				// four coefficients per segment.
+				//---------------------------------------
+				if(node.m_ConstantCount < 2) return false;
+				double knots = constants[node.m_FirstConstant];
+				if(!(knots >= 0 && knots < header->m_ConstantCount) ||
+					knots != floor(knots))
+					return false;
+				int32_t n = (int32_t) knots;
+				expectedConstants = 2 + n + ((n > 1) ? 4 * (n - 1) : 0);
+				for(int32_t j = 0; j < node.m_ConstantCount; j++)
+				{
+					isFixed[node.m_FirstConstant + j] = true;
+				}
+			}
+			break;
+		case MATH_TRANSFORM:
+			expectedLinks = 1;
+			expectedConstants = 4;
+			break;
+		default:
+			return false;
+		}
+		if(node.m_LinkCount != expectedLinks) return false;
+		if(expectedConstants >= 0 && node.m_ConstantCount != expectedConstants)
+			return false;
+	}
+
+	for(int32_t i = 0; i < header->m_RootCount; i++)
+	{
+		if(roots[i] < 0 || roots[i] >= header->m_NodeCount) return false;
+	}
+
+	for(int32_t i = 0; i < header->m_ParameterCount; i++)
+	{
+		if(!memchr(parameters[i].m_Name, 0, MATH_PARAMETER_NAME_SIZE))
+			return false;
+	}
+	for(int32_t i = 0; i < header->m_BindingCount; i++)
+	{
+		const TImageBinding& binding = bindings[i];
+		if(binding.m_Constant < 0 || binding.m_Constant >= header->m_ConstantCount ||
+			isFixed[binding.m_Constant])
+			return false;
+		if(binding.m_Parameter < 0 || binding.m_Parameter >= header->m_ParameterCount)
+			return false;
+	}
+
+	m_Header = header;
+	m_Settings = (const TImageSetting*) (data + header->m_SettingOffset);
+	m_Nodes = nodes;
+	m_Links = links;
+	m_Roots = roots;
+	m_Constants = constants;
+	m_Parameters = parameters;
+	m_Bindings = bindings;
+
+	m_Plans.resize(header->m_NodeCount + 1);
+	PreparePlans(m_Constants, &m_Plans[0]);
+	return true;
+}
+
+/**
+ * Get the name of a parameter.
+ * @param parameter (input) Index of the parameter.
+ * @return Name, or NULL if there is no such parameter.
+ */
+const char*
+FunctionImage::GetParameterName(
+	int parameter) const
+{
+	if(parameter < 0 || parameter >= GetParameterCount()) return NULL;
+	return m_Parameters[parameter].m_Name;
+}
+
+/**
+ * Get the value a parameter had when the image was built.
+ * @param parameter (input) Index of the parameter.
+ * @return Value, 0 if there is no such parameter.
+ */
+double
+FunctionImage::GetParameterValue(
+	int parameter) const
+{
+	if(parameter < 0 || parameter >= GetParameterCount()) return 0;
+	return m_Parameters[parameter].m_Value;
+}
+
+/**
+ * Find a parameter by name.
+ * @param name (input) Parameter name.
+ * @return Index of the parameter, -1 if there is none.
+ */
+int
+FunctionImage::FindParameter(
+	const char *name) const
+{
+	if(!name) return -1;
+	for(int i = 0; i < GetParameterCount(); i++)
+	{
+		if(strcmp(m_Parameters[i].m_Name, name) == 0) return i;
+	}
+	return -1;
+}
+
+/**
+ * Give the parameters values: copy the image's constants into the
+ * buffer, then write each bound constant with its parameter's value.
+ * @param parameters (input) GetParameterCount() values.
+ * @param constants (output) GetConstantCount() constants.
+ */
+void
+FunctionImage::BindParameters(
+	const double *parameters,
+	double *constants) const
+{
+	if(!m_Header) return;
+	if(m_Header->m_ConstantCount)
+		memcpy(constants, m_Constants, m_Header->m_ConstantCount * sizeof(double));
+	for(int32_t i = 0; i < m_Header->m_BindingCount; i++)
+	{
+		constants[m_Bindings[i].m_Constant] = parameters[m_Bindings[i].m_Parameter];
+	}
+}
+
+/**
+ * Calculate a point for one of the image's functions.
+ * @param function (input) Index of the function.
+ * @param x (input) x input value for this function.
+ * @param y (output) y output value for this function.
+ * @return TMathResult for successful calculation (or not).
+ */
+TMathResult
+FunctionImage::CalculateY(
+	int function,
+	double x,
+	double *y,
+	const double *constants) const
+{
+	if(function < 0 || function >= GetFunctionCount()) return MATH_UNDEFINED;
+	if(constants) return EvaluateNode(m_Roots[function], x, y, constants, NULL);
+	return EvaluateNode(m_Roots[function], x, y, m_Constants, &m_Plans[0]);
+}
+
+/**
+ * Calculate a block of points for one of the image's functions.
+ * @param function (input) Index of the function.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ * @param constants (optional input) Constants from BindParameters,
+ * or NULL for the image's own.
+ */
+void
+FunctionImage::CalculateYBlock(
+	int function,
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	for(int i = 0; i < count; i++)
+	{
+		status[i] = CalculateY(function, x[i], &y[i], constants);
+	}
+}
+
+/**
+ * Calculate a block of points for one of the image's functions in
+ * single precision, with the float kernels of MathKernels.h.
+ * @param function (input) Index of the function.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ * @param constants (optional input) Constants from BindParameters,
+ * or NULL for the image's own.
+ */
+void
+FunctionImage::CalculateYBlock(
+	int function,
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count,
+	const double *constants) const
+{
+	if(function < 0 || function >= GetFunctionCount())
+	{
+		for(int i = 0; i < count; i++) status[i] = MATH_UNDEFINED;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		EvaluateNodeBlock(m_Roots[function], x + start, y + start,
+			status + start, n, constants ? constants : m_Constants);
+	}
+}
+
+/**
+ * Work out the plan of every node for a set of constants: how each
+ * power is calculated and each log's change of base, as the block
+ * calculations would for every tile.
+ * @param image (input) Constants of the whole image.
+ * @param plans (output) One plan for each node.
+ */
+void
+FunctionImage::PreparePlans(
+	const double *image,
+	TImagePlan *plans) const
+{
+	for(int32_t index = 0; index < m_Header->m_NodeCount; index++)
+	{
+		const TImageNode& node = m_Nodes[index];
+		const int32_t *links = m_Links + node.m_FirstLink;
+		const double *constants = image + node.m_FirstConstant;
+		TImagePlan& plan = plans[index];
+
+		plan.m_Power = SimpleOperator::ChoosePower(NULL, NULL);
+		plan.m_LogScale = 1;
+		plan.m_IsLogDefined = true;
+
+		switch(node.m_Type)
+		{
+		case MATH_ADD:
+		case MATH_SUBTRACT:
+		case MATH_MULTIPLY:
+		case MATH_DIVIDE:
+		case MATH_POWER:
+			plan.m_Power = SimpleOperator::ChoosePower(
+				(links[0] < 0) ? &constants[0] : NULL,
+				(links[1] < 0) ? &constants[1] : NULL);
+			break;
+		case MATH_LOG:
+		case MATH_LN:
+			{
+				double epsilon = (node.m_Setting >= 0) ?
+					m_Settings[node.m_Setting].m_Epsilon : GetGlobalEpsilon();
+				plan.m_IsLogDefined = !(constants[0] < 0 ||
+					KernelIsWithin(constants[0], 0.0, epsilon));
+				if(node.m_Type == MATH_LOG) plan.m_LogScale = 1.0 / log(constants[0]);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/**
+ * Evaluate one node. Each type follows its MathOperation's
+ * CalculateY, using the same static helpers. Powers take their
+ * strategy from the node's plan when there is one.
+ */
+TMathResult
+FunctionImage::EvaluateNode(
+	int index,
+	double x,
+	double *y,
+	const double *image,
+	const TImagePlan *plans) const
+{
+	const TImageNode& node = m_Nodes[index];
+	const int32_t *links = m_Links + node.m_FirstLink;
+	const double *constants = image + node.m_FirstConstant;
+	TMathResult status = MATH_SUCCESS;
+
+	double epsilon = GetGlobalEpsilon();
+	bool isDegrees = GetGlobalAngleMode();
+	if(node.m_Setting >= 0)
+	{
+		epsilon = m_Settings[node.m_Setting].m_Epsilon;
+		isDegrees = (m_Settings[node.m_Setting].m_IsDegrees != 0);
+	}
+
+	switch(node.m_Type)
+	{
+	case MATH_ADD:
+	case MATH_SUBTRACT:
+	case MATH_MULTIPLY:
+	case MATH_DIVIDE:
+	case MATH_POWER:
+		{
+			double left = constants[0], right = constants[1];
+			if(links[0] >= 0) status = EvaluateNode(links[0], x, &left, image, plans);
+			if(status == MATH_SUCCESS && links[1] >= 0)
+				status = EvaluateNode(links[1], x, &right, image, plans);
+			if(status != MATH_SUCCESS) return status;
+			if(plans)
+				return SimpleOperator::Apply((TOperatorType) node.m_Type,
+					left, right, epsilon, y, &plans[index].m_Power);
+			TPowerStrategy power = SimpleOperator::ChoosePower(
+				(links[0] < 0) ? &constants[0] : NULL,
+				(links[1] < 0) ? &constants[1] : NULL);
+			return SimpleOperator::Apply((TOperatorType) node.m_Type,
+				left, right, epsilon, y, &power);
+		}
+	case MATH_POLYNOMIAL:
+		*y = Polynomial::Evaluate(constants, node.m_ConstantCount, x);
+		return MATH_SUCCESS;
+	case MATH_COMPOSITE:
+		{
+			double inside = 0;
+			if(links[1] < 0 || links[0] < 0) return MATH_UNDEFINED;
+			status = EvaluateNode(links[1], x, &inside, image, plans);
+			if(status != MATH_SUCCESS) return status;
+			return EvaluateNode(links[0], inside, y, image, plans);
+		}
+	case MATH_SIN:
+	case MATH_COS:
+	case MATH_TAN:
+	case MATH_COT:
+	case MATH_SEC:
+	case MATH_CSC:
+		return TrigFunction::Evaluate((TOperatorType) node.m_Type,
+			KernelAngle(isDegrees, x), epsilon, y);
+	case MATH_LOG:
+	case MATH_LN:
+		return LogFunction::Evaluate((TOperatorType) node.m_Type,
+			constants[0], epsilon, x, y);
+	case MATH_SUM:
+	case MATH_PRODUCT:
+	case MATH_MULADD:
+		{
+			double buffer[MATH_BLOCK_SIZE];
+			std::vector<double> more;
+			double *values = buffer;
+			if(node.m_LinkCount > MATH_BLOCK_SIZE)
+			{
+				more.resize(node.m_LinkCount);
+				values = &more[0];
+			}
+			for(int32_t i = 0; i < node.m_LinkCount; i++)
+			{
+				values[i] = 1;
+				if(links[i] >= 0 && EvaluateNode(links[i], x, &values[i], image, plans) != MATH_SUCCESS)
+					return MATH_UNDEFINED;
+			}
+			*y = NaryOperator::Evaluate((TOperatorType) node.m_Type, values,
+				constants, node.m_LinkCount);
+			return MATH_SUCCESS;
+		}
+	case MATH_SPLINE:
+		return Spline::Evaluate(constants, x, y);
+	case MATH_TRANSFORM:
+		{
+			double inside = 0;
+			if(links[0] < 0) return MATH_UNDEFINED;
+			status = EvaluateNode(links[0], constants[0] * x + constants[1], &inside,
+				image, plans);
+			if(status == MATH_SUCCESS) *y = constants[2] * inside + constants[3];
+			return status;
+		}
+	}
+	return MATH_UNDEFINED;
+}
+
+/**
+ * Evaluate one node at up to MATH_BLOCK_SIZE points, with the block
+ * kernels for the scalar type. Children are evaluated into buffers
+ * on the stack, so the depth of the stack follows the depth of the
+ * function. With a cache, nodes it keeps which are evaluated at the
+ * cache's tile of x are calculated once per tile.
+ */
+template <class T>
+void
+FunctionImage::EvaluateNodeBlock(
+	int index,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count,
+	const double *image,
+	TImageCache<T> *cache) const
+{
+	if(!cache || x != cache->m_X || cache->m_Slots[index] < 0)
+	{
+		CalculateNodeBlock(index, x, y, status, count, image, cache);
+		return;
+	}
+
+	//-----------------------------------------------
+	// A shared node at the tile's own x: calculated
+	// the first time it is needed, then copied.
+	//-----------------------------------------------
+	int32_t slot = cache->m_Slots[index];
+	T *values = &cache->m_Values[slot * MATH_BLOCK_SIZE];
+	TMathResult *valueStatus = &cache->m_Status[slot * MATH_BLOCK_SIZE];
+	if(cache->m_Tiles[slot] != cache->m_Tile)
+	{
+		CalculateNodeBlock(index, x, values, valueStatus, count, image, cache);
+		cache->m_Tiles[slot] = cache->m_Tile;
+	}
+	for(int j = 0; j < count; j++)
+	{
+		status[j] = valueStatus[j];
+		if(valueStatus[j] == MATH_SUCCESS) y[j] = values[j];
+	}
+}
+
+/**
+ * Calculate one node at up to MATH_BLOCK_SIZE points from its
+ * children, which are evaluated through the cache.
+ */
+template <class T>
+void
+FunctionImage::CalculateNodeBlock(
+	int index,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count,
+	const double *image,
+	TImageCache<T> *cache) const
+{
+	const TImageNode& node = m_Nodes[index];
+	const int32_t *links = m_Links + node.m_FirstLink;
+	const double *constants = image + node.m_FirstConstant;
+	TOperatorType type = (TOperatorType) node.m_Type;
+
+	double epsilon = GetGlobalEpsilon();
+	bool isDegrees = GetGlobalAngleMode();
+	if(node.m_Setting >= 0)
+	{
+		epsilon = m_Settings[node.m_Setting].m_Epsilon;
+		isDegrees = (m_Settings[node.m_Setting].m_IsDegrees != 0);
+	}
+
+	switch(type)
+	{
+	case MATH_ADD:
+	case MATH_SUBTRACT:
+	case MATH_MULTIPLY:
+	case MATH_DIVIDE:
+	case MATH_POWER:
+		{
+			T left[MATH_BLOCK_SIZE], right[MATH_BLOCK_SIZE];
+			TMathResult rightStatus[MATH_BLOCK_SIZE];
+
+			if(links[0] >= 0)
+			{
+				EvaluateNodeBlock(links[0], x, left, status, count, image, cache);
+			}
+			else
+			{
+				for(int j = 0; j < count; j++)
+				{
+					left[j] = (T) constants[0];
+					status[j] = MATH_SUCCESS;
+				}
+			}
+
+			if(links[1] >= 0)
+			{
+				EvaluateNodeBlock(links[1], x, right, rightStatus, count, image, cache);
+				for(int j = 0; j < count; j++)
+				{
+					if(rightStatus[j] != MATH_SUCCESS) status[j] = MATH_UNDEFINED;
+				}
+			}
+			else
+			{
+				for(int j = 0; j < count; j++) right[j] = (T) constants[1];
+			}
+
+			TPowerStrategy power = (cache && cache->m_Plans) ?
+				cache->m_Plans[index].m_Power :
+				SimpleOperator::ChoosePower(
+					(links[0] < 0) ? &constants[0] : NULL,
+					(links[1] < 0) ? &constants[1] : NULL);
+			KernelApplyBlock(type, (T) epsilon, left, right, y, status, count,
+				&power);
+			return;
+		}
+	case MATH_POLYNOMIAL:
+		KernelPolynomialBlock(constants, node.m_ConstantCount, x, y,
+			status, count);
+		return;
+	case MATH_COMPOSITE:
+		if(links[0] >= 0 && links[1] >= 0)
+		{
+			T inside[MATH_BLOCK_SIZE], outside[MATH_BLOCK_SIZE];
+			TMathResult outsideStatus[MATH_BLOCK_SIZE];
+
+			EvaluateNodeBlock(links[1], x, inside, status, count, image, cache);
+			for(int j = 0; j < count; j++)
+			{
+				if(status[j] != MATH_SUCCESS) inside[j] = 0;
+			}
+			EvaluateNodeBlock(links[0], inside, outside, outsideStatus, count, image, cache);
+			for(int j = 0; j < count; j++)
+			{
+				if(status[j] != MATH_SUCCESS) continue;
+				status[j] = outsideStatus[j];
+				if(status[j] == MATH_SUCCESS) y[j] = outside[j];
+			}
+			return;
+		}
+		break;
+	case MATH_SIN:
+	case MATH_COS:
+	case MATH_TAN:
+	case MATH_COT:
+	case MATH_SEC:
+	case MATH_CSC:
+		KernelTrigBlock(type, isDegrees, (T) epsilon, x, y, status, count);
+		return;
+	case MATH_LOG:
+	case MATH_LN:
+		if(cache && cache->m_Plans)
+			KernelLogScaledBlock((T) cache->m_Plans[index].m_LogScale,
+				cache->m_Plans[index].m_IsLogDefined, (T) epsilon, x, y,
+				status, count);
+		else
+			KernelLogBlock(type, constants[0], (T) epsilon, x, y, status, count);
+		return;
+	case MATH_SUM:
+	case MATH_PRODUCT:
+	case MATH_MULADD:
+		{
+			T values[MATH_BLOCK_SIZE], factor[MATH_BLOCK_SIZE];
+			T result[MATH_BLOCK_SIZE], ones[MATH_BLOCK_SIZE];
+			TMathResult termStatus[MATH_BLOCK_SIZE];
+
+			for(int j = 0; j < count; j++)
+			{
+				result[j] = (type == MATH_PRODUCT) ? 1 : 0;
+				ones[j] = 1;
+				status[j] = MATH_SUCCESS;
+			}
+			for(int32_t i = 0; i < node.m_LinkCount; i++)
+			{
+				const T *operand = ones;
+				if(links[i] >= 0)
+				{
+					EvaluateNodeBlock(links[i], x, values, termStatus, count, image, cache);
+					for(int j = 0; j < count; j++)
+					{
+						if(termStatus[j] != MATH_SUCCESS) status[j] = MATH_UNDEFINED;
+					}
+					operand = values;
+				}
+				KernelNaryStep(type, i, (T) constants[i], operand, result,
+					factor, count);
+			}
+			for(int j = 0; j < count; j++)
+			{
+				if(status[j] == MATH_SUCCESS) y[j] = result[j];
+			}
+			return;
+		}
+	case MATH_SPLINE:
+		KernelSplineBlock(constants, x, y, status, count);
+		return;
+	case MATH_TRANSFORM:
+		if(links[0] >= 0)
+		{
+			T inside[MATH_BLOCK_SIZE], outside[MATH_BLOCK_SIZE];
+			T a = (T) constants[0], b = (T) constants[1];
+			T c = (T) constants[2], d = (T) constants[3];
+
+			for(int j = 0; j < count; j++) inside[j] = a * x[j] + b;
+			EvaluateNodeBlock(links[0], inside, outside, status, count, image, cache);
+			for(int j = 0; j < count; j++)
+			{
+				if(status[j] == MATH_SUCCESS) y[j] = c * outside[j] + d;
+			}
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	for(int j = 0; j < count; j++) status[j] = MATH_UNDEFINED;
+}
+
+template void
+FunctionImage::EvaluateNodeBlock<double>(
+	int index,
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count,
+	const double *image,
+	TImageCache<double> *cache) const;
+
+template void
+FunctionImage::EvaluateNodeBlock<float>(
+	int index,
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count,
+	const double *image,
+	TImageCache<float> *cache) const;
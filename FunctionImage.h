@@ -0,0 +1,485 @@
+/**
+ * Title: FunctionImage
+ * Flat binary form of a set of function graphs.
+ * @author Mary Wyllie
+ */
+
+#ifndef FUNCTIONIMAGE_H
+#define FUNCTIONIMAGE_H
+
+#include "MathFunction.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+/**
+ * Image format version. Increase when the layout below changes.
+ */
+const int32_t MATH_IMAGE_VERSION = 2;
+
+/**
+ * Image file header. Each section is an array starting at the given
+ * byte offset from the start of the image.
+ */
+typedef struct TImageHeader
+{
+	char m_Magic[4];            // "MFIM"
+	int32_t m_Version;          // MATH_IMAGE_VERSION
+	int32_t m_ByteOrder;        // 0x01020304 as written
+	int32_t m_Size;             // Total bytes in the image.
+	int32_t m_SettingCount;
+	int32_t m_SettingOffset;    // TImageSetting[]
+	int32_t m_NodeCount;
+	int32_t m_NodeOffset;       // TImageNode[]
+	int32_t m_LinkCount;
+	int32_t m_LinkOffset;       // int32_t[] node indices, -1 for none
+	int32_t m_RootCount;
+	int32_t m_RootOffset;       // int32_t[] node indices
+	int32_t m_ConstantCount;
+	int32_t m_ConstantOffset;   // double[]
+	int32_t m_ParameterCount;
+	int32_t m_ParameterOffset;  // TImageParameter[]
+	int32_t m_BindingCount;
+	int32_t m_BindingOffset;    // TImageBinding[]
+} TImageHeader;
+
+/**
+ * Epsilon and angle mode of a MathSetting.
+ */
+typedef struct TImageSetting
+{
+	double m_Epsilon;
+	int32_t m_IsDegrees;
+	int32_t m_Reserved;
+} TImageSetting;
+
+/**
+ * Longest parameter name, with its terminating zero.
+ */
+const int MATH_PARAMETER_NAME_SIZE = 32;
+
+/**
+ * A named parameter, and its value as built.
+ */
+typedef struct TImageParameter
+{
+	char m_Name[MATH_PARAMETER_NAME_SIZE];
+	double m_Value;
+} TImageParameter;
+
+/**
+ * A constant which takes the value of a parameter.
+ */
+typedef struct TImageBinding
+{
+	int32_t m_Constant;         // Index into the constants.
+	int32_t m_Parameter;        // Parameter index.
+} TImageBinding;
+
+/**
+ * A constant of a function to be built as a named parameter, as
+ * MathOperation::GetConstant numbers them. Constants named alike are
+ * one parameter.
+ */
+typedef struct TFunctionParameter
+{
+	const char *m_Name;
+	MathFunction *m_Function;
+	int32_t m_Constant;
+} TFunctionParameter;
+
+/**
+ * One MathFunction. Links are the operation's children and constants
+ * its constants, both in the order the operation lists them (see
+ * MathOperation::GetChildren and GetConstant). Nodes only link to
+ * nodes before them, and a node linked from several places is stored
+ * once.
+ */
+typedef struct TImageNode
+{
+	int32_t m_Type;             // TOperatorType
+	int32_t m_Setting;          // Setting index, -1 for global settings.
+	int32_t m_FirstLink;
+	int32_t m_LinkCount;
+	int32_t m_FirstConstant;
+	int32_t m_ConstantCount;
+} TImageNode;
+
+/**
+ * Values of a node which depend only on its constants, worked out
+ * once for a set of constants instead of for every tile (see
+ * ParameterSweep).
+ */
+typedef struct TImagePlan
+{
+	TPowerStrategy m_Power;     // Binary operators.
+	double m_LogScale;          // Logs: 1 for ln, 1 / ln(base) otherwise.
+	bool m_IsLogDefined;        // Logs: the base is defined.
+} TImagePlan;
+
+/**
+ * Results of the nodes shared between functions, kept for one tile of
+ * up to MATH_BLOCK_SIZE points so that each is calculated once however
+ * many functions use it (see BatchEvaluator). A node's results are
+ * kept only where it is evaluated at the tile's own x values, not at
+ * the values of an inside function.
+ */
+template <class T>
+struct TImageCache
+{
+	const T *m_X;                      // Tile of x values.
+	int32_t m_Tile;                    // Changed for every tile.
+	std::vector<int32_t> m_Slots;      // Slot of each node, -1 if not kept.
+	std::vector<int32_t> m_Tiles;      // Tile each slot was calculated for.
+	std::vector<T> m_Values;           // MATH_BLOCK_SIZE values per slot.
+	std::vector<TMathResult> m_Status; // MATH_BLOCK_SIZE results per slot.
+	const TImagePlan *m_Plans;         // Plan of each node, NULL if none.
+};
+
+/**
+ * A set of functions stored as flat arrays of nodes, links and
+ * constants, which can be written to a file and loaded back without
+ * constructing any MathFunction objects. A loaded image is mapped
+ * into memory and evaluated where it lies, so loading costs little
+ * more than reading the pages that are used.
+ *
+ * An image is built from existing functions with Build, or read with
+ * Load. Either way its functions are then evaluated by index with
+ * CalculateY, with the same results as the functions it was built
+ * from. Settings are captured as they were when built; nodes without
+ * a setting use the global settings at the time of evaluation.
+ *
+ * Constants may be built as named parameters, such as the exponent
+ * of a power, a polynomial coefficient or a log base, and given new
+ * values without building again. BindParameters writes the image's
+ * constants with a set of parameter values into one buffer, which
+ * the calculations then read in place of the image's own:
+ *
+ *	std::vector<double> constants(image.GetConstantCount());
+ *	image.BindParameters(values, &constants[0]);
+ *	image.CalculateY(0, x, &y, &constants[0]);
+ *
+ * The buffer is reused for each set of values, and several buffers
+ * may be evaluated at once from different threads.
+ */
+class
+FunctionImage :
+	public MathBase
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	FunctionImage();
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~FunctionImage();
+
+	/**
+	 * Build an image of a set of functions and everything they are
+	 * made from. Any previous image is discarded.
+	 * @param functions (input) Functions to store, in index order.
+	 * @return False if a function has no operation.
+	 */
+	bool
+	Build(
+		const std::vector<MathFunction*>& functions);
+
+	/**
+	 * Build an image of a set of functions with some of their
+	 * constants as named parameters. Any previous image is discarded.
+	 * @param functions (input) Functions to store, in index order.
+	 * @param parameters (input) Constants to name. Parameters are
+	 * numbered in order of their first appearance here.
+	 * @return False if a function has no operation, or a parameter's
+	 * name is too long, its function is not part of the image or its
+	 * constant cannot be changed (the knots of a spline).
+	 */
+	bool
+	Build(
+		const std::vector<MathFunction*>& functions,
+		const std::vector<TFunctionParameter>& parameters);
+
+	/**
+	 * Write the image to a file.
+	 * @param path (input) File name.
+	 * @return False if the file could not be written.
+	 */
+	bool
+	Write(
+		const char *path) const;
+
+	/**
+	 * Load an image from a file written by Write. Any previous image
+	 * is discarded.
+	 * @param path (input) File name.
+	 * @return False if the file could not be read or is not a valid
+	 * image of this version.
+	 */
+	bool
+	Load(
+		const char *path);
+
+	/**
+	 * Discard the image.
+	 */
+	void
+	Clear();
+
+	/**
+	 * Get the number of functions in the image.
+	 * @return Function count.
+	 */
+	int
+	GetFunctionCount() const
+		{return m_Header ? m_Header->m_RootCount : 0;};
+
+	/**
+	 * Get the number of constants in the image, the size of the
+	 * buffer BindParameters fills.
+	 * @return Constant count.
+	 */
+	int
+	GetConstantCount() const
+		{return m_Header ? m_Header->m_ConstantCount : 0;};
+
+	/**
+	 * Get the number of named parameters.
+	 * @return Parameter count.
+	 */
+	int
+	GetParameterCount() const
+		{return m_Header ? m_Header->m_ParameterCount : 0;};
+
+	/**
+	 * Get the name of a parameter.
+	 * @param parameter (input) Index of the parameter.
+	 * @return Name, or NULL if there is no such parameter.
+	 */
+	const char*
+	GetParameterName(
+		int parameter) const;
+
+	/**
+	 * Get the value a parameter had when the image was built.
+	 * @param parameter (input) Index of the parameter.
+	 * @return Value, 0 if there is no such parameter.
+	 */
+	double
+	GetParameterValue(
+		int parameter) const;
+
+	/**
+	 * Find a parameter by name.
+	 * @param name (input) Parameter name.
+	 * @return Index of the parameter, -1 if there is none.
+	 */
+	int
+	FindParameter(
+		const char *name) const;
+
+	/**
+	 * Give the parameters values, writing the image's constants with
+	 * those values bound into a buffer for the calculations.
+	 * @param parameters (input) GetParameterCount() values, in index
+	 * order.
+	 * @param constants (output) GetConstantCount() constants.
+	 */
+	void
+	BindParameters(
+		const double *parameters,
+		double *constants) const;
+
+	/**
+	 * Calculate a point for one of the image's functions.
+	 * @param function (input) Index of the function.
+	 * @param x (input) x input value for this function.
+	 * @param y (output) y output value for this function.
+	 * @param constants (optional input) Constants from BindParameters,
+	 * or NULL for the image's own.
+	 * @return TMathResult for successful calculation (or not).
+	 */
+	TMathResult
+	CalculateY(
+		int function,
+		double x,
+		double *y,
+		const double *constants = NULL) const;
+
+	/**
+	 * Calculate a block of points for one of the image's functions.
+	 * @param function (input) Index of the function.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 * @param constants (optional input) Constants from BindParameters,
+	 * or NULL for the image's own.
+	 */
+	void
+	CalculateYBlock(
+		int function,
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count,
+		const double *constants = NULL) const;
+
+	/**
+	 * Calculate a block of points for one of the image's functions in
+	 * single precision, with the float kernels of MathKernels.h.
+	 * @param function (input) Index of the function.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 * @param constants (optional input) Constants from BindParameters,
+	 * or NULL for the image's own.
+	 */
+	void
+	CalculateYBlock(
+		int function,
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count,
+		const double *constants = NULL) const;
+
+protected:
+
+	/**
+	 * Add a function and everything it is made from to the arrays
+	 * being built.
+	 * @return Node index, -1 if the function cannot be stored.
+	 */
+	int
+	AddNode(
+		MathFunction *function);
+
+	/**
+	 * Add a named parameter to the arrays being built, after the
+	 * function it is a constant of.
+	 * @return False if the parameter cannot be stored.
+	 */
+	bool
+	AddParameter(
+		const TFunctionParameter& parameter);
+
+	/**
+	 * Check an image and point the section pointers into it.
+	 * @param data (input) Start of the image.
+	 * @param size (input) Bytes available.
+	 * @return False if the image is not valid.
+	 */
+	bool
+	Attach(
+		const char *data,
+		size_t size);
+
+	/**
+	 * Work out the plan of every node for a set of constants.
+	 * @param image (input) Constants of the whole image.
+	 * @param plans (output) One plan for each node.
+	 */
+	void
+	PreparePlans(
+		const double *image,
+		TImagePlan *plans) const;
+
+	/**
+	 * Evaluate one node.
+	 * @param image (input) Constants of the whole image.
+	 * @param plans (input) Plans of the nodes for these constants, or
+	 * NULL to work each one out as it is used.
+	 */
+	TMathResult
+	EvaluateNode(
+		int node,
+		double x,
+		double *y,
+		const double *image,
+		const TImagePlan *plans) const;
+
+	/**
+	 * Evaluate one node at up to MATH_BLOCK_SIZE points.
+	 * @param image (input) Constants of the whole image.
+	 * @param cache (optional input/output) Results of shared nodes
+	 * for the tile x and plans of the nodes, or NULL.
+	 */
+	template <class T>
+	void
+	EvaluateNodeBlock(
+		int node,
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count,
+		const double *image,
+		TImageCache<T> *cache = NULL) const;
+
+	/**
+	 * Calculate one node at up to MATH_BLOCK_SIZE points, without
+	 * looking in the cache for the node itself.
+	 */
+	template <class T>
+	void
+	CalculateNodeBlock(
+		int node,
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count,
+		const double *image,
+		TImageCache<T> *cache) const;
+
+protected:
+
+	//--------------------------------------------
+	// Sections of the current image, NULL if none.
+	//--------------------------------------------
+	const TImageHeader *m_Header;
+	const TImageSetting *m_Settings;
+	const TImageNode *m_Nodes;
+	const int32_t *m_Links;
+	const int32_t *m_Roots;
+	const double *m_Constants;
+	const TImageParameter *m_Parameters;
+	const TImageBinding *m_Bindings;
+
+	//-------------------------------------------
+	// Plan of each node for the image's own
+	// constants, worked out when it is attached.
+	//-------------------------------------------
+	std::vector<TImagePlan> m_Plans;
+
+	//-----------------------------------------------
+	// Storage of a built image, or of a loaded image
+	// where files cannot be mapped.
+	//-----------------------------------------------
+	std::vector<double> m_Buffer;
+
+	//-------------------------
+	// Mapping of a loaded file.
+	//-------------------------
+	void *m_Map;
+	size_t m_MapSize;
+
+	//------------------------------------
+	// Work arrays used only while building.
+	//------------------------------------
+	std::map<MathSetting*, int32_t> m_BuildSettings;
+	std::map<MathFunction*, int32_t> m_BuildFunctions;
+	std::vector<TImageSetting> m_BuildSettingData;
+	std::vector<TImageNode> m_BuildNodes;
+	std::vector<int32_t> m_BuildLinks;
+	std::vector<double> m_BuildConstants;
+	std::vector<TImageParameter> m_BuildParameters;
+	std::vector<TImageBinding> m_BuildBindings;
+};
+
+#endif
@@ -0,0 +1,798 @@
+/**
+ * Title: FunctionParser
+ * Builds MathFunction trees from text.
+ * @author Mary Wyllie
+ */
+
+#include "FunctionParser.h"
+#include "SimpleOperator.h"
+#include "Polynomial.h"
+#include "LogFunction.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+
+//--------------------------------------------------
+// Operator precedence. Unary minus binds tighter
+// than * and / but looser than ^, so -x^2 is -(x^2).
+//--------------------------------------------------
+static const int PRECEDENCE_ADD = 1;
+static const int PRECEDENCE_MULTIPLY = 2;
+static const int PRECEDENCE_UNARY = 3;
+static const int PRECEDENCE_POWER = 4;
+
+/**
+ * Deepest nesting of brackets and signs allowed.
+ */
+static const int MAX_DEPTH = 256;
+
+/**
+ * Is the identifier of the given length the given name?
+ */
+static bool
+IsName(
+	const char *start,
+	size_t length,
+	const char *name)
+{
+	return(strlen(name) == length && strncmp(start, name, length) == 0);
+}
+
+static bool
+IsNameStart(char c)
+{
+	return(isalpha((unsigned char) c) || c == '_');
+}
+
+static void
+SkipSpace(
+	TParseState *state)
+{
+	while(isspace((unsigned char) *state->m_Next)) state->m_Next++;
+}
+
+/**
+ * Set a value to a constant.
+ */
+static void
+SetConstant(
+	TParseValue *value,
+	double constant)
+{
+	value->m_Kind = MATH_PARSE_CONSTANT;
+	value->m_Constant = constant;
+	value->m_Coefficients.clear();
+	value->m_Function = NULL;
+}
+
+/**
+ * Get the coefficients of a constant or polynomial value.
+ */
+static void
+GetCoefficients(
+	TParseValue *value,
+	std::vector<double> *coefficients)
+{
+	if(value->m_Kind == MATH_PARSE_CONSTANT)
+		coefficients->assign(1, value->m_Constant);
+	else
+		coefficients->swap(value->m_Coefficients);
+}
+
+/**
+ * Set a value to a polynomial, dropping zero high order terms.
+ * A polynomial of degree 0 becomes a constant.
+ */
+static void
+SetPolynomial(
+	TParseValue *value,
+	std::vector<double> *coefficients)
+{
+	while(coefficients->size() > 1 && coefficients->back() == 0)
+		coefficients->pop_back();
+
+	if(coefficients->size() <= 1)
+	{
+		SetConstant(value, coefficients->empty() ? 0 : (*coefficients)[0]);
+		return;
+	}
+	value->m_Kind = MATH_PARSE_POLYNOMIAL;
+	value->m_Coefficients.swap(*coefficients);
+	value->m_Function = NULL;
+}
+
+/**
+ * Constructor.
+ * @param setting (optional input) setting (optional epsilon/angleMode)
+ * given to each parsed function.
+ */
+FunctionParser::FunctionParser(
+	MathSetting *setting) :
+	MathBase(setting),
+	m_ErrorPosition(-1)
+{
+}
+
+/**
+ * Destructor. Deletes every function parsed.
+ */
+FunctionParser::~FunctionParser()
+{
+	Clear();
+}
+
+/**
+ * Delete every function parsed so far.
+ */
+void
+FunctionParser::Clear()
+{
+	for(size_t i = 0; i < m_Functions.size(); i++)
+	{
+		delete m_Functions[i];
+	}
+	m_Functions.clear();
+}
+
+/**
+ * Parse an expression.
+ * @param text (input) Expression in x.
+ * @return Function, or NULL if the text is not a valid expression
+ * (see GetError and GetErrorPosition).
+ */
+MathFunction*
+FunctionParser::Parse(
+	const char *text)
+{
+	TParseState state;
+	state.m_Start = text ? text : "";
+	state.m_Next = state.m_Start;
+	state.m_ErrorPosition = -1;
+	state.m_Depth = 0;
+
+	MathFunction *result = ParseText(&state);
+
+	m_Error = state.m_Error;
+	m_ErrorPosition = state.m_ErrorPosition;
+	m_Functions.insert(m_Functions.end(),
+		state.m_Nodes.begin(), state.m_Nodes.end());
+	return(result);
+}
+
+/**
+ * Parse many expressions in parallel.
+ * @param texts (input) Expressions in x.
+ * @param results (output) Function for each expression, NULL where
+ * an expression is not valid.
+ * @param errors (optional output) Error message for each
+ * expression, empty where it is valid.
+ * @return Number of expressions parsed successfully.
+ */
+int
+FunctionParser::ParseCatalog(
+	const std::vector<std::string>& texts,
+	std::vector<MathFunction*> *results,
+	std::vector<std::string> *errors)
+{
+	int count = (int) texts.size();
+	int parsed = 0;
+
+	results->assign(count, NULL);
+	if(errors) errors->assign(count, std::string());
+
+	#pragma omp parallel for schedule(dynamic, 16) reduction(+:parsed)
+	for(int i = 0; i < count; i++)
+	{
+		TParseState state;
+		state.m_Start = texts[i].c_str();
+		state.m_Next = state.m_Start;
+		state.m_ErrorPosition = -1;
+		state.m_Depth = 0;
+
+		MathFunction *result = ParseText(&state);
+		(*results)[i] = result;
+		if(result)
+		{
+			parsed++;
+			#pragma omp critical(FunctionParserNodes)
+			m_Functions.insert(m_Functions.end(),
+				state.m_Nodes.begin(), state.m_Nodes.end());
+		}
+		else if(errors)
+		{
+			char position[32];
+			sprintf(position, " at position %d", state.m_ErrorPosition);
+			(*errors)[i] = state.m_Error + position;
+		}
+	}
+	return(parsed);
+}
+
+/**
+ * Parse a catalog file of one expression per line, in parallel.
+ * Blank lines and lines starting with '#' are skipped.
+ * @param path (input) File name.
+ * @param results (output) Function for each expression, NULL where
+ * an expression is not valid.
+ * @param errors (optional output) Error message for each
+ * expression, empty where it is valid.
+ * @return Number of expressions parsed successfully, -1 if the file
+ * could not be read.
+ */
+int
+FunctionParser::ParseCatalogFile(
+	const char *path,
+	std::vector<MathFunction*> *results,
+	std::vector<std::string> *errors)
+{
+	std::ifstream file(path);
+	if(!file) return(-1);
+
+	std::vector<std::string> texts;
+	std::string line;
+	while(std::getline(file, line))
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if(first == std::string::npos || line[first] == '#') continue;
+		texts.push_back(line);
+	}
+	return(ParseCatalog(texts, results, errors));
+}
+
+/**
+ * Parse a complete expression into a state. On error, every node
+ * created for the expression is deleted.
+ * @return Function, or NULL on error.
+ */
+MathFunction*
+FunctionParser::ParseText(
+	TParseState *state) const
+{
+	TParseValue value;
+	MathFunction *result = NULL;
+
+	if(ParseExpression(state, PRECEDENCE_ADD, &value))
+	{
+		SkipSpace(state);
+		if(*state->m_Next == ')')
+			SetError(state, "unmatched ')'", state->m_Next);
+		else if(*state->m_Next)
+			SetError(state, "unexpected character", state->m_Next);
+		else
+			result = MakeFunction(state, &value);
+	}
+
+	if(!result)
+	{
+		for(size_t i = 0; i < state->m_Nodes.size(); i++)
+		{
+			delete state->m_Nodes[i];
+		}
+		state->m_Nodes.clear();
+	}
+	return(result);
+}
+
+/**
+ * Parse an expression whose binary operators bind at least as
+ * tightly as the given precedence. Operators of equal precedence
+ * group to the left, except ^ which groups to the right.
+ */
+bool
+FunctionParser::ParseExpression(
+	TParseState *state,
+	int minPrecedence,
+	TParseValue *value) const
+{
+	if(++state->m_Depth > MAX_DEPTH)
+		return(SetError(state, "expression nested too deeply", state->m_Next));
+
+	if(!ParseUnary(state, value)) return(false);
+
+	while(true)
+	{
+		SkipSpace(state);
+		const char *position = state->m_Next;
+		TOperatorType type;
+		int precedence;
+		bool isImplied = false;
+
+		switch(*position)
+		{
+		case '+':
+			type = MATH_ADD;
+			precedence = PRECEDENCE_ADD;
+			break;
+		case '-':
+			type = MATH_SUBTRACT;
+			precedence = PRECEDENCE_ADD;
+			break;
+		case '*':
+			type = MATH_MULTIPLY;
+			precedence = PRECEDENCE_MULTIPLY;
+			break;
+		case '/':
+			type = MATH_DIVIDE;
+			precedence = PRECEDENCE_MULTIPLY;
+			break;
+		case '^':
+			type = MATH_POWER;
+			precedence = PRECEDENCE_POWER;
+			break;
+		default:
+			//----------------------------------------------
+			// A name or bracket straight after a value is
+			// an implied multiplication, as in 2x or 3(x+1).
+			//----------------------------------------------
+			if(!IsNameStart(*position) && *position != '(')
+			{
+				state->m_Depth--;
+				return(true);
+			}
+			type = MATH_MULTIPLY;
+			precedence = PRECEDENCE_MULTIPLY;
+			isImplied = true;
+			break;
+		}
+
+		if(precedence < minPrecedence)
+		{
+			state->m_Depth--;
+			return(true);
+		}
+		if(!isImplied) state->m_Next++;
+
+		TParseValue rhs;
+		int rhsPrecedence = (type == MATH_POWER) ? precedence : precedence + 1;
+		if(!ParseExpression(state, rhsPrecedence, &rhs)) return(false);
+		if(!ApplyOperator(state, type, value, &rhs, position)) return(false);
+	}
+}
+
+/**
+ * Parse a number, name, function call or bracketed expression,
+ * with any leading signs.
+ */
+bool
+FunctionParser::ParseUnary(
+	TParseState *state,
+	TParseValue *value) const
+{
+	SkipSpace(state);
+	char sign = *state->m_Next;
+	if(sign != '-' && sign != '+') return(ParsePrimary(state, value));
+
+	state->m_Next++;
+	if(!ParseExpression(state, PRECEDENCE_UNARY, value)) return(false);
+	if(sign == '+') return(true);
+
+	switch(value->m_Kind)
+	{
+	case MATH_PARSE_CONSTANT:
+		value->m_Constant = -value->m_Constant;
+		break;
+	case MATH_PARSE_POLYNOMIAL:
+		for(size_t i = 0; i < value->m_Coefficients.size(); i++)
+		{
+			value->m_Coefficients[i] = -value->m_Coefficients[i];
+		}
+		break;
+	case MATH_PARSE_FUNCTION:
+		value->m_Function = AddNode(state,
+			new MathFunction(MATH_MULTIPLY, -1.0, value->m_Function));
+		break;
+	}
+	return(true);
+}
+
+/**
+ * Parse a number, name, function call or bracketed expression.
+ */
+bool
+FunctionParser::ParsePrimary(
+	TParseState *state,
+	TParseValue *value) const
+{
+	SkipSpace(state);
+	const char *start = state->m_Next;
+	const char *p = start;
+
+	//----------------------------------------------------
+	// Number. Find where it ends first, so strtod cannot
+	// read forms the grammar does not allow (hex, inf).
+	//----------------------------------------------------
+	if(isdigit((unsigned char) *p) || *p == '.')
+	{
+		while(isdigit((unsigned char) *p)) p++;
+		if(*p == '.') p++;
+		while(isdigit((unsigned char) *p)) p++;
+		if(*p == 'e' || *p == 'E')
+		{
+			const char *exponent = p + 1;
+			if(*exponent == '+' || *exponent == '-') exponent++;
+			if(isdigit((unsigned char) *exponent))
+			{
+				p = exponent;
+				while(isdigit((unsigned char) *p)) p++;
+			}
+		}
+
+		char buffer[64];
+		size_t length = (size_t) (p - start);
+		if(length == 1 && *start == '.' )
+			return(SetError(state, "invalid number", start));
+		if(length >= sizeof(buffer))
+			return(SetError(state, "number too long", start));
+		memcpy(buffer, start, length);
+		buffer[length] = '\0';
+
+		SetConstant(value, strtod(buffer, NULL));
+		state->m_Next = p;
+		return(true);
+	}
+
+	//---------------------
+	// Bracketed expression.
+	//---------------------
+	if(*p == '(')
+	{
+		state->m_Next++;
+		if(!ParseExpression(state, PRECEDENCE_ADD, value)) return(false);
+		SkipSpace(state);
+		if(*state->m_Next != ')')
+			return(SetError(state, "expected ')'", state->m_Next));
+		state->m_Next++;
+		return(true);
+	}
+
+	if(!IsNameStart(*p))
+	{
+		if(*p == '\0')
+			return(SetError(state, "unexpected end of expression", p));
+		return(SetError(state, "expected a value", p));
+	}
+
+	//-------------------------
+	// Variable or constant.
+	//-------------------------
+	while(IsNameStart(*p) || isdigit((unsigned char) *p)) p++;
+	size_t length = (size_t) (p - start);
+	state->m_Next = p;
+
+	if(IsName(start, length, "x"))
+	{
+		value->m_Kind = MATH_PARSE_POLYNOMIAL;
+		value->m_Coefficients.assign(2, 0);
+		value->m_Coefficients[1] = 1;
+		value->m_Function = NULL;
+		return(true);
+	}
+	if(IsName(start, length, "pi") || IsName(start, length, "MATH_PI"))
+	{
+		SetConstant(value, MATH_PI);
+		return(true);
+	}
+	if(IsName(start, length, "MATH_2PI"))
+	{
+		SetConstant(value, MATH_2PI);
+		return(true);
+	}
+	if(IsName(start, length, "e") || IsName(start, length, "MATH_E"))
+	{
+		SetConstant(value, MATH_E);
+		return(true);
+	}
+
+	//-----------
+	// Functions.
+	//-----------
+	TOperatorType type = MATH_POWER;
+	double base = 0;
+
+	if(IsName(start, length, "sin")) type = MATH_SIN;
+	else if(IsName(start, length, "cos")) type = MATH_COS;
+	else if(IsName(start, length, "tan")) type = MATH_TAN;
+	else if(IsName(start, length, "cot")) type = MATH_COT;
+	else if(IsName(start, length, "sec")) type = MATH_SEC;
+	else if(IsName(start, length, "csc")) type = MATH_CSC;
+	else if(IsName(start, length, "ln"))
+	{
+		type = MATH_LN;
+		base = MATH_E;
+	}
+	else if(IsName(start, length, "exp"))
+	{
+		type = MATH_POWER;
+		base = MATH_E;
+	}
+	else if(length >= 3 && strncmp(start, "log", 3) == 0)
+	{
+		//---------------------------------
+		// log is base 10, logN is base N.
+		//---------------------------------
+		type = MATH_LOG;
+		base = 10;
+		if(length > 3)
+		{
+			for(const char *d = start + 3; d < p; d++)
+			{
+				if(!isdigit((unsigned char) *d))
+					return(SetError(state, "unknown name", start));
+			}
+			base = strtod(start + 3, NULL);
+			if(base <= 0 || base == 1)
+				return(SetError(state, "invalid log base", start));
+		}
+	}
+	else
+	{
+		return(SetError(state, "unknown name", start));
+	}
+
+	SkipSpace(state);
+	if(*state->m_Next != '(')
+		return(SetError(state, "expected '(' after function name", state->m_Next));
+	state->m_Next++;
+
+	TParseValue argument;
+	if(!ParseExpression(state, PRECEDENCE_ADD, &argument)) return(false);
+	SkipSpace(state);
+	if(*state->m_Next != ')')
+		return(SetError(state, "expected ')'", state->m_Next));
+	state->m_Next++;
+
+	if(!ApplyFunction(state, type, base, &argument)) return(false);
+	*value = argument;
+	return(true);
+}
+
+/**
+ * Combine two values with a binary operator. Constants are folded,
+ * polynomial arithmetic stays polynomial, and anything else becomes
+ * a function node. The result replaces lhs.
+ */
+bool
+FunctionParser::ApplyOperator(
+	TParseState *state,
+	TOperatorType type,
+	TParseValue *lhs,
+	TParseValue *rhs,
+	const char *position) const
+{
+	//----------------
+	// Constant folding.
+	//----------------
+	if(lhs->m_Kind == MATH_PARSE_CONSTANT && rhs->m_Kind == MATH_PARSE_CONSTANT)
+	{
+		double result;
+		if(SimpleOperator::Apply(type, lhs->m_Constant, rhs->m_Constant,
+			GetEpsilon(), &result) != MATH_SUCCESS)
+		{
+			return(SetError(state, "undefined constant expression", position));
+		}
+		lhs->m_Constant = result;
+		return(true);
+	}
+
+	//---------------------------------------------------
+	// Polynomial arithmetic, where the result is still a
+	// polynomial.
+	//---------------------------------------------------
+	if(lhs->m_Kind != MATH_PARSE_FUNCTION && rhs->m_Kind != MATH_PARSE_FUNCTION)
+	{
+		std::vector<double> a, b, result;
+		bool isPolynomial = true;
+
+		switch(type)
+		{
+		case MATH_ADD:
+		case MATH_SUBTRACT:
+			GetCoefficients(lhs, &a);
+			GetCoefficients(rhs, &b);
+			if(type == MATH_ADD)
+				Polynomial::Add(a, b, &result);
+			else
+				Polynomial::Subtract(a, b, &result);
+			break;
+		case MATH_MULTIPLY:
+			GetCoefficients(lhs, &a);
+			GetCoefficients(rhs, &b);
+			Polynomial::Multiply(a, b, &result);
+			break;
+		case MATH_DIVIDE:
+			if(rhs->m_Kind != MATH_PARSE_CONSTANT)
+			{
+				isPolynomial = false;
+				break;
+			}
+			if(IsEqual(rhs->m_Constant, 0))
+				return(SetError(state, "division by zero", position));
+			GetCoefficients(lhs, &result);
+			for(size_t i = 0; i < result.size(); i++)
+			{
+				result[i] /= rhs->m_Constant;
+			}
+			break;
+		case MATH_POWER:
+		{
+			//-------------------------------------------
+			// Only small whole powers expand in place.
+			//-------------------------------------------
+			double n = rhs->m_Constant;
+			int degree = (int) lhs->m_Coefficients.size() - 1;
+			if(rhs->m_Kind != MATH_PARSE_CONSTANT || n < 0 ||
+				n != floor(n) || n * degree > MATH_POLYNOMIAL_MAX_DEGREE)
+			{
+				isPolynomial = false;
+				break;
+			}
+			GetCoefficients(lhs, &a);
+			Polynomial::Power(a, (int) n, &result);
+			break;
+		}
+		default:
+			isPolynomial = false;
+			break;
+		}
+
+		if(isPolynomial)
+		{
+			SetPolynomial(lhs, &result);
+			return(true);
+		}
+	}
+
+	//---------------------------------------------
+	// Function node. Constants stay as constants of
+	// the operator rather than becoming nodes.
+	//---------------------------------------------
+	MathFunction *function;
+	if(lhs->m_Kind == MATH_PARSE_CONSTANT)
+	{
+		function = new MathFunction(type, lhs->m_Constant,
+			MakeFunction(state, rhs));
+	}
+	else if(rhs->m_Kind == MATH_PARSE_CONSTANT)
+	{
+		function = new MathFunction(type, MakeFunction(state, lhs),
+			rhs->m_Constant);
+	}
+	else
+	{
+		MathFunction *left = MakeFunction(state, lhs);
+		function = new MathFunction(type, left, MakeFunction(state, rhs));
+	}
+
+	lhs->m_Kind = MATH_PARSE_FUNCTION;
+	lhs->m_Coefficients.clear();
+	lhs->m_Function = AddNode(state, function);
+	return(true);
+}
+
+/**
+ * Apply a trig, log or exp function to a value. exp is a power of e.
+ * Logs and exps of constants are folded; trig functions of constants
+ * are not, since their value depends on the angle mode when they are
+ * evaluated. The result replaces the argument.
+ */
+bool
+FunctionParser::ApplyFunction(
+	TParseState *state,
+	TOperatorType type,
+	double base,
+	TParseValue *argument) const
+{
+	if(argument->m_Kind == MATH_PARSE_CONSTANT)
+	{
+		double result;
+		TMathResult status = MATH_UNDEFINED;
+		if(type == MATH_POWER)
+			status = SimpleOperator::Apply(type, base, argument->m_Constant,
+				GetEpsilon(), &result);
+		else if(type == MATH_LOG || type == MATH_LN)
+			status = LogFunction::Evaluate(type, base, GetEpsilon(),
+				argument->m_Constant, &result);
+		else
+			status = MATH_SUCCESS;
+
+		if(status != MATH_SUCCESS)
+			return(SetError(state, "undefined constant expression", state->m_Next));
+		if(type == MATH_POWER || type == MATH_LOG || type == MATH_LN)
+		{
+			argument->m_Constant = result;
+			return(true);
+		}
+	}
+
+	MathFunction *function;
+	if(type == MATH_POWER)
+	{
+		function = new MathFunction(MATH_POWER, base,
+			MakeFunction(state, argument));
+	}
+	else
+	{
+		MathFunction *outside = (type == MATH_LOG || type == MATH_LN) ?
+			new MathFunction(type, base) : new MathFunction(type);
+
+		//---------------------------------------------
+		// Applied to x alone, the function is used as
+		// it is; otherwise it is composed.
+		//---------------------------------------------
+		bool isX = argument->m_Kind == MATH_PARSE_POLYNOMIAL &&
+			argument->m_Coefficients.size() == 2 &&
+			argument->m_Coefficients[0] == 0 &&
+			argument->m_Coefficients[1] == 1;
+		if(isX)
+		{
+			function = outside;
+		}
+		else
+		{
+			AddNode(state, outside);
+			function = new MathFunction(MATH_COMPOSITE, outside,
+				MakeFunction(state, argument));
+		}
+	}
+
+	argument->m_Kind = MATH_PARSE_FUNCTION;
+	argument->m_Coefficients.clear();
+	argument->m_Function = AddNode(state, function);
+	return(true);
+}
+
+/**
+ * Turn a value into a function node. Constants and polynomials
+ * become Polynomial nodes.
+ */
+MathFunction*
+FunctionParser::MakeFunction(
+	TParseState *state,
+	TParseValue *value) const
+{
+	if(value->m_Kind == MATH_PARSE_FUNCTION) return(value->m_Function);
+
+	std::vector<double> coefficients;
+	GetCoefficients(value, &coefficients);
+	value->m_Kind = MATH_PARSE_FUNCTION;
+	value->m_Function = AddNode(state,
+		new MathFunction(MATH_POLYNOMIAL, coefficients));
+	return(value->m_Function);
+}
+
+/**
+ * Keep a new function node, giving it the parser's setting.
+ */
+MathFunction*
+FunctionParser::AddNode(
+	TParseState *state,
+	MathFunction *function) const
+{
+	if(m_MathSetting)
+	{
+		function->SetEpsilon(GetEpsilon());
+		function->SetAngleMode(GetAngleMode());
+	}
+	state->m_Nodes.push_back(function);
+	return(function);
+}
+
+/**
+ * Record an error at a position. Only the first error is kept.
+ * @return False.
+ */
+bool
+FunctionParser::SetError(
+	TParseState *state,
+	const char *message,
+	const char *position) const
+{
+	if(state->m_ErrorPosition < 0)
+	{
+		state->m_Error = message;
+		state->m_ErrorPosition = (int) (position - state->m_Start);
+	}
+	return(false);
+}
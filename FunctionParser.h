@@ -0,0 +1,243 @@
+/**
+ * Title: FunctionParser
+ * Builds MathFunction trees from text.
+ * @author Mary Wyllie
+ */
+
+#ifndef FUNCTIONPARSER_H
+#define FUNCTIONPARSER_H
+
+#include "MathFunction.h"
+#include <string>
+#include <vector>
+
+/**
+ * Kind of value found while parsing. Constants and polynomials in x
+ * are kept as numbers until they have to become functions, so any
+ * polynomial part of an expression ends up as one Polynomial node.
+ */
+typedef enum TParseKind
+{
+	MATH_PARSE_CONSTANT = 0,
+	MATH_PARSE_POLYNOMIAL,
+	MATH_PARSE_FUNCTION
+} TParseKind;
+
+/**
+ * Value of a parsed sub-expression.
+ */
+typedef struct TParseValue
+{
+	TParseKind m_Kind;
+	double m_Constant;                  // MATH_PARSE_CONSTANT
+	std::vector<double> m_Coefficients; // MATH_PARSE_POLYNOMIAL
+	MathFunction *m_Function;           // MATH_PARSE_FUNCTION
+} TParseValue;
+
+/**
+ * State of one parse. Kept apart from the parser so that several
+ * expressions can be parsed at once.
+ */
+typedef struct TParseState
+{
+	const char *m_Start;
+	const char *m_Next;
+	std::string m_Error;
+	int m_ErrorPosition;
+	int m_Depth;                         // Current nesting.
+	std::vector<MathFunction*> m_Nodes;  // Functions created so far.
+} TParseState;
+
+/**
+ * Parser for functions of x written as text, e.g.
+ *
+ *	3*sin(2*pi*x - pi/2) + log2(x^2+1)
+ *
+ * Expressions may use + - * / ^ (right associative), unary minus,
+ * parentheses, implied multiplication ("2x", "3sin(x)"), numbers,
+ * the constants pi and e (also MATH_PI, MATH_2PI and MATH_E), and the
+ * functions sin cos tan cot sec csc, ln, log (base 10), logN for any
+ * numeric base N (e.g. log2), and exp.
+ *
+ * Arithmetic on constants is done while parsing, and sums, products,
+ * integer powers and constant quotients of polynomials in x collapse
+ * into a single Polynomial node. A function applied to x alone is a
+ * plain function node; applied to anything else it is a composite.
+ *
+ * The parser owns every function it creates and deletes them when it
+ * is cleared or destroyed. If a setting is given to the parser (or
+ * its epsilon or angle mode are set), parsed functions get their own
+ * copy of it; otherwise they use the global settings.
+ */
+class
+FunctionParser :
+	public MathBase
+{
+public:
+
+	/**
+	 * Constructor.
+	 * @param setting (optional input) setting (optional epsilon/angleMode)
+	 * given to each parsed function.
+	 */
+	FunctionParser(
+		MathSetting *setting = NULL);
+
+	/**
+	 * Destructor. Deletes every function parsed.
+	 */
+	virtual
+	~FunctionParser();
+
+	/**
+	 * Parse an expression.
+	 * @param text (input) Expression in x.
+	 * @return Function, or NULL if the text is not a valid expression
+	 * (see GetError and GetErrorPosition).
+	 */
+	MathFunction*
+	Parse(
+		const char *text);
+
+	/**
+	 * Parse many expressions in parallel.
+	 * @param texts (input) Expressions in x.
+	 * @param results (output) Function for each expression, NULL where
+	 * an expression is not valid.
+	 * @param errors (optional output) Error message for each
+	 * expression, empty where it is valid.
+	 * @return Number of expressions parsed successfully.
+	 */
+	int
+	ParseCatalog(
+		const std::vector<std::string>& texts,
+		std::vector<MathFunction*> *results,
+		std::vector<std::string> *errors = NULL);
+
+	/**
+	 * Parse a catalog file of one expression per line, in parallel.
+	 * Blank lines and lines starting with '#' are skipped.
+	 * @param path (input) File name.
+	 * @param results (output) Function for each expression, NULL where
+	 * an expression is not valid.
+	 * @param errors (optional output) Error message for each
+	 * expression, empty where it is valid.
+	 * @return Number of expressions parsed successfully, -1 if the file
+	 * could not be read.
+	 */
+	int
+	ParseCatalogFile(
+		const char *path,
+		std::vector<MathFunction*> *results,
+		std::vector<std::string> *errors = NULL);
+
+	/**
+	 * Get the error from the last call to Parse.
+	 * @return Error message, empty if none.
+	 */
+	const std::string&
+	GetError() const
+		{return m_Error;};
+
+	/**
+	 * Get the position of the error from the last call to Parse.
+	 * @return Character offset into the text, -1 if none.
+	 */
+	int
+	GetErrorPosition() const
+		{return m_ErrorPosition;};
+
+	/**
+	 * Delete every function parsed so far.
+	 */
+	void
+	Clear();
+
+protected:
+
+	/**
+	 * Parse a complete expression into a state.
+	 * @return Function, or NULL on error.
+	 */
+	MathFunction*
+	ParseText(
+		TParseState *state) const;
+
+	/**
+	 * Parse an expression whose binary operators bind at least as
+	 * tightly as the given precedence.
+	 */
+	bool
+	ParseExpression(
+		TParseState *state,
+		int minPrecedence,
+		TParseValue *value) const;
+
+	/**
+	 * Parse a number, name, function call or bracketed expression,
+	 * with any leading signs.
+	 */
+	bool
+	ParseUnary(
+		TParseState *state,
+		TParseValue *value) const;
+
+	bool
+	ParsePrimary(
+		TParseState *state,
+		TParseValue *value) const;
+
+	/**
+	 * Combine two values with a binary operator.
+	 */
+	bool
+	ApplyOperator(
+		TParseState *state,
+		TOperatorType type,
+		TParseValue *lhs,
+		TParseValue *rhs,
+		const char *position) const;
+
+	/**
+	 * Apply a trig, log or exp function to a value.
+	 */
+	bool
+	ApplyFunction(
+		TParseState *state,
+		TOperatorType type,
+		double base,
+		TParseValue *argument) const;
+
+	/**
+	 * Turn a value into a function node.
+	 */
+	MathFunction*
+	MakeFunction(
+		TParseState *state,
+		TParseValue *value) const;
+
+	/**
+	 * Keep a new function node, giving it the parser's setting.
+	 */
+	MathFunction*
+	AddNode(
+		TParseState *state,
+		MathFunction *function) const;
+
+	/**
+	 * Record an error at a position.
+	 * @return False.
+	 */
+	bool
+	SetError(
+		TParseState *state,
+		const char *message,
+		const char *position) const;
+
+protected:
+	std::vector<MathFunction*> m_Functions;
+	std::string m_Error;
+	int m_ErrorPosition;
+};
+
+#endif
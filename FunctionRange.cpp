@@ -0,0 +1,186 @@
+/**
+ * Title: FunctionRange
+ * Lazily evaluated sequence of points of a function over a range.
+ * @author Mary Wyllie
+ */
+
+#include "FunctionRange.h"
+
+/**
+ * Constructor.
+ * @param function (input) Function to evaluate.
+ * @param xStart (input) First x value.
+ * @param xEnd (input) Last x value.
+ * @param count (input) Number of points, including both ends.
+ */
+FunctionRange::FunctionRange(
+	MathFunction *function,
+	double xStart,
+	double xEnd,
+	long count) :
+	m_Function(function),
+	m_Start(xStart),
+	m_End(xEnd),
+	m_Count(count < 0 ? 0 : count)
+{
+}
+
+/**
+ * Destructor.
+ */
+FunctionRange::~FunctionRange()
+{
+}
+
+/**
+ * Add a stage to run after those already added.
+ * @param stage (input) Filter or transform for each sample.
+ * @return This range, so stages can be chained.
+ */
+FunctionRange&
+FunctionRange::AddStage(
+	SampleStage *stage)
+{
+	if(stage) m_Stages.push_back(stage);
+	return *this;
+}
+
+/**
+ * Get the x value of a point. Computed from the index rather than by
+ * repeated addition, so long ranges do not drift, and the last point
+ * is exactly the end of the range.
+ * @param i (input) Index of the point.
+ * @return X value.
+ */
+double
+FunctionRange::GetX(long i) const
+{
+	if(m_Count <= 1 || i == 0) return m_Start;
+	if(i == m_Count - 1) return m_End;
+	return m_Start + (m_End - m_Start) * ((double) i / (double) (m_Count - 1));
+}
+
+/**
+ * Constructor. A default iterator is the end of any range.
+ */
+FunctionRange::iterator::iterator() :
+	m_Range(NULL),
+	m_IsEnd(true),
+	m_BlockStart(0),
+	m_BlockCount(0),
+	m_Position(0)
+{
+}
+
+/**
+ * Constructor. Evaluates up to the first sample which passes every
+ * stage.
+ * @param range (input) Range to iterate.
+ */
+FunctionRange::iterator::iterator(
+	FunctionRange *range) :
+	m_Range(range),
+	m_IsEnd(false),
+	m_BlockStart(0),
+	m_BlockCount(0),
+	m_Position(-1)
+{
+	++(*this);
+}
+
+/**
+ * Evaluate the next block of points.
+ * @return False at the end of the range.
+ */
+bool
+FunctionRange::iterator::FillBlock()
+{
+	m_BlockStart += m_BlockCount;
+	m_Position = 0;
+
+	long remaining = m_Range->m_Count - m_BlockStart;
+	if(remaining <= 0 || !m_Range->m_Function)
+	{
+		m_BlockCount = 0;
+		return false;
+	}
+
+	m_BlockCount = (remaining < MATH_BLOCK_SIZE) ?
+		(int) remaining : MATH_BLOCK_SIZE;
+	for(int i = 0; i < m_BlockCount; i++)
+	{
+		m_X[i] = m_Range->GetX(m_BlockStart + i);
+		m_Y[i] = 0;
+	}
+
+	//------------------------------------------------
+	// The points are equally spaced, so the function
+	// may use the spacing (see SampleUniform). Each
+	// block starts again from its exact first x.
+	//------------------------------------------------
+	double step = (m_Range->m_Count > 1) ?
+		(m_Range->m_End - m_Range->m_Start) / (double) (m_Range->m_Count - 1) : 0;
+	m_Range->m_Function->SampleUniform(m_X[0], step, m_Y, m_Status, m_BlockCount);
+	return true;
+}
+
+/**
+ * Move to the next sample which passes every stage.
+ */
+FunctionRange::iterator&
+FunctionRange::iterator::operator++()
+{
+	if(m_IsEnd) return *this;
+
+	while(true)
+	{
+		m_Position++;
+		if(m_Position >= m_BlockCount && !FillBlock())
+		{
+			m_IsEnd = true;
+			return *this;
+		}
+
+		m_Sample.m_X = m_X[m_Position];
+		m_Sample.m_Y = m_Y[m_Position];
+		m_Sample.m_Status = m_Status[m_Position];
+
+		//------------------------------------------
+		// Run the stages; the first to reject the
+		// sample decides what happens to it.
+		//------------------------------------------
+		TStageResult result = MATH_STAGE_KEEP;
+		std::vector<SampleStage*>& stages = m_Range->m_Stages;
+		for(size_t i = 0; i < stages.size() && result == MATH_STAGE_KEEP; i++)
+		{
+			result = stages[i]->Process(&m_Sample);
+		}
+
+		if(result == MATH_STAGE_KEEP) return *this;
+		if(result == MATH_STAGE_STOP)
+		{
+			m_IsEnd = true;
+			return *this;
+		}
+	}
+}
+
+FunctionRange::iterator
+FunctionRange::iterator::operator++(int)
+{
+	iterator previous = *this;
+	++(*this);
+	return previous;
+}
+
+/**
+ * Iterators are equal at the same sample of the same range,
+ * or when both are at an end.
+ */
+bool
+FunctionRange::iterator::operator==(const iterator& rhs) const
+{
+	if(m_IsEnd || rhs.m_IsEnd) return (m_IsEnd == rhs.m_IsEnd);
+	return (m_Range == rhs.m_Range) &&
+		(m_BlockStart + m_Position == rhs.m_BlockStart + rhs.m_Position);
+}
@@ -0,0 +1,216 @@
+/**
+ * Title: FunctionRange
+ * Lazily evaluated sequence of points of a function over a range.
+ * @author Mary Wyllie
+ */
+
+#ifndef FUNCTIONRANGE_H
+#define FUNCTIONRANGE_H
+
+#include "MathFunction.h"
+#include <vector>
+
+/**
+ * One evaluated point of a function.
+ */
+typedef struct TFunctionSample
+{
+	double m_X;
+	double m_Y;
+	TMathResult m_Status;
+} TFunctionSample;
+
+/**
+ * What a stage decides to do with a sample.
+ */
+typedef enum TStageResult
+{
+	MATH_STAGE_KEEP = 0,    // Pass the sample on.
+	MATH_STAGE_DROP,        // Skip the sample, continue with the next.
+	MATH_STAGE_STOP         // Skip the sample and end the range.
+} TStageResult;
+
+/**
+ * Interface for a filter or transform applied to each sample of a
+ * FunctionRange. A stage may change the sample in place.
+ */
+class
+SampleStage
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~SampleStage()
+		{};
+
+	/**
+	 * Process a sample.
+	 * @param sample (input/output) Sample to examine or change.
+	 * @return What to do with the sample.
+	 */
+	virtual TStageResult
+	Process(
+		TFunctionSample *sample) = 0;
+};
+
+/**
+ * Points of a function at equally spaced x values, evaluated only as
+ * they are reached. Iterating the range evaluates the function a
+ * block at a time into a fixed buffer, so memory use does not depend
+ * on the number of points, and stopping early evaluates nothing more.
+ *
+ * Stages added to the range run in order on every sample, e.g.
+ *
+ *	FunctionRange range(&func, 0, 360, 100000);
+ *	range.AddStage(&dropUndefined).AddStage(&scale);
+ *	for(FunctionRange::iterator it = range.begin(); it != range.end(); ++it)
+ *	{
+ *		if(it->m_Y > limit) break;
+ *	}
+ *
+ * The range does not own the function or the stages.
+ */
+class
+FunctionRange
+{
+public:
+
+	/**
+	 * Forward iterator over the samples which pass every stage.
+	 */
+	class
+	iterator
+	{
+	public:
+
+		/**
+		 * Constructor. A default iterator is the end of any range.
+		 */
+		iterator();
+
+		/**
+		 * Constructor.
+		 * @param range (input) Range to iterate.
+		 */
+		iterator(
+			FunctionRange *range);
+
+		const TFunctionSample&
+		operator*() const
+			{return m_Sample;};
+
+		const TFunctionSample*
+		operator->() const
+			{return &m_Sample;};
+
+		/**
+		 * Move to the next sample which passes every stage.
+		 */
+		iterator&
+		operator++();
+
+		iterator
+		operator++(int);
+
+		/**
+		 * Iterators are equal at the same sample of the same range,
+		 * or when both are at an end.
+		 */
+		bool
+		operator==(const iterator& rhs) const;
+
+		bool
+		operator!=(const iterator& rhs) const
+			{return !(*this == rhs);};
+
+	protected:
+
+		/**
+		 * Evaluate the next block of points.
+		 * @return False at the end of the range.
+		 */
+		bool
+		FillBlock();
+
+	protected:
+		FunctionRange *m_Range;
+		bool m_IsEnd;
+
+		//-----------------------------------------------
+		// Index of the first point of the current block,
+		// and the position within the block.
+		//-----------------------------------------------
+		long m_BlockStart;
+		int m_BlockCount;
+		int m_Position;
+
+		double m_X[MATH_BLOCK_SIZE];
+		double m_Y[MATH_BLOCK_SIZE];
+		TMathResult m_Status[MATH_BLOCK_SIZE];
+
+		TFunctionSample m_Sample;
+	};
+
+	/**
+	 * Constructor.
+	 * @param function (input) Function to evaluate.
+	 * @param xStart (input) First x value.
+	 * @param xEnd (input) Last x value.
+	 * @param count (input) Number of points, including both ends.
+	 */
+	FunctionRange(
+		MathFunction *function,
+		double xStart,
+		double xEnd,
+		long count);
+
+	/**
+	 * Destructor.
+	 */
+	~FunctionRange();
+
+	/**
+	 * Add a stage to run after those already added.
+	 * @param stage (input) Filter or transform for each sample.
+	 * @return This range, so stages can be chained.
+	 */
+	FunctionRange&
+	AddStage(
+		SampleStage *stage);
+
+	/**
+	 * Get the number of points evaluated, before any are dropped.
+	 * @return Point count.
+	 */
+	long
+	GetCount() const
+		{return m_Count;};
+
+	/**
+	 * Get the x value of a point.
+	 * @param i (input) Index of the point.
+	 * @return X value.
+	 */
+	double
+	GetX(long i) const;
+
+	iterator
+	begin()
+		{return iterator(this);};
+
+	iterator
+	end()
+		{return iterator();};
+
+protected:
+	MathFunction *m_Function;
+	double m_Start;
+	double m_End;
+	long m_Count;
+	std::vector<SampleStage*> m_Stages;
+};
+
+#endif
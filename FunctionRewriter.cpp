@@ -0,0 +1,740 @@
+/**
+ * Title: FunctionRewriter
+ * Rewrites function graphs into equivalent ones which are faster to
+ * evaluate.
+ * @author Mary Wyllie
+ */
+
+#include "FunctionRewriter.h"
+#include "Polynomial.h"
+#include "Transform.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Constructor.
+ */
+FunctionRewriter::FunctionRewriter()
+{
+}
+
+/**
+ * Destructor. Deletes every function created.
+ */
+FunctionRewriter::~FunctionRewriter()
+{
+	Clear();
+}
+
+/**
+ * Delete every function created so far.
+ */
+void
+FunctionRewriter::Clear()
+{
+	for(size_t i = 0; i < m_Functions.size(); i++)
+	{
+		delete m_Functions[i];
+	}
+	m_Functions.clear();
+	m_Flattened.clear();
+	m_Collapsed.clear();
+	m_Shared.clear();
+	m_Catalog.clear();
+}
+
+/**
+ * Flatten chains of additions and multiplications into n-ary nodes.
+ * Each node is flattened once, so parts shared within or between the
+ * functions flattened stay shared.
+ * @param function (input) Function to flatten.
+ * @return Flattened function, the function itself if nothing
+ * changed, or NULL if the function is NULL.
+ */
+MathFunction*
+FunctionRewriter::Flatten(
+	MathFunction *function)
+{
+	if(!function) return NULL;
+
+	std::map<MathFunction*, MathFunction*>::iterator found =
+		m_Flattened.find(function);
+	if(found != m_Flattened.end()) return found->second;
+
+	MathOperation *operation = function->GetMathOperation();
+	if(!operation) return function;
+
+	MathFunction *result = NULL;
+	switch(operation->GetOperatorType())
+	{
+	case MATH_ADD:
+	case MATH_SUBTRACT:
+	case MATH_SUM:
+		result = FlattenSum(function);
+		break;
+	case MATH_MULTIPLY:
+	case MATH_PRODUCT:
+		result = FlattenProduct(function);
+		break;
+	default:
+		break;
+	}
+	if(!result) result = Rebuild(function);
+
+	m_Flattened[function] = result;
+	return result;
+}
+
+/**
+ * Collapse every subtree which is a polynomial in x into a single
+ * MATH_POLYNOMIAL node. Each node is collapsed once, so parts shared
+ * within or between the functions collapsed stay shared.
+ * @param function (input) Function to collapse.
+ * @return Collapsed function, the function itself if nothing
+ * changed, or NULL if the function is NULL.
+ */
+MathFunction*
+FunctionRewriter::Collapse(
+	MathFunction *function)
+{
+	if(!function) return NULL;
+
+	std::map<MathFunction*, MathFunction*>::iterator found =
+		m_Collapsed.find(function);
+	if(found != m_Collapsed.end()) return found->second;
+
+	MathOperation *operation = function->GetMathOperation();
+	if(!operation) return function;
+
+	//------------------------------------------------
+	// Children first, so a node whose operands have
+	// all become polynomials can be combined.
+	//------------------------------------------------
+	std::vector<MathFunction*> children, collapsed;
+	operation->GetChildren(&children);
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		collapsed.push_back(Collapse(children[i]));
+	}
+
+	MathFunction *result = NULL;
+	std::vector<double> coefficients;
+	if(operation->GetOperatorType() == MATH_POLYNOMIAL)
+		result = function;
+	else if(CombinePolynomials(function, collapsed, &coefficients))
+		result = AddNode(function, new MathFunction(MATH_POLYNOMIAL, coefficients));
+	else
+		result = Copy(function, collapsed);
+
+	m_Collapsed[function] = result;
+	return result;
+}
+
+/**
+ * Mix a value into a hash.
+ */
+static size_t
+HashCombine(
+	size_t hash,
+	size_t value)
+{
+	return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * Mix a double into a hash, by its bits, so that values are only equal
+ * if they are identical.
+ */
+static size_t
+HashDouble(
+	size_t hash,
+	double value)
+{
+	uint32_t words[2];
+	memcpy(words, &value, sizeof(words));
+	hash = HashCombine(hash, words[0]);
+	return HashCombine(hash, words[1]);
+}
+
+/**
+ * Hash of a node from its operator, setting, error policy, constants
+ * and shared children.
+ */
+static size_t
+HashNode(
+	MathFunction *function,
+	const std::vector<MathFunction*>& children)
+{
+	MathOperation *operation = function->GetMathOperation();
+	size_t hash = HashCombine(0, (size_t) operation->GetOperatorType());
+	hash = HashCombine(hash, (size_t) function->GetErrorPolicy());
+	MathSetting *setting = operation->GetMathSetting();
+	if(setting)
+	{
+		hash = HashDouble(hash, setting->GetEpsilon());
+		hash = HashCombine(hash, setting->GetAngleMode() ? 2 : 1);
+	}
+	for(int i = 0; i < operation->GetConstantCount(); i++)
+	{
+		hash = HashDouble(hash, operation->GetConstant(i));
+	}
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		hash = HashCombine(hash, (size_t) children[i]);
+	}
+	return hash;
+}
+
+/**
+ * Is a shared node the same as a node with the given shared children?
+ * @param shared (input) Node already shared.
+ * @param function (input) Node to share.
+ * @param children (input) Shared children of the node.
+ * @return True if the two nodes are structurally equal.
+ */
+static bool
+IsSameNode(
+	MathFunction *shared,
+	MathFunction *function,
+	const std::vector<MathFunction*>& children)
+{
+	MathOperation *operation = function->GetMathOperation();
+	MathOperation *other = shared->GetMathOperation();
+	if(other->GetOperatorType() != operation->GetOperatorType() ||
+		other->GetConstantCount() != operation->GetConstantCount() ||
+		shared->GetErrorPolicy() != function->GetErrorPolicy())
+	{
+		return false;
+	}
+
+	MathSetting *setting = operation->GetMathSetting();
+	MathSetting *otherSetting = other->GetMathSetting();
+	if((setting == NULL) != (otherSetting == NULL)) return false;
+	if(setting && (setting->GetEpsilon() != otherSetting->GetEpsilon() ||
+		setting->GetAngleMode() != otherSetting->GetAngleMode()))
+	{
+		return false;
+	}
+
+	for(int i = 0; i < operation->GetConstantCount(); i++)
+	{
+		double a = operation->GetConstant(i), b = other->GetConstant(i);
+		if(memcmp(&a, &b, sizeof(double)) != 0) return false;
+	}
+
+	std::vector<MathFunction*> otherChildren;
+	other->GetChildren(&otherChildren);
+	return otherChildren == children;
+}
+
+/**
+ * Share structurally equal parts of functions. Children are shared
+ * first, so equal nodes have identical children and are found by a
+ * hash of the node alone.
+ * @param function (input) Function to share.
+ * @return Shared function, which may be the function itself, or
+ * NULL if the function is NULL.
+ */
+MathFunction*
+FunctionRewriter::Share(
+	MathFunction *function)
+{
+	if(!function) return NULL;
+
+	std::map<MathFunction*, MathFunction*>::iterator found =
+		m_Shared.find(function);
+	if(found != m_Shared.end()) return found->second;
+
+	MathOperation *operation = function->GetMathOperation();
+	if(!operation) return function;
+
+	std::vector<MathFunction*> children, shared;
+	operation->GetChildren(&children);
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		shared.push_back(Share(children[i]));
+	}
+
+	size_t hash = HashNode(function, shared);
+	MathFunction *result = NULL;
+	std::multimap<size_t, MathFunction*>::iterator known =
+		m_Catalog.lower_bound(hash);
+	for(; known != m_Catalog.end() && known->first == hash; ++known)
+	{
+		if(IsSameNode(known->second, function, shared))
+		{
+			result = known->second;
+			break;
+		}
+	}
+
+	if(!result)
+	{
+		result = Copy(function, shared);
+		m_Catalog.insert(std::make_pair(hash, result));
+		m_Shared[result] = result;
+	}
+	m_Shared[function] = result;
+	return result;
+}
+
+/**
+ * Coefficients of a function which is a polynomial, or of a constant.
+ * @param function (input) Function, or NULL for the constant.
+ * @param constant (input) Constant where there is no function.
+ * @param coefficients (output) Coefficients, lowest power first.
+ * @return false if the function is not a MATH_POLYNOMIAL.
+ */
+static bool
+GetPolynomial(
+	MathFunction *function,
+	double constant,
+	std::vector<double> *coefficients)
+{
+	coefficients->clear();
+	if(!function)
+	{
+		coefficients->push_back(constant);
+		return true;
+	}
+
+	MathOperation *operation = function->GetMathOperation();
+	if(!operation || operation->GetOperatorType() != MATH_POLYNOMIAL) return false;
+	for(int i = 0; i < operation->GetConstantCount(); i++)
+	{
+		coefficients->push_back(operation->GetConstant(i));
+	}
+	Polynomial::Trim(coefficients);
+	return true;
+}
+
+/**
+ * Combine a node whose operands are polynomials or constants into one
+ * polynomial. Products, powers and compositions are only expanded up
+ * to MATH_POLYNOMIAL_MAX_DEGREE, and division only by a constant the
+ * node would not find to be zero.
+ * @param function (input) Node to combine.
+ * @param children (input) Collapsed children of the node.
+ * @param coefficients (output) Coefficients, lowest power first.
+ * @return false to leave the node as a node.
+ */
+bool
+FunctionRewriter::CombinePolynomials(
+	MathFunction *function,
+	const std::vector<MathFunction*>& children,
+	std::vector<double> *coefficients)
+{
+	MathOperation *operation = function->GetMathOperation();
+	TOperatorType type = operation->GetOperatorType();
+	int count = (int) children.size();
+	std::vector< std::vector<double> > operands(count);
+	bool isNary = (type == MATH_SUM || type == MATH_PRODUCT || type == MATH_MULADD);
+
+	for(int i = 0; i < count; i++)
+	{
+		//-------------------------------------------------
+		// A composition or transform missing a function is
+		// undefined, not a constant.
+		//-------------------------------------------------
+		if(!children[i] && (type == MATH_COMPOSITE || type == MATH_TRANSFORM))
+			return false;
+
+		//-------------------------------------------------
+		// A binary operator's constant stands in for a
+		// missing function; an n-ary operator's weight
+		// multiplies its function.
+		//-------------------------------------------------
+		double constant = (isNary || !children[i]) ? operation->GetConstant(i) : 0;
+		if(!GetPolynomial(children[i], constant, &operands[i]))
+			return false;
+		if(isNary && children[i]) Polynomial::Scale(operands[i], constant, &operands[i]);
+	}
+
+	int degree = 0;
+	switch(type)
+	{
+	case MATH_ADD:
+		Polynomial::Add(operands[0], operands[1], coefficients);
+		break;
+	case MATH_SUBTRACT:
+		Polynomial::Subtract(operands[0], operands[1], coefficients);
+		break;
+	case MATH_MULTIPLY:
+		if((int) (operands[0].size() + operands[1].size()) - 2 > MATH_POLYNOMIAL_MAX_DEGREE)
+			return false;
+		Polynomial::Multiply(operands[0], operands[1], coefficients);
+		break;
+	case MATH_DIVIDE:
+		{
+			double divisor = operands[1].empty() ? 0 : operands[1][0];
+			if(operands[1].size() > 1 || IsWithin(divisor, 0, function->GetEpsilon()))
+				return false;
+			Polynomial::Scale(operands[0], 1 / divisor, coefficients);
+		}
+		break;
+	case MATH_POWER:
+		{
+			double n = operands[1].empty() ? 0 : operands[1][0];
+			degree = (int) operands[0].size() - 1;
+			if(operands[1].size() > 1 || n < 0 || n != floor(n) ||
+				n * degree > MATH_POLYNOMIAL_MAX_DEGREE)
+			{
+				return false;
+			}
+			Polynomial::Power(operands[0], (int) n, coefficients);
+		}
+		break;
+	case MATH_COMPOSITE:
+		degree = ((int) operands[0].size() - 1) * ((int) operands[1].size() - 1);
+		if(degree > MATH_POLYNOMIAL_MAX_DEGREE) return false;
+		Polynomial::Compose(operands[0], operands[1], coefficients);
+		break;
+	case MATH_SUM:
+		coefficients->clear();
+		for(int i = 0; i < count; i++)
+		{
+			Polynomial::Add(*coefficients, operands[i], coefficients);
+		}
+		break;
+	case MATH_PRODUCT:
+		for(int i = 0; i < count; i++)
+		{
+			degree += (int) operands[i].size() - 1;
+		}
+		if(degree > MATH_POLYNOMIAL_MAX_DEGREE) return false;
+		coefficients->assign(1, 1.0);
+		for(int i = 0; i < count; i++)
+		{
+			Polynomial::Multiply(*coefficients, operands[i], coefficients);
+		}
+		break;
+	case MATH_MULADD:
+		if(count != 3 ||
+			(int) (operands[0].size() + operands[1].size()) - 2 > MATH_POLYNOMIAL_MAX_DEGREE)
+		{
+			return false;
+		}
+		Polynomial::Multiply(operands[0], operands[1], coefficients);
+		Polynomial::Add(*coefficients, operands[2], coefficients);
+		break;
+	case MATH_TRANSFORM:
+		{
+			std::vector<double> inside(2), offset(1, operation->GetConstant(3));
+			inside[0] = operation->GetConstant(1);
+			inside[1] = operation->GetConstant(0);
+			Polynomial::Compose(operands[0], inside, coefficients);
+			Polynomial::Scale(*coefficients, operation->GetConstant(2), coefficients);
+			Polynomial::Add(*coefficients, offset, coefficients);
+		}
+		break;
+	default:
+		return false;
+	}
+
+	Polynomial::Trim(coefficients);
+	if(coefficients->empty()) coefficients->push_back(0);
+	return true;
+}
+
+/**
+ * Gather the operands of a chain of additions, subtractions and
+ * constant multiples. Anything else is an operand, flattened in turn.
+ * @param function (input) Part of the chain.
+ * @param weight (input) Multiple of the part in the whole.
+ * @param terms (input/output) Operand functions, flattened.
+ * @param weights (input/output) Weight of each operand.
+ * @param constant (input/output) Sum of the constants.
+ * @param absorbed (input/output) Number of nodes replaced.
+ */
+void
+FunctionRewriter::CollectTerms(
+	MathFunction *function,
+	double weight,
+	std::vector<MathFunction*> *terms,
+	std::vector<double> *weights,
+	double *constant,
+	int *absorbed)
+{
+	MathOperation *operation = function->GetMathOperation();
+	TOperatorType type = operation ? operation->GetOperatorType() : MATH_POLYNOMIAL;
+	std::vector<MathFunction*> children;
+	if(operation) operation->GetChildren(&children);
+
+	switch(type)
+	{
+	case MATH_ADD:
+	case MATH_SUBTRACT:
+	case MATH_SUM:
+		(*absorbed)++;
+		for(size_t i = 0; i < children.size(); i++)
+		{
+			//-------------------------------------------------
+			// A sum's weights multiply its operands; a binary
+			// operator's constant is used only without a
+			// function.
+			//-------------------------------------------------
+			double part = weight;
+			if(type == MATH_SUBTRACT && i == 1) part = -part;
+			if(type == MATH_SUM || !children[i])
+				part *= operation->GetConstant((int) i);
+			if(children[i])
+				CollectTerms(children[i], part, terms, weights, constant, absorbed);
+			else
+				*constant += part;
+		}
+		return;
+
+	case MATH_MULTIPLY:
+		//-----------------------------------------------
+		// A constant multiple of a function becomes the
+		// weight of the function.
+		//-----------------------------------------------
+		if((children[0] == NULL) != (children[1] == NULL))
+		{
+			int i = children[0] ? 0 : 1;
+			(*absorbed)++;
+			CollectTerms(children[i], weight * operation->GetConstant(1 - i),
+				terms, weights, constant, absorbed);
+			return;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	//--------------------------------------------
+	// An operand. The same function seen again
+	// adds to the weight it already has.
+	//--------------------------------------------
+	MathFunction *term = Flatten(function);
+	for(size_t i = 0; i < terms->size(); i++)
+	{
+		if((*terms)[i] == term)
+		{
+			(*weights)[i] += weight;
+			return;
+		}
+	}
+	terms->push_back(term);
+	weights->push_back(weight);
+}
+
+/**
+ * Gather the factors of a chain of multiplications. Anything else is
+ * a factor, flattened in turn.
+ * @param function (input) Part of the chain.
+ * @param factors (input/output) Factor functions, flattened.
+ * @param constant (input/output) Product of the constants.
+ * @param absorbed (input/output) Number of nodes replaced.
+ */
+void
+FunctionRewriter::CollectFactors(
+	MathFunction *function,
+	std::vector<MathFunction*> *factors,
+	double *constant,
+	int *absorbed)
+{
+	MathOperation *operation = function->GetMathOperation();
+	TOperatorType type = operation ? operation->GetOperatorType() : MATH_POLYNOMIAL;
+
+	if(type == MATH_MULTIPLY || type == MATH_PRODUCT)
+	{
+		std::vector<MathFunction*> children;
+		operation->GetChildren(&children);
+		(*absorbed)++;
+		for(size_t i = 0; i < children.size(); i++)
+		{
+			//-------------------------------------------------
+			// A product's weights multiply its operands; a
+			// binary operator's constant is used only without
+			// a function.
+			//-------------------------------------------------
+			if(type == MATH_PRODUCT || !children[i])
+				*constant *= operation->GetConstant((int) i);
+			if(children[i])
+				CollectFactors(children[i], factors, constant, absorbed);
+		}
+		return;
+	}
+	factors->push_back(Flatten(function));
+}
+
+/**
+ * Flatten a sum into a MATH_SUM, or a MATH_MULADD if it is a product
+ * of two functions plus one other operand.
+ * @return New function, or NULL to leave the sum as it is.
+ */
+MathFunction*
+FunctionRewriter::FlattenSum(
+	MathFunction *function)
+{
+	std::vector<MathFunction*> terms;
+	std::vector<double> weights;
+	double constant = 0;
+	int absorbed = 0;
+
+	CollectTerms(function, 1, &terms, &weights, &constant, &absorbed);
+	if(constant != 0)
+	{
+		terms.push_back(NULL);
+		weights.push_back(constant);
+	}
+
+	//---------------------------------------------------
+	// f*g + h replaces both binary nodes with one node.
+	//---------------------------------------------------
+	if(terms.size() == 2)
+	{
+		for(int i = 0; i < 2; i++)
+		{
+			MathOperation *operation = terms[i] ?
+				terms[i]->GetMathOperation() : NULL;
+			if(!operation || operation->GetOperatorType() != MATH_MULTIPLY)
+				continue;
+
+			std::vector<MathFunction*> children;
+			operation->GetChildren(&children);
+			if(!children[0] || !children[1]) continue;
+
+			std::vector<MathFunction*> operands;
+			std::vector<double> operandWeights;
+			operands.push_back(children[0]);
+			operandWeights.push_back(weights[i]);
+			operands.push_back(children[1]);
+			operandWeights.push_back(1);
+			operands.push_back(terms[1 - i]);
+			operandWeights.push_back(weights[1 - i]);
+			return AddNode(function,
+				new MathFunction(MATH_MULADD, operands, operandWeights));
+		}
+	}
+
+	if(absorbed < 2) return NULL;
+	return AddNode(function, new MathFunction(MATH_SUM, terms, weights));
+}
+
+/**
+ * Flatten a product into a MATH_PRODUCT, with the product of the
+ * constants as the weight of the first factor.
+ * @return New function, or NULL to leave the product as it is.
+ */
+MathFunction*
+FunctionRewriter::FlattenProduct(
+	MathFunction *function)
+{
+	std::vector<MathFunction*> factors;
+	double constant = 1;
+	int absorbed = 0;
+
+	CollectFactors(function, &factors, &constant, &absorbed);
+	if(absorbed < 2 || factors.empty()) return NULL;
+
+	std::vector<double> weights(factors.size(), 1.0);
+	weights[0] = constant;
+	return AddNode(function, new MathFunction(MATH_PRODUCT, factors, weights));
+}
+
+/**
+ * Copy a node with flattened children.
+ * @return New function, or the function itself if none of its
+ * children changed.
+ */
+MathFunction*
+FunctionRewriter::Rebuild(
+	MathFunction *function)
+{
+	std::vector<MathFunction*> children, flattened;
+	function->GetMathOperation()->GetChildren(&children);
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		flattened.push_back(Flatten(children[i]));
+	}
+	return Copy(function, flattened);
+}
+
+/**
+ * Copy a node with new children.
+ * @param function (input) Node to copy.
+ * @param replacements (input) New children, in the order
+ * GetChildren gives them.
+ * @return New function, or the function itself if none of its
+ * children changed.
+ */
+MathFunction*
+FunctionRewriter::Copy(
+	MathFunction *function,
+	const std::vector<MathFunction*>& replacements)
+{
+	MathOperation *operation = function->GetMathOperation();
+	std::vector<MathFunction*> children;
+	bool isChanged = false;
+
+	operation->GetChildren(&children);
+	for(size_t i = 0; i < children.size(); i++)
+	{
+		if(replacements[i] != children[i]) isChanged = true;
+	}
+	if(!isChanged) return function;
+
+	TOperatorType type = operation->GetOperatorType();
+	MathFunction *result = NULL;
+	switch(type)
+	{
+	case MATH_ADD:
+	case MATH_SUBTRACT:
+	case MATH_MULTIPLY:
+	case MATH_DIVIDE:
+	case MATH_POWER:
+		if(replacements[0] && replacements[1])
+			result = new MathFunction(type, replacements[0], replacements[1]);
+		else if(replacements[0])
+			result = new MathFunction(type, replacements[0], operation->GetConstant(1));
+		else
+			result = new MathFunction(type, operation->GetConstant(0), replacements[1]);
+		break;
+	case MATH_COMPOSITE:
+		result = new MathFunction(MATH_COMPOSITE, replacements[0], replacements[1]);
+		break;
+	case MATH_TRANSFORM:
+		result = new MathFunction(new Transform(replacements[0],
+			operation->GetConstant(0), operation->GetConstant(1),
+			operation->GetConstant(2), operation->GetConstant(3)));
+		break;
+	case MATH_SUM:
+	case MATH_PRODUCT:
+	case MATH_MULADD:
+		{
+			std::vector<double> weights;
+			for(int i = 0; i < operation->GetConstantCount(); i++)
+			{
+				weights.push_back(operation->GetConstant(i));
+			}
+			result = new MathFunction(type, replacements, weights);
+		}
+		break;
+	default:
+		return function;
+	}
+	return AddNode(function, result);
+}
+
+/**
+ * Keep a new node, giving it the setting and error policy of the
+ * node it replaces.
+ */
+MathFunction*
+FunctionRewriter::AddNode(
+	MathFunction *source,
+	MathFunction *function)
+{
+	if(source->GetMathSetting())
+	{
+		function->SetEpsilon(source->GetEpsilon());
+		function->SetAngleMode(source->GetAngleMode());
+	}
+	function->SetErrorPolicy(source->GetErrorPolicy());
+	m_Functions.push_back(function);
+	return(function);
+}
@@ -0,0 +1,225 @@
+/**
+ * Title: FunctionRewriter
+ * Rewrites function graphs into equivalent ones which are faster to
+ * evaluate.
+ * @author Mary Wyllie
+ */
+
+#ifndef FUNCTIONREWRITER_H
+#define FUNCTIONREWRITER_H
+
+#include "MathFunction.h"
+#include <map>
+#include <vector>
+
+/**
+ * Rewriter for function graphs. Rewriting never changes the functions
+ * given to it: a rewritten function is a new graph which shares every
+ * unchanged part of the original, so the original must outlive it.
+ *
+ * The rewriter owns every function it creates and deletes them when
+ * it is cleared or destroyed. New nodes get the error policy of the
+ * node they replace, and a copy of its setting if it has one.
+ */
+class
+FunctionRewriter :
+	public MathBase
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	FunctionRewriter();
+
+	/**
+	 * Destructor. Deletes every function created.
+	 */
+	virtual
+	~FunctionRewriter();
+
+	/**
+	 * Flatten chains of additions and multiplications into n-ary
+	 * nodes (see NaryOperator). Sums and differences of functions,
+	 * constants and constant multiples of functions become one
+	 * MATH_SUM, with the constant multiples as weights and repeated
+	 * functions merged; products of functions and constants become
+	 * one MATH_PRODUCT. A product of two functions plus one other
+	 * operand becomes a MATH_MULADD. A chain is only replaced where
+	 * that removes nodes.
+	 *
+	 *	2*sin(x) + 3*cos(x) - ln(x) + 1   ->  SUM(2 sin, 3 cos, -1 ln, 1)
+	 *	sin(x)*cos(x) + 1                 ->  MULADD(sin, cos, 1)
+	 *
+	 * The order of the additions changes, so results may differ in
+	 * the last bits.
+	 * @param function (input) Function to flatten.
+	 * @return Flattened function, the function itself if nothing
+	 * changed, or NULL if the function is NULL.
+	 */
+	MathFunction*
+	Flatten(
+		MathFunction *function);
+
+	/**
+	 * Collapse every subtree which is a polynomial in x into one
+	 * MATH_POLYNOMIAL node, evaluated by Horner's rule. Sums,
+	 * differences, products and compositions of polynomials and
+	 * constants combine, as do n-ary operators over them, quotients by
+	 * a constant and whole constant powers. Products, powers and
+	 * compositions are not expanded beyond MATH_POLYNOMIAL_MAX_DEGREE.
+	 *
+	 *	(2x + 1) * (x - 3) + x^2          ->  3x^2 - 5x - 3
+	 *	sin((x + 1)^2 - 1)                ->  sin(x^2 + 2x)
+	 *
+	 * Expanding changes the rounding, so results may differ in the
+	 * last bits, and more near the roots of a product or power.
+	 * @param function (input) Function to collapse.
+	 * @return Collapsed function, the function itself if nothing
+	 * changed, or NULL if the function is NULL.
+	 */
+	MathFunction*
+	Collapse(
+		MathFunction *function);
+
+	/**
+	 * Share structurally equal parts of functions. Two nodes are equal
+	 * if they have the same operator, constants, setting and error
+	 * policy, and their children are the same shared nodes. The first
+	 * node seen of each kind is kept for all of them, so repeated
+	 * parts, within one function or across every function shared by
+	 * this rewriter, become one node:
+	 *
+	 *	f = rewriter.Share(parser.Parse("sin(2*pi*x) + x"));
+	 *	g = rewriter.Share(parser.Parse("3*sin(2*pi*x)"));
+	 *
+	 * leaves f and g using the same sin(2 pi x). A FunctionImage or
+	 * BatchEvaluator built from shared functions stores such a node
+	 * once, and a BatchEvaluator calculates it once per tile. Shared
+	 * nodes must not be changed afterwards, as every function using
+	 * them would change.
+	 * @param function (input) Function to share.
+	 * @return Shared function, which may be the function itself, or
+	 * NULL if the function is NULL.
+	 */
+	MathFunction*
+	Share(
+		MathFunction *function);
+
+	/**
+	 * Get the number of distinct nodes shared so far.
+	 * @return Node count.
+	 */
+	int
+	GetSharedCount() const
+		{ return (int) m_Catalog.size(); };
+
+	/**
+	 * Delete every function created so far.
+	 */
+	void
+	Clear();
+
+protected:
+
+	/**
+	 * Gather the operands of a chain of additions, subtractions and
+	 * constant multiples.
+	 * @param function (input) Part of the chain.
+	 * @param weight (input) Multiple of the part in the whole.
+	 * @param terms (input/output) Operand functions, flattened.
+	 * @param weights (input/output) Weight of each operand.
+	 * @param constant (input/output) Sum of the constants.
+	 * @param absorbed (input/output) Number of nodes replaced.
+	 */
+	void
+	CollectTerms(
+		MathFunction *function,
+		double weight,
+		std::vector<MathFunction*> *terms,
+		std::vector<double> *weights,
+		double *constant,
+		int *absorbed);
+
+	/**
+	 * Gather the factors of a chain of multiplications.
+	 * @param function (input) Part of the chain.
+	 * @param factors (input/output) Factor functions, flattened.
+	 * @param constant (input/output) Product of the constants.
+	 * @param absorbed (input/output) Number of nodes replaced.
+	 */
+	void
+	CollectFactors(
+		MathFunction *function,
+		std::vector<MathFunction*> *factors,
+		double *constant,
+		int *absorbed);
+
+	/**
+	 * Flatten a sum, or return NULL to leave it as it is.
+	 */
+	MathFunction*
+	FlattenSum(
+		MathFunction *function);
+
+	/**
+	 * Flatten a product, or return NULL to leave it as it is.
+	 */
+	MathFunction*
+	FlattenProduct(
+		MathFunction *function);
+
+	/**
+	 * Copy a node with flattened children, or return the node itself
+	 * if none of its children changed.
+	 */
+	MathFunction*
+	Rebuild(
+		MathFunction *function);
+
+	/**
+	 * Copy a node with new children, or return the node itself if
+	 * none of its children changed.
+	 */
+	MathFunction*
+	Copy(
+		MathFunction *function,
+		const std::vector<MathFunction*>& replacements);
+
+	/**
+	 * Combine a node whose operands are polynomials or constants into
+	 * one polynomial.
+	 * @param function (input) Node to combine.
+	 * @param children (input) Collapsed children of the node.
+	 * @param coefficients (output) Coefficients, lowest power first.
+	 * @return false to leave the node as a node.
+	 */
+	bool
+	CombinePolynomials(
+		MathFunction *function,
+		const std::vector<MathFunction*>& children,
+		std::vector<double> *coefficients);
+
+	/**
+	 * Keep a new node, giving it the setting and error policy of the
+	 * node it replaces.
+	 */
+	MathFunction*
+	AddNode(
+		MathFunction *source,
+		MathFunction *function);
+
+protected:
+	std::vector<MathFunction*> m_Functions;
+	std::map<MathFunction*, MathFunction*> m_Flattened;
+	std::map<MathFunction*, MathFunction*> m_Collapsed;
+	std::map<MathFunction*, MathFunction*> m_Shared;
+
+	//-------------------------------------------
+	// Every distinct shared node, by a hash of its
+	// operator, constants, setting and children.
+	//-------------------------------------------
+	std::multimap<size_t, MathFunction*> m_Catalog;
+};
+
+#endif
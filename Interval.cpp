@@ -0,0 +1,379 @@
+/**
+ * Title: Interval
+ * Closed range of real values for bounding functions.
+ * @author Mary Wyllie
+ */
+
+#include "Interval.h"
+#include <float.h>
+#include <math.h>
+
+/**
+ * Product of two bounds, taking 0 times infinity as 0 since an
+ * infinite bound is only a limit.
+ */
+static double
+BoundProduct(
+	double a,
+	double b)
+{
+	if(a == 0 || b == 0) return 0;
+	return a * b;
+}
+
+/**
+ * Constructor. The interval [0, 0].
+ */
+Interval::Interval() :
+	m_Lower(0),
+	m_Upper(0),
+	m_MayBeUndefined(false)
+{
+}
+
+/**
+ * Constructor. An interval holding a single value.
+ * @param value (input) Value.
+ */
+Interval::Interval(
+	double value) :
+	m_Lower(value),
+	m_Upper(value),
+	m_MayBeUndefined(false)
+{
+}
+
+/**
+ * Constructor. The bounds are swapped if given in reverse.
+ * @param lower (input) Lower bound.
+ * @param upper (input) Upper bound.
+ */
+Interval::Interval(
+	double lower,
+	double upper) :
+	m_Lower(lower < upper ? lower : upper),
+	m_Upper(lower < upper ? upper : lower),
+	m_MayBeUndefined(false)
+{
+}
+
+/**
+ * The interval of all real values.
+ * @return [-infinity, infinity].
+ */
+Interval
+Interval::Entire()
+{
+	return Interval(-HUGE_VAL, HUGE_VAL);
+}
+
+/**
+ * Middle of the interval, or the finite bound's side of it if the
+ * interval is unbounded.
+ * @return Midpoint.
+ */
+double
+Interval::GetMidpoint() const
+{
+	if(IsBounded()) return 0.5 * m_Lower + 0.5 * m_Upper;
+	if(m_Lower == -HUGE_VAL && m_Upper == HUGE_VAL) return 0;
+	return (m_Lower == -HUGE_VAL) ? -DBL_MAX : DBL_MAX;
+}
+
+/**
+ * Are both bounds finite?
+ * @return True if bounded.
+ */
+bool
+Interval::IsBounded() const
+{
+	return m_Lower > -HUGE_VAL && m_Upper < HUGE_VAL;
+}
+
+/**
+ * Smallest interval containing this one and another.
+ * @param rhs (input) Other interval.
+ * @return Hull of the two.
+ */
+Interval
+Interval::Hull(
+	const Interval& rhs) const
+{
+	Interval result(
+		(m_Lower < rhs.m_Lower) ? m_Lower : rhs.m_Lower,
+		(m_Upper > rhs.m_Upper) ? m_Upper : rhs.m_Upper);
+	result.m_MayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+	return result;
+}
+
+/**
+ * Intersection with another interval.
+ * @param rhs (input) Other interval.
+ * @param result (output) Intersection.
+ * @return False if the intervals do not meet.
+ */
+bool
+Interval::Intersect(
+	const Interval& rhs,
+	Interval *result) const
+{
+	double lower = (m_Lower > rhs.m_Lower) ? m_Lower : rhs.m_Lower;
+	double upper = (m_Upper < rhs.m_Upper) ? m_Upper : rhs.m_Upper;
+	if(lower > upper) return false;
+
+	*result = Interval(lower, upper);
+	result->m_MayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+	return true;
+}
+
+Interval
+Interval::operator-() const
+{
+	Interval result(-m_Upper, -m_Lower);
+	result.m_MayBeUndefined = m_MayBeUndefined;
+	return result;
+}
+
+Interval
+Interval::operator+(const Interval& rhs) const
+{
+	Interval result(RoundDown(m_Lower + rhs.m_Lower),
+		RoundUp(m_Upper + rhs.m_Upper));
+	result.m_MayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+	return result;
+}
+
+Interval
+Interval::operator-(const Interval& rhs) const
+{
+	Interval result(RoundDown(m_Lower - rhs.m_Upper),
+		RoundUp(m_Upper - rhs.m_Lower));
+	result.m_MayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+	return result;
+}
+
+Interval
+Interval::operator*(const Interval& rhs) const
+{
+	double p[4];
+	p[0] = BoundProduct(m_Lower, rhs.m_Lower);
+	p[1] = BoundProduct(m_Lower, rhs.m_Upper);
+	p[2] = BoundProduct(m_Upper, rhs.m_Lower);
+	p[3] = BoundProduct(m_Upper, rhs.m_Upper);
+
+	double lower = p[0], upper = p[0];
+	for(int i = 1; i < 4; i++)
+	{
+		if(p[i] < lower) lower = p[i];
+		if(p[i] > upper) upper = p[i];
+	}
+
+	Interval result(RoundDown(lower), RoundUp(upper));
+	result.m_MayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+	return result;
+}
+
+/**
+ * Divide by another interval. As for a single division, divisors
+ * within epsilon of 0 are undefined, so that part of the divisor
+ * is left out and the result flagged. A divisor with defined
+ * values on both sides of 0 gives the entire real line.
+ * @param rhs (input) Divisor.
+ * @param epsilon (input) Divisors within this of 0 are undefined.
+ * @param result (output) Quotient.
+ * @return MATH_UNDEFINED if every divisor is undefined.
+ */
+TMathResult
+Interval::Divide(
+	const Interval& rhs,
+	double epsilon,
+	Interval *result) const
+{
+	double lower = rhs.m_Lower, upper = rhs.m_Upper;
+	bool mayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+
+	//-------------------------------------------------
+	// Undefined divisors are those with |d| < epsilon,
+	// or d == 0 when epsilon is 0.
+	//-------------------------------------------------
+	if(epsilon > 0)
+	{
+		if(lower > -epsilon && upper < epsilon) return MATH_UNDEFINED;
+		if(lower < epsilon && upper > -epsilon)
+		{
+			mayBeUndefined = true;
+			if(lower <= -epsilon && upper >= epsilon)
+			{
+				*result = Entire();
+				result->m_MayBeUndefined = true;
+				return MATH_SUCCESS;
+			}
+			if(lower > -epsilon) lower = epsilon;
+			else upper = -epsilon;
+		}
+	}
+	else
+	{
+		if(lower == 0 && upper == 0) return MATH_UNDEFINED;
+		if(lower < 0 && upper > 0)
+		{
+			*result = Entire();
+			result->m_MayBeUndefined = true;
+			return MATH_SUCCESS;
+		}
+		if(lower == 0 || upper == 0) mayBeUndefined = true;
+	}
+
+	//-----------------------------------------------
+	// The divisor now has one sign; multiply by its
+	// reciprocal. A zero bound gives an infinite one.
+	//-----------------------------------------------
+	Interval reciprocal;
+	reciprocal.m_Lower = (upper == 0) ? -HUGE_VAL : RoundDown(1 / upper);
+	reciprocal.m_Upper = (lower == 0) ? HUGE_VAL : RoundUp(1 / lower);
+
+	*result = (*this) * reciprocal;
+	result->m_MayBeUndefined = mayBeUndefined;
+	return MATH_SUCCESS;
+}
+
+/**
+ * Raise to a power. Whole powers of any base are exact; otherwise
+ * only non-negative bases are defined, so negative bases are left
+ * out and the result flagged.
+ * @param rhs (input) Exponent.
+ * @param result (output) Power.
+ * @return MATH_UNDEFINED if no base and exponent are defined.
+ */
+TMathResult
+Interval::Power(
+	const Interval& rhs,
+	Interval *result) const
+{
+	bool mayBeUndefined = m_MayBeUndefined || rhs.m_MayBeUndefined;
+
+	//---------------------------
+	// A single whole exponent.
+	//---------------------------
+	double n = rhs.m_Lower;
+	if(n == rhs.m_Upper && n == floor(n) && fabs(n) < 1e9)
+	{
+		TMathResult status = MATH_SUCCESS;
+		if(n >= 0)
+			*result = Power((int) n);
+		else
+			status = Interval(1).Divide(Power((int) -n), 0, result);
+		if(status == MATH_SUCCESS)
+			result->m_MayBeUndefined = result->m_MayBeUndefined || mayBeUndefined;
+		return status;
+	}
+
+	//-------------------------------------------------------
+	// For non-negative bases, the power is monotonic in the
+	// base and in the exponent, so its extremes are at the
+	// corners.
+	//-------------------------------------------------------
+	double lower = m_Lower, upper = m_Upper;
+	bool hasNegative = (lower < 0);
+	if(hasNegative)
+	{
+		mayBeUndefined = true;
+		if(upper < 0 && floor(rhs.m_Upper) < ceil(rhs.m_Lower))
+			return MATH_UNDEFINED;
+		lower = 0;
+		if(upper < 0) upper = 0;
+	}
+
+	double p[4];
+	p[0] = pow(lower, rhs.m_Lower);
+	p[1] = pow(lower, rhs.m_Upper);
+	p[2] = pow(upper, rhs.m_Lower);
+	p[3] = pow(upper, rhs.m_Upper);
+
+	double pLower = p[0], pUpper = p[0];
+	for(int i = 1; i < 4; i++)
+	{
+		if(p[i] < pLower) pLower = p[i];
+		if(p[i] > pUpper) pUpper = p[i];
+	}
+	*result = Interval(RoundDown(pLower), RoundUp(pUpper));
+
+	//----------------------------------------------------
+	// Negative bases are defined at whole exponents, with
+	// either sign; bound them by the largest magnitude.
+	//----------------------------------------------------
+	if(hasNegative && floor(rhs.m_Upper) >= ceil(rhs.m_Lower))
+	{
+		Interval magnitude(0, (-m_Lower > upper) ? -m_Lower : upper);
+		Interval negative;
+		magnitude.Power(rhs, &negative);
+		*result = result->Hull(negative).Hull(-negative);
+	}
+
+	result->m_MayBeUndefined = mayBeUndefined;
+	return MATH_SUCCESS;
+}
+
+/**
+ * Raise to a whole power.
+ * @param n (input) Exponent, at least 0.
+ * @return Power.
+ */
+Interval
+Interval::Power(
+	int n) const
+{
+	Interval result(1);
+	result.m_MayBeUndefined = m_MayBeUndefined;
+	if(n <= 0) return result;
+
+	double lower = pow(m_Lower, n);
+	double upper = pow(m_Upper, n);
+
+	if(n % 2 == 1)
+	{
+		result.m_Lower = RoundDown(lower);
+		result.m_Upper = RoundUp(upper);
+	}
+	else if(m_Lower >= 0)
+	{
+		result.m_Lower = RoundDown(lower);
+		result.m_Upper = RoundUp(upper);
+	}
+	else if(m_Upper <= 0)
+	{
+		result.m_Lower = RoundDown(upper);
+		result.m_Upper = RoundUp(lower);
+	}
+	else
+	{
+		result.m_Lower = 0;
+		result.m_Upper = RoundUp((lower > upper) ? lower : upper);
+	}
+	if(result.m_Lower < 0 && n % 2 == 0) result.m_Lower = 0;
+	return result;
+}
+
+/**
+ * Next double below a value, so that a result rounded to nearest,
+ * or computed by the C library to within an ulp, is not above the
+ * true value.
+ */
+double
+Interval::RoundDown(
+	double value)
+{
+	if(value != value || value == -HUGE_VAL) return value;
+	return nextafter(value, -HUGE_VAL);
+}
+
+/**
+ * Next double above a value.
+ */
+double
+Interval::RoundUp(
+	double value)
+{
+	if(value != value || value == HUGE_VAL) return value;
+	return nextafter(value, HUGE_VAL);
+}
@@ -0,0 +1,195 @@
+/**
+ * Title: Interval
+ * Closed range of real values for bounding functions.
+ * @author Mary Wyllie
+ */
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "MathDefs.h"
+
+/**
+ * A closed interval [lower, upper] of real values. Bounds may be
+ * infinite. Arithmetic rounds outward, so that a result contains
+ * every value the operation can give for any values of the operands,
+ * despite the rounding of each bound.
+ *
+ * An interval also carries a flag saying that the function it came
+ * from may be undefined at some of the points it was evaluated over,
+ * such as a division by an interval containing zero. The bounds then
+ * cover only the points where the function is defined. The flag is
+ * passed on by arithmetic.
+ */
+class
+Interval
+{
+public:
+
+	/**
+	 * Constructor. The interval [0, 0].
+	 */
+	Interval();
+
+	/**
+	 * Constructor. An interval holding a single value.
+	 * @param value (input) Value.
+	 */
+	Interval(
+		double value);
+
+	/**
+	 * Constructor. The bounds are swapped if given in reverse.
+	 * @param lower (input) Lower bound.
+	 * @param upper (input) Upper bound.
+	 */
+	Interval(
+		double lower,
+		double upper);
+
+	/**
+	 * The interval of all real values.
+	 * @return [-infinity, infinity].
+	 */
+	static Interval
+	Entire();
+
+	double
+	GetLower() const
+		{ return m_Lower; };
+
+	double
+	GetUpper() const
+		{ return m_Upper; };
+
+	double
+	GetWidth() const
+		{ return m_Upper - m_Lower; };
+
+	double
+	GetMidpoint() const;
+
+	/**
+	 * Is a value inside the interval?
+	 * @param value (input) Value to check.
+	 * @return True if lower <= value <= upper.
+	 */
+	bool
+	Contains(
+		double value) const
+		{ return m_Lower <= value && value <= m_Upper; };
+
+	/**
+	 * Are both bounds finite?
+	 * @return True if bounded.
+	 */
+	bool
+	IsBounded() const;
+
+	/**
+	 * May the function this interval came from be undefined at some
+	 * of the points it was evaluated over?
+	 * @return True if some points may be undefined.
+	 */
+	bool
+	MayBeUndefined() const
+		{ return m_MayBeUndefined; };
+
+	void
+	SetMayBeUndefined(
+		bool mayBeUndefined)
+		{ m_MayBeUndefined = mayBeUndefined; };
+
+	/**
+	 * Smallest interval containing this one and another.
+	 * @param rhs (input) Other interval.
+	 * @return Hull of the two.
+	 */
+	Interval
+	Hull(
+		const Interval& rhs) const;
+
+	/**
+	 * Intersection with another interval.
+	 * @param rhs (input) Other interval.
+	 * @param result (output) Intersection.
+	 * @return False if the intervals do not meet.
+	 */
+	bool
+	Intersect(
+		const Interval& rhs,
+		Interval *result) const;
+
+	Interval
+	operator-() const;
+
+	Interval
+	operator+(const Interval& rhs) const;
+
+	Interval
+	operator-(const Interval& rhs) const;
+
+	Interval
+	operator*(const Interval& rhs) const;
+
+	/**
+	 * Divide by another interval. As for a single division, divisors
+	 * within epsilon of 0 are undefined, so that part of the divisor
+	 * is left out and the result flagged. A divisor with defined
+	 * values on both sides of 0 gives the entire real line.
+	 * @param rhs (input) Divisor.
+	 * @param epsilon (input) Divisors within this of 0 are undefined.
+	 * @param result (output) Quotient.
+	 * @return MATH_UNDEFINED if every divisor is undefined.
+	 */
+	TMathResult
+	Divide(
+		const Interval& rhs,
+		double epsilon,
+		Interval *result) const;
+
+	/**
+	 * Raise to a power. Whole powers of any base are exact; otherwise
+	 * only non-negative bases are defined, so negative bases are left
+	 * out and the result flagged.
+	 * @param rhs (input) Exponent.
+	 * @param result (output) Power.
+	 * @return MATH_UNDEFINED if no base and exponent are defined.
+	 */
+	TMathResult
+	Power(
+		const Interval& rhs,
+		Interval *result) const;
+
+	/**
+	 * Raise to a whole power.
+	 * @param n (input) Exponent, at least 0.
+	 * @return Power.
+	 */
+	Interval
+	Power(
+		int n) const;
+
+	/**
+	 * Next double below a value, so that a result rounded to nearest,
+	 * or computed by the C library to within an ulp, is not above the
+	 * true value.
+	 */
+	static double
+	RoundDown(
+		double value);
+
+	/**
+	 * Next double above a value.
+	 */
+	static double
+	RoundUp(
+		double value);
+
+protected:
+	double m_Lower;
+	double m_Upper;
+	bool m_MayBeUndefined;
+};
+
+#endif
@@ -3,6 +3,7 @@
  */
 
 #include "LogFunction.h"
+#include "MathKernels.h"
 #include <math.h>
 
 /**
@@ -22,6 +23,7 @@ LogFunction::LogFunction(
 	TOperatorType oper,
 	double base)
 {
+	m_Operator = oper;
 	m_Base = base;
 	if(oper == MATH_LN)
 	{
@@ -45,18 +47,114 @@ TMathResult
 LogFunction::CalculateY(
 	double x,
 	double *y)
+{
+	return(Evaluate(m_Operator, m_Base, GetEpsilon(), x, y));
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+LogFunction::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	KernelLogBlock(GetOperatorType(), m_Base, (float) GetEpsilon(),
+		x, y, status, count);
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. Every
+ * point is calculated, and NaN selected where it is within epsilon
+ * of 0 or below, as Evaluate does.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+LogFunction::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	double epsilon = GetEpsilon();
+	double nan = KernelNaN<double>();
+
+	if(m_Base < 0 || IsWithin(m_Base, 0, epsilon))
+	{
+		for(int i = 0; i < count; i++) y[i] = nan;
+		return;
+	}
+
+	if(m_Operator == MATH_LN)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			double v = x[i];
+			double result = log(v);
+			y[i] = ((v < 0) | KernelIsNearZero(v, epsilon)) ? nan : result;
+		}
+		return;
+	}
+
+	double divisor = (m_Base != 10.0) ? log10(m_Base) : 1;
+	for(int i = 0; i < count; i++)
+	{
+		double v = x[i];
+		double result = log10(v) / divisor;
+		y[i] = ((v < 0) | KernelIsNearZero(v, epsilon)) ? nan : result;
+	}
+}
+
+/**
+ * Bound this function over a range of x.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+LogFunction::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	return(EvaluateInterval(GetOperatorType(), m_Base, GetEpsilon(), x, y));
+}
+
+/**
+ * Calculate a log of a value.
+ * @param type (input) MATH_LOG or MATH_LN.
+ * @param base (input) Base of the log for MATH_LOG.
+ * @param epsilon (input) Values and bases within this of 0 (or
+ * below) are undefined.
+ * @param x (input) x input value.
+ * @param y (output) Result value.
+ * @return TMathResult for successful calculation (or not).
+ */
+TMathResult
+LogFunction::Evaluate(
+	TOperatorType type,
+	double base,
+	double epsilon,
+	double x,
+	double *y)
 {
 	TMathResult status = MATH_SUCCESS;
 	double result = 0;
 
-	if(IsLessOrEqual(x, 0)) return MATH_UNDEFINED;
-	if(IsLessOrEqual(m_Base, 0)) return MATH_UNDEFINED;
+	if(x < 0 || IsWithin(x, 0, epsilon)) return MATH_UNDEFINED;
+	if(base < 0 || IsWithin(base, 0, epsilon)) return MATH_UNDEFINED;
 
 	//------------------------------------------------------
 	// Compute ln if called for. Otherwise use log base 10
 	// to compute for all other bases.
 	//------------------------------------------------------
-	if(m_Operator == MATH_LN)
+	if(type == MATH_LN)
 	{
 		//---------------------
 		// log function is ln.
@@ -71,9 +169,9 @@ LogFunction::CalculateY(
 		// formula to compute the value of the log.
 		//-----------------------------------------------
 		result = log10(x);
-		if(m_Base != 10.0)
+		if(base != 10.0)
 		{
-			result /= log10(m_Base);
+			result /= log10(base);
 		}
 	}
 
@@ -81,4 +179,61 @@ LogFunction::CalculateY(
 	return status;
 }
 
+/**
+ * Bound a log over a range of values. Values where the log is
+ * undefined are clipped from the range.
+ * @param type (input) MATH_LOG or MATH_LN.
+ * @param base (input) Base of the log for MATH_LOG.
+ * @param epsilon (input) Values and bases within this of 0 (or
+ * below) are undefined.
+ * @param x (input) Range of values.
+ * @param y (output) Range of logs, flagged if any values were
+ * clipped.
+ * @return MATH_UNDEFINED if every value is undefined.
+ */
+TMathResult
+LogFunction::EvaluateInterval(
+	TOperatorType type,
+	double base,
+	double epsilon,
+	const Interval& x,
+	Interval *y)
+{
+	if(base < 0 || IsWithin(base, 0, epsilon)) return MATH_UNDEFINED;
 
+	//------------------------------------------------
+	// Clip to the defined values: at least epsilon,
+	// or above 0 when epsilon is 0.
+	//------------------------------------------------
+	double lower = x.GetLower(), upper = x.GetUpper();
+	bool isClipped = false;
+	if(epsilon > 0)
+	{
+		if(upper < epsilon) return MATH_UNDEFINED;
+		if(lower < epsilon)
+		{
+			lower = epsilon;
+			isClipped = true;
+		}
+	}
+	else
+	{
+		if(upper <= 0) return MATH_UNDEFINED;
+		if(lower <= 0)
+		{
+			lower = 0;
+			isClipped = true;
+		}
+	}
+
+	Interval ln(Interval::RoundDown(log(lower)), Interval::RoundUp(log(upper)));
+	ln.SetMayBeUndefined(isClipped || x.MayBeUndefined());
+	if(type == MATH_LN)
+	{
+		*y = ln;
+		return MATH_SUCCESS;
+	}
+
+	Interval lnBase(Interval::RoundDown(log(base)), Interval::RoundUp(log(base)));
+	return(ln.Divide(lnBase, 0, y));
+}
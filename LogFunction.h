@@ -49,6 +49,101 @@ public:
 		double x,
 		double *y);
 
+	/**
+	 * Bound a log over a range of values. Values where the log is
+	 * undefined are clipped from the range.
+	 * @param type (input) MATH_LOG or MATH_LN.
+	 * @param base (input) Base of the log for MATH_LOG.
+	 * @param epsilon (input) Values and bases within this of 0 (or
+	 * below) are undefined.
+	 * @param x (input) Range of values.
+	 * @param y (output) Range of logs, flagged if any values were
+	 * clipped.
+	 * @return MATH_UNDEFINED if every value is undefined.
+	 */
+	static TMathResult
+	EvaluateInterval(
+		TOperatorType type,
+		double base,
+		double epsilon,
+		const Interval& x,
+		Interval *y);
+
+	using MathOperation::CalculateYBlock;
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate a log of a value.
+	 * @param type (input) MATH_LOG or MATH_LN.
+	 * @param base (input) Base of the log for MATH_LOG.
+	 * @param epsilon (input) Values and bases within this of 0 (or
+	 * below) are undefined.
+	 * @param x (input) x input value.
+	 * @param y (output) Result value.
+	 * @return TMathResult for successful calculation (or not).
+	 */
+	static TMathResult
+	Evaluate(
+		TOperatorType type,
+		double base,
+		double epsilon,
+		double x,
+		double *y);
+
+	/**
+	 * The only constant is the base.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return 1; };
+
+	/**
+	 * Get the base.
+	 * @param i (input) 0.
+	 * @return Base of the log.
+	 */
+	virtual double
+	GetConstant(
+		int)
+		{ return m_Base; };
+
 protected:
 	/**
 	 * What is the base of this log? Default is base 10.
@@ -187,15 +187,7 @@ MathBase::IsEqual(
 {
 	double l_epsilon = epsilon ? epsilon : GetEpsilon();
 
-	if( l_epsilon ) 
-	{
-		double diff = fabs(x-v);
-		return(diff < l_epsilon) ? true : false;
-	}
-	else
-	{
-		return(x == v);
-	}
+	return(IsWithin(x, v, l_epsilon));
 }	
 
 /**
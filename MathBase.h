@@ -10,6 +10,7 @@
 #include "MathSetting.h"
 #include "MathDefs.h"
 #include <iostream>
+#include <math.h>
 
 /**
  * Base object for all math objects
@@ -157,6 +158,21 @@ public:
 		double v,
 		double epsilon = 0) const;
 
+	/**
+ 	 * Compare values to determine if they are within an epsilon.
+	 * @param x (input) First value to compare.
+	 * @param v (input) Second value to compare.
+	 * @param epsilon (input) Compare to within this value. 
+	 * If 0, the values must match exactly.
+	 * @return True/false
+ 	 */ 
+	static bool
+	IsWithin(
+		double x,
+		double v,
+		double epsilon)
+		{ return (epsilon ? (fabs(x-v) < epsilon) : (x == v)); };
+
 	/**
  	 * Solve for x values of a quadratic equation, given coefficients
 	 * A, B and C (Ax^2 + Bx + C).
@@ -29,6 +29,12 @@ const double MATH_COS_225 = - MATH_SIN_45;
 const double MATH_SIN_315 = - MATH_SIN_45;
 const double MATH_COS_315 = MATH_SIN_45;
 
+/**
+ * Number of points evaluated together by block calculations.
+ * Sized so a block of inputs and outputs stays in the L1 cache.
+ */
+const int MATH_BLOCK_SIZE = 64;
+
 /**
  * Angles are specified in degrees or radians.
  */
@@ -41,6 +47,23 @@ typedef enum TMathResult
 	MATH_SUCCESS = 1
 } TMathResult;
 
+/**
+ * How block calculations report undefined points.
+ * MATH_ERROR_STATUS checks as each operation is applied and gives a
+ * TMathResult for each point, leaving undefined outputs unchanged.
+ * MATH_ERROR_NAN applies every operation to every point, selecting a
+ * quiet NaN where the result is undefined, and finds the TMathResults
+ * from the NaNs once at the end. It has no branches per point, so its
+ * loops vectorize and do not slow down around poles. A NaN given by a
+ * defined operation, e.g. pow(-8, 1.0/3), is undefined under
+ * MATH_ERROR_NAN.
+ */
+typedef enum TErrorPolicy
+{
+	MATH_ERROR_STATUS = 0,
+	MATH_ERROR_NAN
+} TErrorPolicy;
+
 typedef enum TOperatorType
 {
 	MATH_ADD = 0,
@@ -57,7 +80,75 @@ typedef enum TOperatorType
 	MATH_SEC,
 	MATH_CSC,
 	MATH_LOG,
-	MATH_LN
+	MATH_LN,
+	MATH_SUM,
+	MATH_PRODUCT,
+	MATH_MULADD,
+	MATH_SPLINE,
+	MATH_TRANSFORM
 } TOperatorType;
 
+/**
+ * How a power with a constant exponent or base is calculated. Chosen
+ * once when the operator is built (see SimpleOperator::ChoosePower).
+ *	MATH_POWER_GENERAL  pow(base, exponent)
+ *	MATH_POWER_WHOLE    whole exponent: repeated squaring, and a
+ *	                    reciprocal for negative exponents
+ *	MATH_POWER_HALF     exponent n + 1/2: base^n * sqrt(base), and a
+ *	                    reciprocal for negative exponents
+ *	MATH_POWER_EXP      constant base b > 0: exp(exponent * ln b)
+ */
+typedef enum TPowerMethod
+{
+	MATH_POWER_GENERAL = 0,
+	MATH_POWER_WHOLE,
+	MATH_POWER_HALF,
+	MATH_POWER_EXP
+} TPowerMethod;
+
+typedef struct TPowerStrategy
+{
+	TPowerMethod m_Method;
+	int m_Exponent;        // Whole part of |exponent|.
+	bool m_IsReciprocal;   // Exponent is negative.
+	double m_LogBase;      // ln(base) for MATH_POWER_EXP.
+} TPowerStrategy;
+
+/**
+ * Distance measures used for point searches. Orthogonal distance
+ * matches Point::DistanceOrthogonal (horizontal plus vertical travel).
+ */
+typedef enum TDistanceMetric
+{
+	MATH_DISTANCE_EUCLIDEAN = 0,
+	MATH_DISTANCE_ORTHOGONAL
+} TDistanceMetric;
+
+/**
+ * Polyline simplification methods.
+ * Douglas-Peucker keeps points farther than the tolerance from the
+ * simplified line. Visvalingam-Whyatt drops points whose triangle with
+ * their neighbours has the smallest area.
+ */
+typedef enum TSimplifyMethod
+{
+	MATH_SIMPLIFY_DOUGLAS_PEUCKER = 0,
+	MATH_SIMPLIFY_VISVALINGAM
+} TSimplifyMethod;
+
+/**
+ * How a spline joins its knots (see Spline).
+ *	MATH_SPLINE_LINEAR    straight lines
+ *	MATH_SPLINE_MONOTONE  cubic, rising or falling only where the data
+ *	                      do, with no overshoot (Fritsch-Carlson)
+ *	MATH_SPLINE_NATURAL   cubic with continuous second derivative,
+ *	                      zero at the ends
+ */
+typedef enum TSplineMethod
+{
+	MATH_SPLINE_LINEAR = 0,
+	MATH_SPLINE_MONOTONE,
+	MATH_SPLINE_NATURAL
+} TSplineMethod;
+
 #endif
@@ -7,9 +7,12 @@
 #include "MathFunction.h"
 #include "SimpleOperator.h"
 #include "Polynomial.h"
+#include "SparsePolynomial.h"
 #include "CompositeFunction.h"
 #include "TrigFunction.h"
 #include "LogFunction.h"
+#include "NaryOperator.h"
+#include <math.h>
 
 /**
  * Base class for a mathematical function.
@@ -22,6 +25,7 @@ MathFunction::MathFunction()
 {
 	m_MathSetting = NULL;
 	m_MathOperation = NULL;
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }
 
 /**
@@ -32,6 +36,7 @@ MathFunction::MathFunction(
 	TOperatorType type)
 {
 	m_MathOperation = CreateMathOperation(type, NULL, NULL, NULL, NULL, NULL);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }	
 
 /**
@@ -44,6 +49,7 @@ MathFunction::MathFunction(
 	MathFunction* rhs)
 {
 	m_MathOperation = CreateMathOperation(type, lhs, rhs, NULL, NULL, NULL);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }	
 
 /**
@@ -57,6 +63,7 @@ MathFunction::MathFunction(
 {
 	m_MathOperation = CreateMathOperation(type, NULL, rhs, 
 		leftConstant, 0, NULL);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }	
 	
 
@@ -71,6 +78,7 @@ MathFunction::MathFunction(
 {
 	m_MathOperation = CreateMathOperation(type, lhs, NULL, 
 		0, rightConstant, NULL);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }	
 
 
@@ -84,6 +92,37 @@ MathFunction::MathFunction(
 {
 	m_MathOperation = CreateMathOperation(type, NULL, NULL, 
 		0, 0, &coeffs);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
+}
+
+/**
+ * Constructor for MATH_SUM, MATH_PRODUCT and MATH_MULADD.
+ * @param oper (input) What operator is used.
+ * @param terms (input) Operand functions, NULL for a constant.
+ * @param weights (input) Weight of each operand, or the constant
+ * where the function is NULL.
+ */
+MathFunction::MathFunction(
+	TOperatorType type,
+	const std::vector<MathFunction*>& terms,
+	const std::vector<double>& weights)
+{
+	std::vector<double> coeffs = weights;
+	m_MathOperation = CreateMathOperation(type, NULL, NULL,
+		0, 0, &coeffs, &terms);
+	m_ErrorPolicy = MATH_ERROR_STATUS;
+}
+
+/**
+ * Constructor for an operation built by the caller. The function owns
+ * the operation and deletes it.
+ * @param operation (input) Operation to use.
+ */
+MathFunction::MathFunction(
+	MathOperation *operation)
+{
+	m_MathOperation = operation;
+	m_ErrorPolicy = MATH_ERROR_STATUS;
 }
 
 
@@ -276,7 +315,9 @@ MathFunction::operator^(const double value)
  * @param rhs (input) Right side function.
  * @param leftConstant (input) Left value.
  * @param rightValue (input) Right value.
- * @param coefficients (input) Coefficients for polynomial.
+ * @param coefficients (input) Coefficients for polynomial, or
+ * weights of the terms.
+ * @param terms (input) Operand functions for n-ary operators.
  */
 MathOperation*
 MathFunction::CreateMathOperation(
@@ -285,7 +326,8 @@ MathFunction::CreateMathOperation(
 	MathFunction *rhs,
 	double leftConstant,
 	double rightConstant,
-	std::vector<double> *coefficients)
+	std::vector<double> *coefficients,
+	const std::vector<MathFunction*> *terms)
 {
 	MathOperation *result = NULL;
 
@@ -304,7 +346,10 @@ MathFunction::CreateMathOperation(
 			result = new SimpleOperator(type, leftConstant, rhs);
 		break;
 	case MATH_POLYNOMIAL:
-		result = new Polynomial(*coefficients);
+		if(SparsePolynomial::IsSparse(*coefficients))
+			result = new SparsePolynomial(*coefficients);
+		else
+			result = new Polynomial(*coefficients);
 		break;
 	case MATH_COMPOSITE:
 		result = new CompositeFunction(lhs, rhs);
@@ -322,6 +367,21 @@ MathFunction::CreateMathOperation(
 	case MATH_LN:
 		result = new LogFunction(type, leftConstant);
 		break;
+
+	case MATH_SUM:
+	case MATH_PRODUCT:
+	case MATH_MULADD:
+		if(terms && coefficients)
+			result = new NaryOperator(type, *terms, *coefficients);
+		break;
+
+	//-----------------------------------------------
+	// Built from data, not from operands; give one to
+	// the MathFunction(MathOperation*) constructor.
+	//-----------------------------------------------
+	case MATH_SPLINE:
+	case MATH_TRANSFORM:
+		break;
 	}
 	if(result) result->SetOperatorType(type);
 	return result;
@@ -369,3 +429,306 @@ MathFunction::CalculateY(
 	return status;
 }
 
+
+/**
+ * Interface function to calculate a block of points for this
+ * function. Under MATH_ERROR_NAN the block is calculated without
+ * status and the status of each point found from the NaNs after.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined,
+ * or NaN if the error policy is MATH_ERROR_NAN.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+MathFunction::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	if(m_MathOperation && m_ErrorPolicy == MATH_ERROR_NAN)
+	{
+		m_MathOperation->CalculateYBlockNaN(x, y, count);
+		for(int i = 0; i < count; i++)
+		{
+			status[i] = (y[i] == y[i]) ? MATH_SUCCESS : MATH_UNDEFINED;
+		}
+		return;
+	}
+	if(m_MathOperation)
+	{
+		m_MathOperation->CalculateYBlock(x, y, status, count);
+		return;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		status[i] = MATH_UNDEFINED;
+	}
+}
+
+/**
+ * Interface function to calculate a block of points for this
+ * function with undefined points set to quiet NaN.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+MathFunction::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	if(m_MathOperation)
+	{
+		m_MathOperation->CalculateYBlockNaN(x, y, count);
+		return;
+	}
+	double nan = std::numeric_limits<double>::quiet_NaN();
+	for(int i = 0; i < count; i++)
+	{
+		y[i] = nan;
+	}
+}
+
+/**
+ * Calculate points at equally spaced x values, xStart + i * step.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+MathFunction::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	if(m_MathOperation)
+	{
+		m_MathOperation->SampleUniform(xStart, step, y, status, count);
+		return;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		status[i] = MATH_UNDEFINED;
+	}
+}
+
+/**
+ * Bound this function over a range of x without sampling.
+ * @param x (input) Range of x values.
+ * @param y (output) Range of y values.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+MathFunction::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	if(!m_MathOperation) return MATH_UNDEFINED;
+	return m_MathOperation->CalculateInterval(x, y);
+}
+
+/**
+ * Interface function to calculate a block of points for this
+ * function in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+MathFunction::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	if(m_MathOperation)
+	{
+		m_MathOperation->CalculateYBlock(x, y, status, count);
+		return;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		status[i] = MATH_UNDEFINED;
+	}
+}
+
+
+/**
+ * Interval waiting to be refined by SampleAdaptive.
+ */
+struct TSampleInterval
+{
+	double m_A, m_FA;
+	double m_B, m_FB;
+	bool m_DefinedA, m_DefinedB;
+	int m_Depth;
+};
+
+/**
+ * Sample this function over a range with as few points as a
+ * tolerance allows. Intervals are split in half until the function
+ * at the midpoint is within tolerance of the straight line between
+ * the interval's end points, so flat regions get few points and
+ * curved or steep regions get many. Undefined regions are bracketed
+ * down to the smallest interval and left out, ending the current
+ * run of points (see PointSink::EndSegment), as are jumps such as
+ * tan poles. Points are passed to the sink in increasing x order.
+ * @param xStart (input) First x value of the range.
+ * @param xEnd (input) Last x value of the range.
+ * @param tolerance (input) Largest allowed y distance between the
+ * function and the line through neighbouring points. If 0, the
+ * object's epsilon will be used.
+ * @param sink (output) Receives the points.
+ * @param initialCount (optional input) Number of equal intervals
+ * sampled before refining, so narrow features are not stepped over.
+ * @param maxDepth (optional input) Most times an initial interval
+ * may be halved.
+ * @return Number of points passed to the sink.
+ */
+int
+MathFunction::SampleAdaptive(
+	double xStart,
+	double xEnd,
+	double tolerance,
+	PointSink *sink,
+	int initialCount,
+	int maxDepth)
+{
+	int count = 0;
+	bool isOpen = false;
+	std::vector<TSampleInterval> stack;
+
+	if(!sink || !m_MathOperation || !(xEnd > xStart)) return(0);
+	if(initialCount < 1) initialCount = 1;
+	if(maxDepth < 0) maxDepth = 0;
+	if(tolerance <= 0) tolerance = GetEpsilon();
+
+	double step = (xEnd - xStart) / initialCount;
+	TSampleInterval first;
+	first.m_B = xStart;
+	first.m_DefinedB = (CalculateY(xStart, &first.m_FB) == MATH_SUCCESS);
+
+	//---------------------------------------------------
+	// The first point starts the curve if it is defined.
+	//---------------------------------------------------
+	if(first.m_DefinedB)
+	{
+		if(!sink->AddPoint(xStart, first.m_FB)) return(0);
+		count++;
+		isOpen = true;
+	}
+
+	TSampleInterval last = first;
+	for(int i = 0; i < initialCount; i++)
+	{
+		TSampleInterval interval;
+		interval.m_A = last.m_B;
+		interval.m_FA = last.m_FB;
+		interval.m_DefinedA = last.m_DefinedB;
+		interval.m_B = (i == initialCount - 1) ? xEnd : xStart + (i+1)*step;
+		interval.m_DefinedB =
+			(CalculateY(interval.m_B, &interval.m_FB) == MATH_SUCCESS);
+		interval.m_Depth = 0;
+		last = interval;
+
+		//------------------------------------------------
+		// Refine the interval depth first, left half on
+		// top of the stack, so points come out in x order.
+		//------------------------------------------------
+		stack.push_back(interval);
+		while(!stack.empty())
+		{
+			TSampleInterval cur = stack.back();
+			stack.pop_back();
+
+			double xm = 0.5 * (cur.m_A + cur.m_B);
+			double fm = 0;
+			bool definedM = (CalculateY(xm, &fm) == MATH_SUCCESS);
+			bool isLast = (cur.m_Depth >= maxDepth);
+			bool isJump = false;
+
+			if(!isLast)
+			{
+				bool isSplit = true;
+				if(cur.m_DefinedA && cur.m_DefinedB && definedM)
+				{
+					//--------------------------------------------
+					// Midpoint distance from the chord, which is
+					// half the second difference (curvature).
+					//--------------------------------------------
+					double error = fabs(fm - 0.5 * (cur.m_FA + cur.m_FB));
+					isSplit = (error > tolerance);
+				}
+				else if(!cur.m_DefinedA && !cur.m_DefinedB && !definedM)
+				{
+					//--------------------------------------
+					// Treat the whole interval as undefined.
+					//--------------------------------------
+					isSplit = false;
+				}
+
+				if(isSplit)
+				{
+					TSampleInterval left = cur, right = cur;
+					left.m_B = right.m_A = xm;
+					left.m_FB = right.m_FA = fm;
+					left.m_DefinedB = right.m_DefinedA = definedM;
+					left.m_Depth = right.m_Depth = cur.m_Depth + 1;
+					stack.push_back(right);
+					stack.push_back(left);
+					continue;
+				}
+			}
+			else if(cur.m_DefinedA && cur.m_DefinedB)
+			{
+				//-------------------------------------------------
+				// Still out of tolerance at the smallest interval.
+				// A steep but continuous function has its midpoint
+				// between the ends; anything else is a jump.
+				//-------------------------------------------------
+				double lo = (cur.m_FA < cur.m_FB) ? cur.m_FA : cur.m_FB;
+				double hi = (cur.m_FA < cur.m_FB) ? cur.m_FB : cur.m_FA;
+				double error = fabs(fm - 0.5 * (cur.m_FA + cur.m_FB));
+				isJump = !definedM ||
+					((error > tolerance) && (fm < lo || fm > hi));
+			}
+
+			//--------------------------------------------------
+			// The interval is final. Emit its right end point,
+			// starting or ending runs where definition changes.
+			//--------------------------------------------------
+			if(cur.m_DefinedB)
+			{
+				if(isJump && isOpen)
+				{
+					sink->EndSegment();
+					isOpen = false;
+				}
+				if(!isOpen && cur.m_DefinedA && !isJump)
+				{
+					if(!sink->AddPoint(cur.m_A, cur.m_FA)) return(count);
+					count++;
+				}
+				if(!sink->AddPoint(cur.m_B, cur.m_FB)) return(count);
+				count++;
+				isOpen = true;
+			}
+			else if(!cur.m_DefinedB && isOpen)
+			{
+				sink->EndSegment();
+				isOpen = false;
+			}
+		}
+	}
+
+	if(isOpen) sink->EndSegment();
+	return(count);
+}
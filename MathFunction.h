@@ -11,6 +11,7 @@
 #include <vector>
 #include "MathBase.h"
 #include "Point.h"
+#include "PointSink.h"
 #include "MathOperation.h"
 
 class MathFunction;
@@ -73,6 +74,27 @@ public:
 		TOperatorType type,
 		std::vector<double> coeffs);
 
+	/**
+	 * Constructor for MATH_SUM, MATH_PRODUCT and MATH_MULADD.
+	 * See NaryOperator.
+	 * @param oper (input) What operator is used.
+	 * @param terms (input) Operand functions, NULL for a constant.
+	 * @param weights (input) Weight of each operand, or the constant
+	 * where the function is NULL.
+	 */
+	MathFunction(
+		TOperatorType type,
+		const std::vector<MathFunction*>& terms,
+		const std::vector<double>& weights);
+
+	/**
+	 * Constructor for an operation built by the caller, such as a
+	 * FixedPolynomial. The function owns the operation and deletes it.
+	 * @param operation (input) Operation to use.
+	 */
+	MathFunction(
+		MathOperation *operation);
+
 	/**
 	 * Destructor.
 	 */
@@ -95,6 +117,32 @@ public:
 	GetMathSetting()
 		{return m_MathSetting;};
 
+	/**
+	 * Get the math operation which defines this function.
+	 * @return Pointer to the operation, NULL if none.
+	 */
+	MathOperation*
+	GetMathOperation()
+		{return m_MathOperation;};
+
+	/**
+	 * Set how block calculations report undefined points.
+	 * @param policy (input) MATH_ERROR_STATUS (the default) or
+	 * MATH_ERROR_NAN. See TErrorPolicy.
+	 */
+	void
+	SetErrorPolicy(
+		TErrorPolicy policy)
+		{m_ErrorPolicy = policy;};
+
+	/**
+	 * Get how block calculations report undefined points.
+	 * @return Error policy.
+	 */
+	TErrorPolicy
+	GetErrorPolicy()
+		{return m_ErrorPolicy;};
+
 	/**
  	 * Set Epsilon value for this object.
 	 * @param epsilon (input) Value which defines how close is equal.
@@ -221,6 +269,121 @@ public:
 	CalculateY(
 		Point *pt);
 
+	/**
+	 * Interface function to calculate a block of points for this
+	 * function.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined,
+	 * or NaN if the error policy is MATH_ERROR_NAN.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Interface function to calculate a block of points for this
+	 * function with undefined points set to quiet NaN, whatever the
+	 * error policy. Used by the operations to calculate their operands.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Interface function to calculate a block of points for this
+	 * function in single precision. About twice as fast as the double
+	 * block where the operations have float kernels. Each kernel is
+	 * good to about 1e-7 (see MathKernels.h), absolute for sin and cos,
+	 * but relative error grows near the zeros of a function: up to
+	 * about 1e-4 for a polynomial near a root or for sines of many
+	 * turns in degrees (see the table in the README).
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values, xStart + i * step.
+	 * Operations which can use the spacing do: trig functions, also of
+	 * a linear polynomial, step sine and cosine by a rotation instead
+	 * of calculating each. Results may differ from CalculateYBlock in
+	 * the last bits.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x without sampling. The
+	 * result contains f(x) for every x in the range where f is
+	 * defined, and is flagged (see Interval::MayBeUndefined) if f may
+	 * be undefined somewhere in the range, e.g. at a pole. Bounds are
+	 * guaranteed but not always tight.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Range of y values.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Sample this function over a range with as few points as a
+	 * tolerance allows. Intervals are split in half until the function
+	 * at the midpoint is within tolerance of the straight line between
+	 * the interval's end points, so flat regions get few points and
+	 * curved or steep regions get many. Undefined regions are bracketed
+	 * down to the smallest interval and left out, ending the current
+	 * run of points (see PointSink::EndSegment), as are jumps such as
+	 * tan poles. Points are passed to the sink in increasing x order.
+	 * @param xStart (input) First x value of the range.
+	 * @param xEnd (input) Last x value of the range.
+	 * @param tolerance (input) Largest allowed y distance between the
+	 * function and the line through neighbouring points. If 0, the
+	 * object's epsilon will be used.
+	 * @param sink (output) Receives the points.
+	 * @param initialCount (optional input) Number of equal intervals
+	 * sampled before refining, so narrow features are not stepped over.
+	 * @param maxDepth (optional input) Most times an initial interval
+	 * may be halved.
+	 * @return Number of points passed to the sink.
+	 */
+	int
+	SampleAdaptive(
+		double xStart,
+		double xEnd,
+		double tolerance,
+		PointSink *sink,
+		int initialCount = 16,
+		int maxDepth = 16);
+
 
 protected:
 
@@ -233,7 +396,9 @@ protected:
 	 * @param rhs (input) Right side function.
 	 * @param leftConstant (input) Left value.
 	 * @param rightValue (input) Right value.
-	 * @param coefficients (input) Coefficients for polynomial.
+	 * @param coefficients (input) Coefficients for polynomial, or
+	 * weights of the terms.
+	 * @param terms (input) Operand functions for n-ary operators.
 	 */
 	MathOperation*
 	CreateMathOperation(
@@ -242,13 +407,19 @@ protected:
 		MathFunction *rhs,
 		double leftConstant,
 		double rightConstant,
-		std::vector<double> *coefficients);
+		std::vector<double> *coefficients,
+		const std::vector<MathFunction*> *terms = NULL);
 	
 protected:
 	//----------------------------------
 	// Math operation to be performed.
 	//----------------------------------
 	MathOperation *m_MathOperation;
+
+	//-----------------------------------------------
+	// How block calculations report undefined points.
+	//-----------------------------------------------
+	TErrorPolicy m_ErrorPolicy;
 };
 
 #endif
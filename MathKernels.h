@@ -0,0 +1,1006 @@
+/**
+ * Title: MathKernels
+ * Scalar and block kernels templated on the evaluation type.
+ * @author Mary Wyllie
+ */
+
+#ifndef MATHKERNELS_H
+#define MATHKERNELS_H
+
+#include "MathDefs.h"
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits>
+
+/**
+ * The kernels below are written once for a scalar type T and used
+ * with float and double. The double scalar functions are the C
+ * library's; the float ones are branch-free polynomial versions so
+ * that the block loops over them vectorize, with 4 or 8 floats per
+ * vector where double gives 2 or 4.
+ *
+ * Float accuracy against the double path (see README):
+ *	sin, cos        ~1e-7 absolute for |angle| < 1e5 radians
+ *	log, ln         ~1e-7 relative away from x = 1, ~1e-7 absolute near it
+ *	polynomials     float rounding of the coefficients and of each
+ *	                Horner step, ~1e-7 relative per term
+ * Inputs are not checked for overflow or denormals. Decisions made
+ * against epsilon (poles, zero divisors, the log domain) use float
+ * values, so points within float rounding of the limit may be
+ * defined in one path and undefined in the other.
+ */
+
+//-----------------------------------------------------
+// Pi split so that q*KERNEL_PI_A is exact in float for
+// |q| < 2^16 (Cody-Waite reduction).
+//-----------------------------------------------------
+const float KERNEL_PI_A = 3.140625f;
+const float KERNEL_PI_B = 9.67502593994140625e-4f;
+const float KERNEL_PI_C = 1.509957990978376432e-7f;
+const float KERNEL_1_OVER_PI = 0.318309886183790671538f;
+
+//---------------------------------------------------
+// sin(r) = r + r^3 (S1 + S2 r^2 + S3 r^4 + S4 r^6)
+// on [-pi/2, pi/2], relative error below 3e-8.
+//---------------------------------------------------
+const float KERNEL_SIN_1 = -1.6666665966579486e-1f;
+const float KERNEL_SIN_2 = 8.333242336702575e-3f;
+const float KERNEL_SIN_3 = -1.982276127530284e-4f;
+const float KERNEL_SIN_4 = 2.6348152468112642e-6f;
+
+//----------------------------------------------------
+// cos(r) = 1 + r^2 (C1 + C2 r^2 + C3 r^4 + C4 r^6)
+// on [-pi/4, pi/4], error below 3e-8.
+//----------------------------------------------------
+const float KERNEL_COS_1 = -0.5f;
+const float KERNEL_COS_2 = 4.1666666666666667e-2f;
+const float KERNEL_COS_3 = -1.3888888888888889e-3f;
+const float KERNEL_COS_4 = 2.4801587301587302e-5f;
+const float KERNEL_2_OVER_PI = 0.636619772367581343076f;
+
+//----------------------------------------------------
+// Points stepped by rotation between those calculated
+// directly (see KernelSinCosUniform). MATH_BLOCK_SIZE
+// is a multiple of it.
+//----------------------------------------------------
+const int KERNEL_SINCOS_RUN = 8;
+
+//-----------------------------------------------------
+// ln(m) = 2t + t^3 (L1 + L2 t^2 + L3 t^4), t=(m-1)/(m+1)
+// for m in [sqrt(1/2), sqrt(2)], error below 1e-9.
+//-----------------------------------------------------
+const float KERNEL_LOG_1 = 6.666668851147132e-1f;
+const float KERNEL_LOG_2 = 3.9988293321725965e-1f;
+const float KERNEL_LOG_3 = 2.9593401932050584e-1f;
+const float KERNEL_LN2 = 0.693147180559945309417f;
+const float KERNEL_SQRT2 = 1.41421356237309504880f;
+
+inline double
+KernelSin(double x)
+	{ return sin(x); }
+
+inline double
+KernelCos(double x)
+	{ return cos(x); }
+
+inline double
+KernelLog(double x)
+	{ return log(x); }
+
+inline double
+KernelPow(double x, double y)
+	{ return pow(x, y); }
+
+inline float
+KernelPow(float x, float y)
+	{ return powf(x, y); }
+
+inline double
+KernelSqrt(double x)
+	{ return sqrt(x); }
+
+inline float
+KernelSqrt(float x)
+	{ return sqrtf(x); }
+
+inline double
+KernelExp(double x)
+	{ return exp(x); }
+
+inline float
+KernelExp(float x)
+	{ return expf(x); }
+
+/**
+ * a*b + c, with a single rounding where the processor has a fused
+ * multiply-add instruction. Elsewhere fma() is a slow library call,
+ * so the product is rounded first instead.
+ */
+inline double
+KernelMulAdd(double a, double b, double c)
+{
+#ifdef FP_FAST_FMA
+	return fma(a, b, c);
+#else
+	return a * b + c;
+#endif
+}
+
+inline float
+KernelMulAdd(float a, float b, float c)
+{
+#ifdef FP_FAST_FMAF
+	return fmaf(a, b, c);
+#else
+	return a * b + c;
+#endif
+}
+
+/**
+ * sin(r) for r in [-pi/2, pi/2].
+ */
+inline float
+KernelSinReduced(float r)
+{
+	float r2 = r * r;
+	return r + r * r2 * (KERNEL_SIN_1 + r2 * (KERNEL_SIN_2 +
+		r2 * (KERNEL_SIN_3 + r2 * KERNEL_SIN_4)));
+}
+
+/**
+ * Float sine. x = q pi + r with |r| <= pi/2, so sin(x) = (-1)^q sin(r).
+ */
+inline float
+KernelSin(float x)
+{
+	float q = floorf(x * KERNEL_1_OVER_PI + 0.5f);
+	float r = ((x - q * KERNEL_PI_A) - q * KERNEL_PI_B) - q * KERNEL_PI_C;
+	float s = KernelSinReduced(r);
+	return ((int) q & 1) ? -s : s;
+}
+
+/**
+ * Float cosine. x = (q + 1/2) pi + r with |r| <= pi/2, so
+ * cos(x) = (-1)^(q+1) sin(r).
+ */
+inline float
+KernelCos(float x)
+{
+	float q = floorf(x * KERNEL_1_OVER_PI);
+	float h = q + 0.5f;
+	float r = ((x - h * KERNEL_PI_A) - h * KERNEL_PI_B) - h * KERNEL_PI_C;
+	float s = KernelSinReduced(r);
+	return ((int) q & 1) ? s : -s;
+}
+
+/**
+ * cos(r) for r in [-pi/4, pi/4].
+ */
+inline float
+KernelCosReduced(float r)
+{
+	float r2 = r * r;
+	return 1.0f + r2 * (KERNEL_COS_1 + r2 * (KERNEL_COS_2 +
+		r2 * (KERNEL_COS_3 + r2 * KERNEL_COS_4)));
+}
+
+/**
+ * Sine and cosine together, sharing one range reduction. The C
+ * library's sincos gives the same values as sin and cos.
+ */
+inline void
+KernelSinCos(double x, double *s, double *c)
+{
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+	sincos(x, s, c);
+#else
+	*s = sin(x);
+	*c = cos(x);
+#endif
+}
+
+/**
+ * Float sine and cosine together. x = q pi/2 + r with |r| <= pi/4;
+ * the quadrant q picks which of sin(r) and cos(r) gives each, and
+ * its sign.
+ */
+inline void
+KernelSinCos(float x, float *s, float *c)
+{
+	float q = floorf(x * KERNEL_2_OVER_PI + 0.5f);
+	float h = q * 0.5f;
+	float r = ((x - h * KERNEL_PI_A) - h * KERNEL_PI_B) - h * KERNEL_PI_C;
+	float sr = KernelSinReduced(r);
+	float cr = KernelCosReduced(r);
+	int quadrant = (int) q & 3;
+	float sw = (quadrant & 1) ? cr : sr;
+	float cw = (quadrant & 1) ? sr : cr;
+	*s = (quadrant & 2) ? -sw : sw;
+	*c = ((quadrant + 1) & 2) ? -cw : cw;
+}
+
+/**
+ * Float natural log of a positive normal value. x = m 2^e with m in
+ * [sqrt(1/2), sqrt(2)), so ln(x) = e ln(2) + ln(m).
+ */
+inline float
+KernelLog(float x)
+{
+	int32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	int32_t e = ((bits >> 23) & 0xff) - 127;
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+
+	int32_t isHigh = (m > KERNEL_SQRT2);
+	m = isHigh ? m * 0.5f : m;
+	e += isHigh;
+
+	float t = (m - 1.0f) / (m + 1.0f);
+	float t2 = t * t;
+	float lnm = 2.0f * t + t * t2 * (KERNEL_LOG_1 + t2 * (KERNEL_LOG_2 +
+		t2 * KERNEL_LOG_3));
+	return (float) e * KERNEL_LN2 + lnm;
+}
+
+/**
+ * x to a whole power n >= 0 by repeated squaring, about 2 log2(n)
+ * multiplications.
+ */
+template <class T>
+inline T
+KernelPowWhole(T x, int n)
+{
+	T result = 1;
+	while(n)
+	{
+		if(n & 1) result *= x;
+		n >>= 1;
+		if(n) x *= x;
+	}
+	return result;
+}
+
+/**
+ * Power by a strategy chosen for a constant exponent or base. See
+ * TPowerMethod.
+ */
+template <class T>
+inline T
+KernelPower(const TPowerStrategy& power, T base, T exponent)
+{
+	T result;
+	switch(power.m_Method)
+	{
+	case MATH_POWER_WHOLE:
+		result = KernelPowWhole(base, power.m_Exponent);
+		return power.m_IsReciprocal ? 1 / result : result;
+	case MATH_POWER_HALF:
+		result = KernelPowWhole(base, power.m_Exponent) * KernelSqrt(base);
+		return power.m_IsReciprocal ? 1 / result : result;
+	case MATH_POWER_EXP:
+		return KernelExp(exponent * (T) power.m_LogBase);
+	default:
+		return KernelPow(base, exponent);
+	}
+}
+
+/**
+ * Is x within epsilon of v? See MathBase::IsWithin.
+ */
+template <class T>
+inline bool
+KernelIsWithin(T x, T v, T epsilon)
+{
+	T d = (x < v) ? (v - x) : (x - v);
+	return epsilon ? (d < epsilon) : (x == v);
+}
+
+/**
+ * Is x within epsilon of 0? The same test as KernelIsWithin(x, 0,
+ * epsilon), written without branches so loops over it vectorize.
+ */
+template <class T>
+inline bool
+KernelIsNearZero(T x, T epsilon)
+	{ return ((x < epsilon) & (x > -epsilon)) | (x == 0); }
+
+/**
+ * Quiet NaN, marking an undefined point under MATH_ERROR_NAN.
+ */
+template <class T>
+inline T
+KernelNaN()
+	{ return std::numeric_limits<T>::quiet_NaN(); }
+
+/**
+ * Polynomial at a block of points, by Horner's rule one coefficient
+ * at a time across the block. Always defined.
+ * @param coefficients (input) Coefficient for each power of x, lowest
+ * first. May be of a wider type than the points.
+ */
+template <class C, class T>
+void
+KernelPolynomialBlock(
+	const C *coefficients,
+	int count,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	for(int j = 0; j < n; j++)
+	{
+		y[j] = 0;
+		status[j] = MATH_SUCCESS;
+	}
+	for(int i = count - 1; i >= 0; i--)
+	{
+		T c = (T) coefficients[i];
+		#pragma omp simd
+		for(int j = 0; j < n; j++)
+		{
+			y[j] = y[j] * x[j] + c;
+		}
+	}
+}
+
+/**
+ * Whole power n >= 0 of a block of up to MATH_BLOCK_SIZE points, by
+ * repeated squaring across the block.
+ */
+template <class T>
+void
+KernelPowWholeBlock(
+	const T *x,
+	int n,
+	T *y,
+	int count)
+{
+	T base[MATH_BLOCK_SIZE];
+	for(int j = 0; j < count; j++)
+	{
+		y[j] = 1;
+		base[j] = x[j];
+	}
+	while(n)
+	{
+		if(n & 1)
+		{
+			#pragma omp simd
+			for(int j = 0; j < count; j++) y[j] *= base[j];
+		}
+		n >>= 1;
+		if(n)
+		{
+			#pragma omp simd
+			for(int j = 0; j < count; j++) base[j] *= base[j];
+		}
+	}
+}
+
+/**
+ * Sparse polynomial at a block of up to MATH_BLOCK_SIZE points, by
+ * Horner's rule over the terms: each step multiplies by x to the gap
+ * between neighbouring exponents instead of by x once per power.
+ * Always defined.
+ * @param exponents (input) Exponent of each term, increasing.
+ * @param coefficients (input) Coefficient of each term. May be of a
+ * wider type than the points.
+ * @param terms (input) Number of terms.
+ */
+template <class C, class T>
+void
+KernelSparsePolynomialBlock(
+	const int *exponents,
+	const C *coefficients,
+	int terms,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	T power[MATH_BLOCK_SIZE];
+	T top = (terms > 0) ? (T) coefficients[terms - 1] : 0;
+	for(int j = 0; j < n; j++)
+	{
+		y[j] = top;
+		status[j] = MATH_SUCCESS;
+	}
+	for(int i = terms - 2; i >= 0; i--)
+	{
+		T c = (T) coefficients[i];
+		int gap = exponents[i + 1] - exponents[i];
+		if(gap == 1)
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = y[j] * x[j] + c;
+		}
+		else
+		{
+			KernelPowWholeBlock(x, gap, power, n);
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = y[j] * power[j] + c;
+		}
+	}
+	if(terms > 0 && exponents[0] > 0)
+	{
+		KernelPowWholeBlock(x, exponents[0], power, n);
+		for(int j = 0; j < n; j++) y[j] *= power[j];
+	}
+}
+
+/**
+ * Segment of a spline holding x: the last of knots[0] ... knots[count - 2]
+ * not above x, or 0 below them all. A binary search whose step is a
+ * conditional move rather than a branch, so it costs the same
+ * log2(count) loads for every x and none are mispredicted.
+ * @param knots (input) Knot x values, increasing.
+ * @param count (input) Number of knots, at least 2.
+ */
+inline int
+KernelSplineSearch(
+	const double *knots,
+	int count,
+	double x)
+{
+	const double *base = knots;
+	int size = count - 1;
+	while(size > 1)
+	{
+		int half = size / 2;
+		base = (base[half] <= x) ? base + half : base;
+		size -= half;
+	}
+	return (int) (base - knots);
+}
+
+/**
+ * Spline at a block of up to MATH_BLOCK_SIZE points. Constants are laid
+ * out as Spline::GetConstant gives them. Uniform knots find every
+ * segment by one multiply, then a step either way where the knots are
+ * off their places by rounding; otherwise the block steps through the
+ * binary search together, one gather per point per step. Points outside
+ * the knots are undefined.
+ * @param constants (input) Knot count, inverse spacing, knots and
+ * segment coefficients.
+ */
+template <class T>
+void
+KernelSplineBlock(
+	const double *constants,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	int count = (int) constants[0];
+	if(count < 2)
+	{
+		for(int j = 0; j < n; j++) status[j] = MATH_UNDEFINED;
+		return;
+	}
+
+	double inverseStep = constants[1];
+	const double *knots = constants + 2;
+	const double *segments = knots + count;
+	double first = knots[0], last = knots[count - 1];
+	double lastSegment = count - 2;
+	int index[MATH_BLOCK_SIZE];
+
+	if(inverseStep)
+	{
+		#pragma omp simd
+		for(int j = 0; j < n; j++)
+		{
+			double u = ((double) x[j] - first) * inverseStep;
+			u = (u > 0) ? u : 0;
+			u = (u < lastSegment) ? u : lastSegment;
+			int i = (int) u;
+			i -= ((i > 0) & ((double) x[j] < knots[i])) ? 1 : 0;
+			i += ((i < count - 2) & ((double) x[j] >= knots[i + 1])) ? 1 : 0;
+			index[j] = i;
+		}
+	}
+	else
+	{
+		for(int j = 0; j < n; j++) index[j] = 0;
+		for(int size = count - 1; size > 1; )
+		{
+			int half = size / 2;
+			#pragma omp simd
+			for(int j = 0; j < n; j++)
+			{
+				index[j] += (knots[index[j] + half] <= (double) x[j]) ? half : 0;
+			}
+			size -= half;
+		}
+	}
+
+	#pragma omp simd
+	for(int j = 0; j < n; j++)
+	{
+		const double *s = segments + 4 * index[j];
+		T t = (T) ((double) x[j] - knots[index[j]]);
+		T value = (T) s[0] + t * ((T) s[1] + t * ((T) s[2] + t * (T) s[3]));
+		bool isInside = ((double) x[j] >= first) & ((double) x[j] <= last);
+		y[j] = isInside ? value : y[j];
+		status[j] = isInside ? MATH_SUCCESS : MATH_UNDEFINED;
+	}
+}
+
+/**
+ * Angle in radians of a point. Degrees are brought into [-180, 180]
+ * before converting, so that whole turns do not add rounding error to
+ * the angle. Every trig path converts with this, so all of them find
+ * the same zeros and poles.
+ * @param isDegrees (input) The point is in degrees.
+ */
+template <class T>
+inline T
+KernelAngle(
+	bool isDegrees,
+	T x)
+{
+	if(!isDegrees) return x;
+	x -= (T) 360 * floor(x * ((T) 1 / 360) + (T) 0.5);
+	return x * (T) MATH_PI_OVER_180;
+}
+
+/**
+ * Angles in radians for a block of points (see KernelAngle).
+ * @param isDegrees (input) Points are in degrees.
+ */
+template <class T>
+void
+KernelAngleBlock(
+	bool isDegrees,
+	const T *x,
+	T *angle,
+	int n)
+{
+	if(!isDegrees)
+	{
+		for(int j = 0; j < n; j++) angle[j] = x[j];
+		return;
+	}
+	#pragma omp simd
+	for(int j = 0; j < n; j++)
+	{
+		angle[j] = KernelAngle(true, x[j]);
+	}
+}
+
+/**
+ * Sine and cosine of a block of angles in radians, with one range
+ * reduction for both.
+ */
+template <class T>
+void
+KernelSinCosBlock(
+	const T *angle,
+	T *s,
+	T *c,
+	int n)
+{
+	#pragma omp simd
+	for(int j = 0; j < n; j++)
+	{
+		KernelSinCos(angle[j], &s[j], &c[j]);
+	}
+}
+
+/**
+ * Sine and cosine at up to MATH_BLOCK_SIZE equally spaced points,
+ * x = xStart + (first + i) * step. The first of every
+ * KERNEL_SINCOS_RUN points is calculated directly, and the rest by
+ * rotating the point before through the step angle d:
+ *
+ *	s' = s - (a s - b c), c' = c - (a c + b s)
+ *	a = 2 sin^2(d/2) = 1 - cos(d), b = sin(d)
+ *
+ * which loses less to rounding than multiplying by cos(d) when d is
+ * small. Error grows with the number of rotations, so runs are kept
+ * short; they are stepped together so that the loop vectorizes.
+ * @param isDegrees (input) Points are in degrees.
+ * @param s (output) Sines, room for MATH_BLOCK_SIZE.
+ * @param c (output) Cosines, room for MATH_BLOCK_SIZE.
+ */
+inline void
+KernelSinCosUniform(
+	double xStart,
+	double step,
+	int first,
+	bool isDegrees,
+	double *s,
+	double *c,
+	int n)
+{
+	double scale = isDegrees ? MATH_PI_OVER_180 : 1;
+	double half = sin(0.5 * step * scale);
+	double a = 2 * half * half;
+	double b = sin(step * scale);
+	int runs = (n + KERNEL_SINCOS_RUN - 1) / KERNEL_SINCOS_RUN;
+
+	for(int r = 0; r < runs; r++)
+	{
+		int i = r * KERNEL_SINCOS_RUN;
+		double x = xStart + (double) (first + i) * step;
+		KernelSinCos(KernelAngle(isDegrees, x), &s[i], &c[i]);
+	}
+	for(int k = 1; k < KERNEL_SINCOS_RUN; k++)
+	{
+		#pragma omp simd
+		for(int r = 0; r < runs; r++)
+		{
+			int i = r * KERNEL_SINCOS_RUN + k;
+			double sp = s[i - 1], cp = c[i - 1];
+			s[i] = sp - (a * sp - b * cp);
+			c[i] = cp - (a * cp + b * sp);
+		}
+	}
+}
+
+/**
+ * Trig function at up to MATH_BLOCK_SIZE points from the sine and
+ * cosine of the angles. tan and cot are their quotient; the functions
+ * with poles are undefined where the value checked against epsilon
+ * (see TrigFunction::Evaluate) is within it of 0. Points whose status
+ * is already undefined are left alone.
+ * @param s (input) Sines, only read if the function needs them.
+ * @param c (input) Cosines, only read if the function needs them.
+ * @param status (input/output) Status of the angles on input, of the
+ * results on output.
+ */
+template <class T>
+void
+KernelTrigFromSinCos(
+	TOperatorType type,
+	T epsilon,
+	const T *s,
+	const T *c,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	bool hasPoles = (type == MATH_COT || type == MATH_SEC || type == MATH_CSC);
+	bool isTrig = (type >= MATH_SIN && type <= MATH_CSC);
+	T result[MATH_BLOCK_SIZE], divisor[MATH_BLOCK_SIZE];
+
+	//------------------------------------------------
+	// The divisor is the value checked against epsilon
+	// for the functions with poles.
+	//------------------------------------------------
+	switch(type)
+	{
+	case MATH_SIN:
+		for(int j = 0; j < n; j++) result[j] = s[j];
+		break;
+	case MATH_COS:
+		for(int j = 0; j < n; j++) result[j] = c[j];
+		break;
+	case MATH_TAN:
+		for(int j = 0; j < n; j++) result[j] = s[j] / c[j];
+		break;
+	case MATH_COT:
+		for(int j = 0; j < n; j++)
+		{
+			divisor[j] = s[j] / c[j];
+			result[j] = c[j] / s[j];
+		}
+		break;
+	case MATH_SEC:
+		for(int j = 0; j < n; j++)
+		{
+			divisor[j] = c[j];
+			result[j] = 1 / c[j];
+		}
+		break;
+	case MATH_CSC:
+		for(int j = 0; j < n; j++)
+		{
+			divisor[j] = s[j];
+			result[j] = 1 / s[j];
+		}
+		break;
+	default:
+		break;
+	}
+
+	for(int j = 0; j < n; j++)
+	{
+		if(status[j] != MATH_SUCCESS) continue;
+		bool isDefined = isTrig &&
+			!(hasPoles && KernelIsWithin(divisor[j], (T) 0, epsilon));
+		status[j] = isDefined ? MATH_SUCCESS : MATH_UNDEFINED;
+		if(isDefined) y[j] = result[j];
+	}
+}
+
+/**
+ * Trig function at a block of points. See TrigFunction::Evaluate.
+ * Functions needing both sine and cosine get them from one range
+ * reduction.
+ * @param isDegrees (input) Points are in degrees.
+ */
+template <class T>
+void
+KernelTrigBlock(
+	TOperatorType type,
+	bool isDegrees,
+	T epsilon,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	bool needsSin = (type != MATH_COS && type != MATH_SEC);
+	bool needsCos = (type != MATH_SIN && type != MATH_CSC);
+	T s[MATH_BLOCK_SIZE], c[MATH_BLOCK_SIZE], angle[MATH_BLOCK_SIZE];
+
+	for(int start = 0; start < n; start += MATH_BLOCK_SIZE)
+	{
+		int m = (n - start < MATH_BLOCK_SIZE) ? n - start : MATH_BLOCK_SIZE;
+
+		KernelAngleBlock(isDegrees, x + start, angle, m);
+		if(needsSin && needsCos)
+		{
+			KernelSinCosBlock(angle, s, c, m);
+		}
+		else if(needsSin)
+		{
+			#pragma omp simd
+			for(int j = 0; j < m; j++) s[j] = KernelSin(angle[j]);
+		}
+		else
+		{
+			#pragma omp simd
+			for(int j = 0; j < m; j++) c[j] = KernelCos(angle[j]);
+		}
+
+		for(int j = 0; j < m; j++) status[start + j] = MATH_SUCCESS;
+		KernelTrigFromSinCos(type, epsilon, s, c, y + start, status + start, m);
+	}
+}
+
+/**
+ * Log at a block of points, with the change of base already worked
+ * out.
+ * @param scale (input) 1 for ln, 1 / ln(base) otherwise.
+ * @param isBaseDefined (input) False if every point is undefined.
+ */
+template <class T>
+void
+KernelLogScaledBlock(
+	T scale,
+	bool isBaseDefined,
+	T epsilon,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	T result[MATH_BLOCK_SIZE];
+
+	for(int start = 0; start < n; start += MATH_BLOCK_SIZE)
+	{
+		int m = (n - start < MATH_BLOCK_SIZE) ? n - start : MATH_BLOCK_SIZE;
+		const T *xb = x + start;
+
+		#pragma omp simd
+		for(int j = 0; j < m; j++)
+		{
+			result[j] = KernelLog(xb[j]) * scale;
+		}
+
+		for(int j = 0; j < m; j++)
+		{
+			bool isDefined = isBaseDefined &&
+				!(xb[j] < 0 || KernelIsWithin(xb[j], (T) 0, epsilon));
+			status[start + j] = isDefined ? MATH_SUCCESS : MATH_UNDEFINED;
+			if(isDefined) y[start + j] = result[j];
+		}
+	}
+}
+
+/**
+ * Log at a block of points. See LogFunction::Evaluate.
+ * @param base (input) Base for MATH_LOG.
+ */
+template <class T>
+void
+KernelLogBlock(
+	TOperatorType type,
+	double base,
+	T epsilon,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int n)
+{
+	bool isBaseDefined = !(base < 0 || KernelIsWithin(base, 0.0, (double) epsilon));
+	T scale = (type == MATH_LN) ? (T) 1 : (T) (1.0 / log(base));
+	KernelLogScaledBlock(scale, isBaseDefined, epsilon, x, y, status, n);
+}
+
+/**
+ * Binary operator at a block of points. See SimpleOperator::Apply.
+ * Points whose status is already undefined are left alone.
+ * @param left (input) Left operands (bases for MATH_POWER).
+ * @param right (input) Right operands (exponents for MATH_POWER).
+ * @param status (input/output) Status of the operands on input, of
+ * the results on output.
+ * @param power (optional input) How to calculate MATH_POWER, pow if
+ * NULL.
+ */
+template <class T>
+void
+KernelApplyBlock(
+	TOperatorType type,
+	T epsilon,
+	const T *left,
+	const T *right,
+	T *y,
+	TMathResult *status,
+	int n,
+	const TPowerStrategy *power = NULL)
+{
+	for(int j = 0; j < n; j++)
+	{
+		if(status[j] != MATH_SUCCESS) continue;
+		switch(type)
+		{
+		case MATH_ADD: y[j] = left[j] + right[j]; break;
+		case MATH_SUBTRACT: y[j] = left[j] - right[j]; break;
+		case MATH_MULTIPLY: y[j] = left[j] * right[j]; break;
+		case MATH_DIVIDE:
+			if(KernelIsWithin(right[j], (T) 0, epsilon))
+				status[j] = MATH_UNDEFINED;
+			else
+				y[j] = left[j] / right[j];
+			break;
+		case MATH_POWER:
+			y[j] = power ? KernelPower(*power, left[j], right[j]) :
+				KernelPow(left[j], right[j]);
+			break;
+		default: status[j] = MATH_UNDEFINED; break;
+		}
+	}
+}
+
+/**
+ * Binary operator at a block of points, with undefined operands and
+ * results as NaN (see TErrorPolicy). Every point is calculated, and
+ * NaN selected where the result is undefined.
+ * @param left (input) Left operands (bases for MATH_POWER).
+ * @param right (input) Right operands (exponents for MATH_POWER).
+ * @param power (optional input) How to calculate MATH_POWER, pow if
+ * NULL.
+ */
+template <class T>
+void
+KernelApplyBlockNaN(
+	TOperatorType type,
+	T epsilon,
+	const T *left,
+	const T *right,
+	T *y,
+	int n,
+	const TPowerStrategy *power = NULL)
+{
+	T nan = KernelNaN<T>();
+
+	switch(type)
+	{
+	case MATH_ADD:
+		#pragma omp simd
+		for(int j = 0; j < n; j++) y[j] = left[j] + right[j];
+		break;
+	case MATH_SUBTRACT:
+		#pragma omp simd
+		for(int j = 0; j < n; j++) y[j] = left[j] - right[j];
+		break;
+	case MATH_MULTIPLY:
+		#pragma omp simd
+		for(int j = 0; j < n; j++) y[j] = left[j] * right[j];
+		break;
+	case MATH_DIVIDE:
+		#pragma omp simd
+		for(int j = 0; j < n; j++)
+		{
+			T q = left[j] / right[j];
+			y[j] = KernelIsNearZero(right[j], epsilon) ? nan : q;
+		}
+		break;
+	case MATH_POWER:
+		//-------------------------------------------------
+		// pow(1, NaN) and pow(NaN, 0) are 1, so undefined
+		// operands have to be selected out explicitly.
+		//-------------------------------------------------
+		for(int j = 0; j < n; j++)
+		{
+			T p = power ? KernelPower(*power, left[j], right[j]) :
+				KernelPow(left[j], right[j]);
+			y[j] = (left[j] != left[j] || right[j] != right[j]) ? nan : p;
+		}
+		break;
+	default:
+		for(int j = 0; j < n; j++) y[j] = nan;
+		break;
+	}
+}
+
+/**
+ * One operand of a sum, product or multiply-add at a block of points.
+ * Operands are taken in order; each is a weight times a value. See
+ * NaryOperator.
+ * @param i (input) Index of the operand.
+ * @param weight (input) Weight of the operand.
+ * @param values (input) Value of the operand at each point.
+ * @param y (input/output) Result so far.
+ * @param factor (input/output) First factor of a multiply-add, kept
+ * between operands.
+ */
+template <class T>
+void
+KernelNaryStep(
+	TOperatorType type,
+	int i,
+	T weight,
+	const T *values,
+	T *y,
+	T *factor,
+	int n)
+{
+	switch(type)
+	{
+	case MATH_SUM:
+		if(i == 0)
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = weight * values[j];
+		}
+		else
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = KernelMulAdd(weight, values[j], y[j]);
+		}
+		break;
+	case MATH_PRODUCT:
+		if(i == 0)
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = weight * values[j];
+		}
+		else
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] *= weight * values[j];
+		}
+		break;
+	case MATH_MULADD:
+		if(i == 0)
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) factor[j] = weight * values[j];
+		}
+		else if(i == 1)
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++) y[j] = weight * values[j];
+		}
+		else
+		{
+			#pragma omp simd
+			for(int j = 0; j < n; j++)
+				y[j] = KernelMulAdd(factor[j], y[j], weight * values[j]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+#endif
@@ -8,7 +8,12 @@
 #define MATHOPERATION_H
 
 #include <string>
+#include <vector>
+#include <limits>
 #include "MathBase.h"
+#include "Interval.h"
+
+class MathFunction;
 
 
 /**
@@ -58,6 +63,154 @@ public:
 	CalculateY(
 		double x, double *y) = 0;
 
+	/**
+	 * Virtual function to calculate a block of points for this function.
+	 * Operations override this where working on many points at once
+	 * is faster than one at a time.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count)
+		{ for(int i = 0; i < count; i++) status[i] = CalculateY(x[i], &y[i]); };
+
+	/**
+	 * Virtual function to calculate a block of points for this function
+	 * in single precision. Operations override this with float kernels
+	 * (see MathKernels.h); by default each point is calculated in
+	 * double and rounded.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			double result;
+			status[i] = CalculateY(x[i], &result);
+			if(status[i] == MATH_SUCCESS) y[i] = (float) result;
+		}
+	};
+
+	/**
+	 * Virtual function to calculate a block of points for this function
+	 * with undefined points set to quiet NaN rather than given a status
+	 * (see TErrorPolicy). Operations override this with loops which
+	 * have no branches per point; by default the block is calculated
+	 * with status and the undefined points replaced.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count)
+	{
+		TMathResult status[MATH_BLOCK_SIZE];
+		double nan = std::numeric_limits<double>::quiet_NaN();
+		for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+		{
+			int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+			CalculateYBlock(x + start, y + start, status, n);
+			for(int j = 0; j < n; j++)
+			{
+				if(status[j] != MATH_SUCCESS) y[start + j] = nan;
+			}
+		}
+	};
+
+	/**
+	 * Virtual function to calculate points at equally spaced x values,
+	 * xStart + i * step. Operations override this where the spacing
+	 * allows a faster method than calculating each point; by default
+	 * the x values are formed a block at a time and passed to
+	 * CalculateYBlock.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count)
+	{
+		double x[MATH_BLOCK_SIZE];
+		for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+		{
+			int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+			for(int j = 0; j < n; j++) x[j] = xStart + (double) (start + j) * step;
+			CalculateYBlock(x, y + start, status + start, n);
+		}
+	};
+
+	/**
+	 * Virtual function to bound this function over a range of x.
+	 * Operations override this; by default nothing is known.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) for every x in the range where f
+	 * is defined, flagged if f may be undefined somewhere in it.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval&,
+		Interval *y)
+	{
+		*y = Interval::Entire();
+		y->SetMayBeUndefined(true);
+		return MATH_SUCCESS;
+	};
+
+	/**
+	 * Get the functions this operation is built from. Each operation
+	 * type lists them in a fixed order; operands which are not
+	 * functions are given as NULL.
+	 * @param children (output) Operand functions.
+	 */
+	virtual void
+	GetChildren(
+		std::vector<MathFunction*> *children)
+		{ children->clear(); };
+
+	/**
+	 * Get the number of constants this operation holds. Each operation
+	 * type lists them in a fixed order.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return 0; };
+
+	/**
+	 * Get a constant of this operation.
+	 * @param i (input) Index of the constant.
+	 * @return Constant value.
+	 */
+	virtual double
+	GetConstant(
+		int)
+		{ return 0; };
+
 protected:
 	/**
 	 * The type of this operation
@@ -5,6 +5,7 @@
  */
 
 #include "MathSetting.h"
+#include "MathBase.h"
 
 /**
  * Class for alternate epsilon and angleMode.
@@ -15,10 +16,12 @@
 */
 
 /**
- * Constructor.
+ * Constructor. Starts from the global epsilon and angle mode.
  * @return None.
  */	
-MathSetting::MathSetting() 
+MathSetting::MathSetting() :
+	m_Epsilon(MathBase::GetGlobalEpsilon()),
+	m_IsDegrees(MathBase::GetGlobalAngleMode())
 {
 }
 
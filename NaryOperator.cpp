@@ -0,0 +1,348 @@
+/**
+ * Title: NaryOperator
+ * Sum, product or multiply-add of any number of functions.
+ * @author Mary Wyllie
+ */
+
+#include "NaryOperator.h"
+#include "TrigFunction.h"
+#include "MathKernels.h"
+
+/**
+ * Constructor.
+ */
+NaryOperator::NaryOperator()
+{
+	m_Operator = MATH_SUM;
+	m_HasSharedTrig = false;
+}
+
+/**
+ * Constructor.
+ * @param oper (input) MATH_SUM, MATH_PRODUCT or MATH_MULADD.
+ * @param terms (input) Operand functions, NULL for a constant.
+ * @param weights (input) Weight of each operand, or the constant
+ * where the function is NULL. Missing weights are 1.
+ */
+NaryOperator::NaryOperator(
+	TOperatorType oper,
+	const std::vector<MathFunction*>& terms,
+	const std::vector<double>& weights) :
+	m_Terms(terms),
+	m_Weights(weights)
+{
+	m_Operator = oper;
+	m_Weights.resize(m_Terms.size(), 1.0);
+
+	m_HasSharedTrig = false;
+	for(size_t i = 0; i < m_Terms.size() && !m_HasSharedTrig; i++)
+	{
+		for(size_t k = i + 1; k < m_Terms.size(); k++)
+		{
+			if(TrigFunction::IsSameArgument(m_Terms[i], m_Terms[k]))
+			{
+				m_HasSharedTrig = true;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Destructor.
+ */
+NaryOperator::~NaryOperator()
+{
+}
+
+/**
+ * Virtual function to calculate a point for this function.
+ * @param x (input) x input value for this function.
+ * @return Y value corresponding to the x input.
+ */
+TMathResult
+NaryOperator::CalculateY(
+	double x,
+	double *y)
+{
+	int count = (int) m_Terms.size();
+	if(GetOperatorType() == MATH_MULADD && count != 3) return MATH_UNDEFINED;
+
+	double buffer[MATH_BLOCK_SIZE];
+	std::vector<double> more;
+	double *values = buffer;
+	if(count > MATH_BLOCK_SIZE)
+	{
+		more.resize(count);
+		values = &more[0];
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		values[i] = 1;
+		if(m_Terms[i] && m_Terms[i]->CalculateY(x, &values[i]) != MATH_SUCCESS)
+			return MATH_UNDEFINED;
+	}
+
+	*y = Evaluate(GetOperatorType(), values,
+		m_Weights.empty() ? NULL : &m_Weights[0], count);
+	return MATH_SUCCESS;
+}
+
+/**
+ * Calculate a block of points, one operand at a time across the
+ * block.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+NaryOperator::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		EvaluateBlock(x + start, y + start, status + start, n);
+	}
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+NaryOperator::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		EvaluateBlock(x + start, y + start, status + start, n);
+	}
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. An
+ * undefined operand's NaN carries through the sum or product.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+NaryOperator::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	int terms = (int) m_Terms.size();
+	double values[MATH_BLOCK_SIZE], factor[MATH_BLOCK_SIZE], result[MATH_BLOCK_SIZE];
+	double ones[MATH_BLOCK_SIZE];
+	double empty = (GetOperatorType() == MATH_PRODUCT) ? 1 : 0;
+
+	if(GetOperatorType() == MATH_MULADD && terms != 3)
+	{
+		for(int i = 0; i < count; i++) y[i] = KernelNaN<double>();
+		return;
+	}
+	for(int j = 0; j < MATH_BLOCK_SIZE; j++) ones[j] = 1;
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+
+		for(int j = 0; j < n; j++) result[j] = empty;
+		for(int i = 0; i < terms; i++)
+		{
+			if(m_Terms[i]) m_Terms[i]->CalculateYBlockNaN(x + start, values, n);
+			KernelNaryStep(GetOperatorType(), i, m_Weights[i],
+				m_Terms[i] ? values : ones, result, factor, n);
+		}
+		for(int j = 0; j < n; j++) y[start + j] = result[j];
+	}
+}
+
+/**
+ * Calculate a block of up to MATH_BLOCK_SIZE points for either
+ * scalar type. The result is built up in a buffer so that y is left
+ * unchanged where undefined.
+ */
+template <class T>
+void
+NaryOperator::EvaluateBlock(
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count)
+{
+	int terms = (int) m_Terms.size();
+	T values[MATH_BLOCK_SIZE], factor[MATH_BLOCK_SIZE], result[MATH_BLOCK_SIZE];
+	T ones[MATH_BLOCK_SIZE];
+	TMathResult termStatus[MATH_BLOCK_SIZE];
+	T empty = (GetOperatorType() == MATH_PRODUCT) ? 1 : 0;
+
+	if(GetOperatorType() == MATH_MULADD && terms != 3)
+	{
+		for(int j = 0; j < count; j++) status[j] = MATH_UNDEFINED;
+		return;
+	}
+
+	for(int j = 0; j < count; j++)
+	{
+		result[j] = empty;
+		ones[j] = 1;
+		status[j] = MATH_SUCCESS;
+	}
+
+	//------------------------------------------------
+	// With shared trig operands every operand is
+	// calculated first, so that those of the same
+	// argument can be calculated together.
+	//------------------------------------------------
+	std::vector<T> shared;
+	std::vector<TMathResult> sharedStatus;
+	if(m_HasSharedTrig)
+	{
+		std::vector<T*> pointers(terms);
+		std::vector<TMathResult*> statuses(terms);
+		shared.resize(terms * count);
+		sharedStatus.resize(terms * count);
+		for(int i = 0; i < terms; i++)
+		{
+			pointers[i] = &shared[i * count];
+			statuses[i] = &sharedStatus[i * count];
+		}
+		TrigFunction::CalculateShared(&m_Terms[0], terms, x,
+			&pointers[0], &statuses[0], count);
+	}
+
+	for(int i = 0; i < terms; i++)
+	{
+		const T *operand = ones;
+		if(m_Terms[i])
+		{
+			const TMathResult *operandStatus = termStatus;
+			if(m_HasSharedTrig)
+			{
+				operand = &shared[i * count];
+				operandStatus = &sharedStatus[i * count];
+			}
+			else
+			{
+				m_Terms[i]->CalculateYBlock(x, values, termStatus, count);
+				operand = values;
+			}
+			for(int j = 0; j < count; j++)
+			{
+				if(operandStatus[j] != MATH_SUCCESS) status[j] = MATH_UNDEFINED;
+			}
+		}
+		KernelNaryStep(GetOperatorType(), i, (T) m_Weights[i], operand,
+			result, factor, count);
+	}
+
+	for(int j = 0; j < count; j++)
+	{
+		if(status[j] == MATH_SUCCESS) y[j] = result[j];
+	}
+}
+
+/**
+ * Bound this function over a range of x, from the bounds of the
+ * operands.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+NaryOperator::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	int count = (int) m_Terms.size();
+	TOperatorType type = GetOperatorType();
+	if(type == MATH_MULADD && count != 3) return MATH_UNDEFINED;
+
+	Interval result((type == MATH_PRODUCT) ? 1.0 : 0.0);
+	Interval factor;
+	for(int i = 0; i < count; i++)
+	{
+		Interval operand(1);
+		if(m_Terms[i])
+		{
+			TMathResult status = m_Terms[i]->CalculateInterval(x, &operand);
+			if(status != MATH_SUCCESS) return status;
+		}
+		operand = operand * Interval(m_Weights[i]);
+
+		if(type == MATH_SUM)
+			result = (i == 0) ? operand : result + operand;
+		else if(type == MATH_PRODUCT)
+			result = (i == 0) ? operand : result * operand;
+		else if(i == 0)
+			factor = operand;
+		else if(i == 1)
+			result = factor * operand;
+		else
+			result = result + operand;
+	}
+	*y = result;
+	return MATH_SUCCESS;
+}
+
+/**
+ * Combine operand values. Sums use four accumulators, and products
+ * two, so that successive operations do not depend on each other.
+ * @param type (input) MATH_SUM, MATH_PRODUCT or MATH_MULADD.
+ * @param values (input) Value of each operand's function, 1 where
+ * the operand is a constant.
+ * @param weights (input) Weight of each operand.
+ * @param count (input) Number of operands.
+ * @return Result value.
+ */
+double
+NaryOperator::Evaluate(
+	TOperatorType type,
+	const double *values,
+	const double *weights,
+	int count)
+{
+	switch(type)
+	{
+	case MATH_SUM:
+		{
+			double sum[4] = {0, 0, 0, 0};
+			for(int i = 0; i < count; i++)
+			{
+				sum[i & 3] = KernelMulAdd(weights[i], values[i], sum[i & 3]);
+			}
+			return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+		}
+	case MATH_PRODUCT:
+		{
+			double product[2] = {1, 1};
+			for(int i = 0; i < count; i++)
+			{
+				product[i & 1] *= weights[i] * values[i];
+			}
+			return product[0] * product[1];
+		}
+	case MATH_MULADD:
+		if(count != 3) break;
+		return KernelMulAdd(weights[0] * values[0], weights[1] * values[1],
+			weights[2] * values[2]);
+	default:
+		break;
+	}
+	return 0;
+}
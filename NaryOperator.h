@@ -0,0 +1,195 @@
+/**
+ * Title: NaryOperator
+ * Sum, product or multiply-add of any number of functions.
+ * @author Mary Wyllie
+ */
+
+#ifndef NARYOPERATOR_H
+#define NARYOPERATOR_H
+
+#include "MathFunction.h"
+#include "MathOperation.h"
+#include <vector>
+
+/**
+ * Class for an operator on a list of operands, each a weight times a
+ * function, or just the weight where the function is NULL:
+ *
+ *	MATH_SUM      w0 f0 + w1 f1 + ... + wn fn
+ *	MATH_PRODUCT  w0 f0 * w1 f1 * ... * wn fn
+ *	MATH_MULADD   w0 f0 * w1 f1 + w2 f2 (exactly three operands)
+ *
+ * One node replaces a chain of binary SimpleOperator nodes, such as
+ * those FunctionRewriter::Flatten collapses. Sums and multiply-adds
+ * use fused multiply-add instructions where the processor has them,
+ * and scalar sums are split over several accumulators so additions
+ * do not wait on each other. Results may therefore differ from the
+ * chain of binary operators in the last bits.
+ *
+ * Operands which are trig functions of the same argument, such as
+ * 2 sin(x) + 3 cos(x), are calculated together from one sine and
+ * cosine (see TrigFunction::CalculateShared).
+ *
+ * The result is undefined wherever an operand is undefined.
+ */
+class
+NaryOperator :
+	public MathOperation
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	NaryOperator();
+
+	/**
+	 * Constructor.
+	 * @param oper (input) MATH_SUM, MATH_PRODUCT or MATH_MULADD.
+	 * @param terms (input) Operand functions, NULL for a constant.
+	 * @param weights (input) Weight of each operand, or the constant
+	 * where the function is NULL. Missing weights are 1.
+	 */
+	NaryOperator(
+		TOperatorType oper,
+		const std::vector<MathFunction*>& terms,
+		const std::vector<double>& weights);
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~NaryOperator();
+
+	/**
+	 * Virtual function to calculate a point for this function.
+	 * @param x (input) x input value for this function.
+	 * @return Y value corresponding to the x input.
+	 */
+	virtual TMathResult
+	CalculateY(
+		double x,
+		double *y);
+
+	/**
+	 * Calculate a block of points, one operand at a time across the
+	 * block.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Combine operand values.
+	 * @param type (input) MATH_SUM, MATH_PRODUCT or MATH_MULADD.
+	 * @param values (input) Value of each operand's function, 1 where
+	 * the operand is a constant.
+	 * @param weights (input) Weight of each operand.
+	 * @param count (input) Number of operands.
+	 * @return Result value.
+	 */
+	static double
+	Evaluate(
+		TOperatorType type,
+		const double *values,
+		const double *weights,
+		int count);
+
+	/**
+	 * Get the operand functions, NULL for a constant operand.
+	 * @param children (output) Operand functions.
+	 */
+	virtual void
+	GetChildren(
+		std::vector<MathFunction*> *children)
+		{ *children = m_Terms; };
+
+	/**
+	 * Constants are the weights of the operands, in order.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return (int) m_Weights.size(); };
+
+	/**
+	 * Get the weight of an operand.
+	 * @param i (input) Index of the operand.
+	 * @return Weight.
+	 */
+	virtual double
+	GetConstant(
+		int i)
+		{ return m_Weights[i]; };
+
+protected:
+
+	/**
+	 * Calculate a block of up to MATH_BLOCK_SIZE points for either
+	 * scalar type.
+	 */
+	template <class T>
+	void
+	EvaluateBlock(
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count);
+
+protected:
+	std::vector<MathFunction*> m_Terms;
+	std::vector<double> m_Weights;
+
+	//------------------------------------------
+	// Two or more operands are trig functions of
+	// the same argument (see TrigFunction), so
+	// they can share one sine and cosine.
+	//------------------------------------------
+	bool m_HasSharedTrig;
+};
+
+#endif
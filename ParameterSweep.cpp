@@ -0,0 +1,145 @@
+/**
+ * Title: ParameterSweep
+ * Functions evaluated for many sets of parameter values over the same
+ * x values.
+ * @author Mary Wyllie
+ */
+
+#include "ParameterSweep.h"
+
+/**
+ * Constructor.
+ */
+ParameterSweep::ParameterSweep()
+{
+}
+
+/**
+ * Destructor.
+ */
+ParameterSweep::~ParameterSweep()
+{
+}
+
+/**
+ * Calculate every function for every set of parameter values at every
+ * point. The constants and node plans of each set are prepared first,
+ * then the sets and tiles of x are shared between threads along
+ * whichever there are more of.
+ * @param parameters (input) GetParameterCount() values for each set in
+ * turn.
+ * @param sets (input) Number of sets of parameter values.
+ * @param x (input) x input values.
+ * @param y (output) y output values, count for each set and function
+ * in turn. Left unchanged where undefined.
+ * @param status (output) TMathResult for each value, laid out as y.
+ * @param count (input) Number of points.
+ */
+void
+ParameterSweep::CalculateYSweep(
+	const double *parameters,
+	int sets,
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count) const
+{
+	if(!m_Header || sets <= 0 || count <= 0) return;
+
+	int functions = GetFunctionCount();
+	int parameterCount = GetParameterCount();
+	size_t constantCount = (size_t) GetConstantCount();
+	size_t nodeCount = (size_t) m_Header->m_NodeCount;
+	int tiles = (count + MATH_BLOCK_SIZE - 1) / MATH_BLOCK_SIZE;
+	bool isParallel = ((double) sets * functions * count >= MATH_BATCH_PARALLEL);
+
+	//-----------------------------------------------
+	// Everything which depends only on the parameter
+	// values, once for each set.
+	//-----------------------------------------------
+	std::vector<double> constants(sets * constantCount + 1);
+	std::vector<TImagePlan> plans(sets * nodeCount + 1);
+	for(int set = 0; set < sets; set++)
+	{
+		double *bound = &constants[set * constantCount];
+		BindParameters(parameters + (size_t) set * parameterCount, bound);
+		PreparePlans(bound, &plans[set * nodeCount]);
+	}
+
+	if(!isParallel)
+	{
+		SweepRange(0, sets, 0, tiles, &constants[0], &plans[0], x, y,
+			status, count);
+		return;
+	}
+
+	if(sets >= tiles)
+	{
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int set = 0; set < sets; set++)
+		{
+			SweepRange(set, set + 1, 0, tiles, &constants[0], &plans[0], x, y,
+				status, count);
+		}
+	}
+	else
+	{
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int tile = 0; tile < tiles; tile++)
+		{
+			SweepRange(0, sets, tile, tile + 1, &constants[0], &plans[0], x, y,
+				status, count);
+		}
+	}
+}
+
+/**
+ * Calculate every function for a range of sets over a range of tiles
+ * of x. Nodes used more than once are kept for each set and tile, as
+ * in a BatchEvaluator group.
+ * @param firstSet (input) First set.
+ * @param lastSet (input) One past the last set.
+ * @param firstTile (input) First tile.
+ * @param lastTile (input) One past the last tile.
+ * @param constants (input) Bound constants of every set.
+ * @param plans (input) Node plans of every set.
+ */
+void
+ParameterSweep::SweepRange(
+	int firstSet,
+	int lastSet,
+	int firstTile,
+	int lastTile,
+	const double *constants,
+	const TImagePlan *plans,
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count) const
+{
+	int functions = GetFunctionCount();
+	size_t constantCount = (size_t) GetConstantCount();
+	size_t nodeCount = (size_t) m_Header->m_NodeCount;
+	TImageCache<double> cache;
+	PrepareCache(0, functions, &cache);
+
+	for(int set = firstSet; set < lastSet; set++)
+	{
+		const double *image = constants + set * constantCount;
+		cache.m_Plans = plans + set * nodeCount;
+
+		for(int tile = firstTile; tile < lastTile; tile++)
+		{
+			int start = tile * MATH_BLOCK_SIZE;
+			int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+			cache.m_X = x + start;
+			cache.m_Tile++;
+			for(int function = 0; function < functions; function++)
+			{
+				size_t offset = ((size_t) set * functions + function) * count + start;
+				EvaluateNodeBlock(m_Roots[function], x + start, y + offset,
+					status + offset, n, image, &cache);
+			}
+		}
+	}
+}
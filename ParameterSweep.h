@@ -0,0 +1,101 @@
+/**
+ * Title: ParameterSweep
+ * Functions evaluated for many sets of parameter values over the same
+ * x values.
+ * @author Mary Wyllie
+ */
+
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include "BatchEvaluator.h"
+
+/**
+ * Evaluates a function built with named parameters (see
+ * FunctionImage::Build and BindParameters) for every one of a set of
+ * parameter vectors at every one of a set of x values, giving a table
+ * of results with a row for each parameter vector.
+ *
+ * What depends only on the parameters is worked out once per vector
+ * before any x is calculated: the constants with the parameters bound,
+ * how each power is calculated (a whole exponent by repeated squaring,
+ * a constant base by exp) and each log's change of base. x is then
+ * taken a tile of MATH_BLOCK_SIZE points at a time. With more vectors
+ * than tiles, each thread takes a vector and runs it over every tile;
+ * otherwise each thread takes a tile and runs every vector over it, so
+ * the tile stays in the first level cache.
+ *
+ *	ParameterSweep sweep;
+ *	sweep.Build(functions, parameters);
+ *	sweep.CalculateYSweep(&values[0], sets, x, &y[0], &status[0], count);
+ *
+ * An image of several functions is swept as one: each vector gives a
+ * row of results for each function in turn.
+ */
+class
+ParameterSweep :
+	public BatchEvaluator
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	ParameterSweep();
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~ParameterSweep();
+
+	/**
+	 * Calculate every function for every set of parameter values at
+	 * every point.
+	 * @param parameters (input) GetParameterCount() values for each
+	 * set in turn.
+	 * @param sets (input) Number of sets of parameter values.
+	 * @param x (input) x input values.
+	 * @param y (output) y output values, count for each set and
+	 * function in turn: function f of set s at x[j] is
+	 * y[(s * GetFunctionCount() + f) * count + j]. Left unchanged
+	 * where undefined.
+	 * @param status (output) TMathResult for each value, laid out as y.
+	 * @param count (input) Number of points.
+	 */
+	void
+	CalculateYSweep(
+		const double *parameters,
+		int sets,
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count) const;
+
+protected:
+
+	/**
+	 * Calculate every function for a range of sets over a range of
+	 * tiles of x, each set over every tile before the next set.
+	 * @param firstSet (input) First set.
+	 * @param lastSet (input) One past the last set.
+	 * @param firstTile (input) First tile.
+	 * @param lastTile (input) One past the last tile.
+	 * @param constants (input) Bound constants of every set.
+	 * @param plans (input) Node plans of every set.
+	 */
+	void
+	SweepRange(
+		int firstSet,
+		int lastSet,
+		int firstTile,
+		int lastTile,
+		const double *constants,
+		const TImagePlan *plans,
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count) const;
+};
+
+#endif
@@ -0,0 +1,454 @@
+/**
+ * Title: PointIndex.cpp
+ * Description: Spatial index (k-d tree) for searches over a point set.
+ * @author Mary Wyllie
+ */
+
+#include "PointIndex.h"
+#include <algorithm>
+#include <math.h>
+
+/**
+ * Orders tree positions by one coordinate array.
+ */
+struct PointIndexLess
+{
+	const double *m_Coord;
+
+	bool
+	operator()(int a, int b) const
+		{ return m_Coord[a] < m_Coord[b]; };
+};
+
+/**
+ * Constructor.
+ * @param setting (optional input) setting (optional epsilon/angleMode).
+ * @return None.
+ */
+PointIndex::PointIndex(
+	MathSetting *setting) :
+	MathBase(setting)
+{
+}
+
+/**
+ * Destructor.
+ */
+PointIndex::~PointIndex()
+{
+}
+
+/**
+ * Build the index over a set of points. Any previous contents are
+ * discarded. The set is copied, so it may change afterwards.
+ * @param points (input) Points to index.
+ */
+void
+PointIndex::Build(const PointSet& points)
+{
+	int count = points.GetSize();
+
+	m_X.assign(points.GetXData(), points.GetXData() + count);
+	m_Y.assign(points.GetYData(), points.GetYData() + count);
+	m_Index.resize(count);
+	m_Axis.assign(count, 0);
+	for(int i = 0; i < count; i++)
+	{
+		m_Index[i] = i;
+	}
+
+	//------------------------------------------------------
+	// Arrange the index permutation into tree order, then
+	// gather the coordinates so searches read them in order.
+	//------------------------------------------------------
+	BuildRange(0, count);
+
+	std::vector<double> x(count), y(count);
+	for(int i = 0; i < count; i++)
+	{
+		x[i] = m_X[m_Index[i]];
+		y[i] = m_Y[m_Index[i]];
+	}
+	m_X.swap(x);
+	m_Y.swap(y);
+}
+
+/**
+ * Order a range of the tree arrays around its median.
+ * Splits on whichever axis has the larger spread over the range.
+ * @param lo (input) First position of the range.
+ * @param hi (input) One past the last position of the range.
+ */
+void
+PointIndex::BuildRange(
+	int lo,
+	int hi)
+{
+	if(hi - lo <= LEAF_SIZE) return;
+
+	double minX = m_X[m_Index[lo]], maxX = minX;
+	double minY = m_Y[m_Index[lo]], maxY = minY;
+	for(int i = lo + 1; i < hi; i++)
+	{
+		double x = m_X[m_Index[i]];
+		double y = m_Y[m_Index[i]];
+		if(x < minX) minX = x;
+		if(x > maxX) maxX = x;
+		if(y < minY) minY = y;
+		if(y > maxY) maxY = y;
+	}
+
+	int mid = (lo + hi) / 2;
+	char axis = ((maxY - minY) > (maxX - minX)) ? 1 : 0;
+	PointIndexLess less;
+	less.m_Coord = axis ? &m_Y[0] : &m_X[0];
+
+	std::nth_element(m_Index.begin() + lo, m_Index.begin() + mid,
+		m_Index.begin() + hi, less);
+	m_Axis[mid] = axis;
+
+	BuildRange(lo, mid);
+	BuildRange(mid + 1, hi);
+}
+
+/**
+ * Distance key between a search point and a tree position.
+ * Euclidean keys are squared distances so no sqrt is needed
+ * while searching.
+ */
+double
+PointIndex::DistanceKey(
+	int i,
+	double x,
+	double y,
+	TDistanceMetric metric) const
+{
+	double dx = m_X[i] - x;
+	double dy = m_Y[i] - y;
+	if(metric == MATH_DISTANCE_ORTHOGONAL)
+	{
+		return(fabs(dx) + fabs(dy));
+	}
+	return(dx*dx + dy*dy);
+}
+
+/**
+ * Find the single nearest point.
+ * @param x (input) X coordinate of search point.
+ * @param y (input) Y coordinate of search point.
+ * @param distance (optional output) Distance to the nearest point.
+ * @param metric (optional input) Distance measure to use.
+ * @return Index of the nearest point, -1 if the index is empty.
+ */
+int
+PointIndex::FindNearest(
+	double x,
+	double y,
+	double *distance,
+	TDistanceMetric metric) const
+{
+	std::vector<int> indices;
+	std::vector<double> distances;
+
+	if(!FindNearest(x, y, 1, &indices, &distances, metric)) return(-1);
+	if(distance) *distance = distances[0];
+	return(indices[0]);
+}
+
+/**
+ * Find the k nearest points.
+ * @param x (input) X coordinate of search point.
+ * @param y (input) Y coordinate of search point.
+ * @param k (input) Number of points to find.
+ * @param indices (output) Point indices, nearest first.
+ * @param distances (optional output) Distance to each point found.
+ * @param metric (optional input) Distance measure to use.
+ * @return Number of points found (less than k for small sets).
+ */
+int
+PointIndex::FindNearest(
+	double x,
+	double y,
+	int k,
+	std::vector<int> *indices,
+	std::vector<double> *distances,
+	TDistanceMetric metric) const
+{
+	std::vector< std::pair<double, int> > heap;
+
+	indices->clear();
+	if(distances) distances->clear();
+	if(k <= 0 || m_Index.empty()) return(0);
+
+	heap.reserve(k + 1);
+	SearchNearest(0, GetSize(), x, y, k, metric, &heap);
+	std::sort_heap(heap.begin(), heap.end());
+
+	for(int i = 0; i < (int) heap.size(); i++)
+	{
+		indices->push_back(m_Index[heap[i].second]);
+		if(distances)
+		{
+			double key = heap[i].first;
+			distances->push_back(
+				(metric == MATH_DISTANCE_ORTHOGONAL) ? key : sqrt(key));
+		}
+	}
+	return((int) heap.size());
+}
+
+/**
+ * Search a range of the tree for the k nearest points.
+ * The heap holds (distance key, position) pairs, farthest on top.
+ */
+void
+PointIndex::SearchNearest(
+	int lo,
+	int hi,
+	double x,
+	double y,
+	int k,
+	TDistanceMetric metric,
+	std::vector< std::pair<double, int> > *heap) const
+{
+	int count = hi - lo;
+	if(count <= 0) return;
+
+	//-----------------------------------------
+	// Small ranges and the splitting point are
+	// offered to the heap directly.
+	//-----------------------------------------
+	int mid = (lo + hi) / 2;
+	int first = (count <= LEAF_SIZE) ? lo : mid;
+	int last = (count <= LEAF_SIZE) ? hi : mid + 1;
+	for(int i = first; i < last; i++)
+	{
+		double key = DistanceKey(i, x, y, metric);
+		if((int) heap->size() < k)
+		{
+			heap->push_back(std::make_pair(key, i));
+			std::push_heap(heap->begin(), heap->end());
+		}
+		else if(key < heap->front().first)
+		{
+			std::pop_heap(heap->begin(), heap->end());
+			heap->back() = std::make_pair(key, i);
+			std::push_heap(heap->begin(), heap->end());
+		}
+	}
+	if(count <= LEAF_SIZE) return;
+
+	//-------------------------------------------------
+	// Descend the side holding the search point first,
+	// then the other side only if the splitting line
+	// is closer than the farthest point kept so far.
+	//-------------------------------------------------
+	double diff = m_Axis[mid] ? (y - m_Y[mid]) : (x - m_X[mid]);
+	double planeKey = (metric == MATH_DISTANCE_ORTHOGONAL) ?
+		fabs(diff) : diff*diff;
+
+	if(diff < 0)
+	{
+		SearchNearest(lo, mid, x, y, k, metric, heap);
+		if((int) heap->size() < k || planeKey < heap->front().first)
+			SearchNearest(mid + 1, hi, x, y, k, metric, heap);
+	}
+	else
+	{
+		SearchNearest(mid + 1, hi, x, y, k, metric, heap);
+		if((int) heap->size() < k || planeKey < heap->front().first)
+			SearchNearest(lo, mid, x, y, k, metric, heap);
+	}
+}
+
+/**
+ * Find all points within a distance of the search point.
+ * @param x (input) X coordinate of search point.
+ * @param y (input) Y coordinate of search point.
+ * @param radius (input) Largest distance to include.
+ * @param indices (output) Point indices, in no particular order.
+ * @param metric (optional input) Distance measure to use.
+ * @return Number of points found.
+ */
+int
+PointIndex::FindWithinRadius(
+	double x,
+	double y,
+	double radius,
+	std::vector<int> *indices,
+	TDistanceMetric metric) const
+{
+	indices->clear();
+	if(radius < 0) return(0);
+
+	double key = (metric == MATH_DISTANCE_ORTHOGONAL) ?
+		radius : radius*radius;
+	SearchRadius(0, GetSize(), x, y, key, metric, indices);
+
+	for(int i = 0; i < (int) indices->size(); i++)
+	{
+		(*indices)[i] = m_Index[(*indices)[i]];
+	}
+	return((int) indices->size());
+}
+
+/**
+ * Search a range of the tree for points within a distance key.
+ */
+void
+PointIndex::SearchRadius(
+	int lo,
+	int hi,
+	double x,
+	double y,
+	double key,
+	TDistanceMetric metric,
+	std::vector<int> *indices) const
+{
+	int count = hi - lo;
+	if(count <= 0) return;
+
+	if(count <= LEAF_SIZE)
+	{
+		for(int i = lo; i < hi; i++)
+		{
+			if(DistanceKey(i, x, y, metric) <= key) indices->push_back(i);
+		}
+		return;
+	}
+
+	int mid = (lo + hi) / 2;
+	if(DistanceKey(mid, x, y, metric) <= key) indices->push_back(mid);
+
+	double diff = m_Axis[mid] ? (y - m_Y[mid]) : (x - m_X[mid]);
+	double planeKey = (metric == MATH_DISTANCE_ORTHOGONAL) ?
+		fabs(diff) : diff*diff;
+
+	if(diff <= 0 || planeKey <= key)
+		SearchRadius(lo, mid, x, y, key, metric, indices);
+	if(diff >= 0 || planeKey <= key)
+		SearchRadius(mid + 1, hi, x, y, key, metric, indices);
+}
+
+/**
+ * Find all points equal to the search point. Equality uses the
+ * same test as Point::operator==, each coordinate within this
+ * object's epsilon.
+ * @param x (input) X coordinate of search point.
+ * @param y (input) Y coordinate of search point.
+ * @param indices (output) Point indices, in no particular order.
+ * @return Number of points found.
+ */
+int
+PointIndex::FindEqual(
+	double x,
+	double y,
+	std::vector<int> *indices) const
+{
+	indices->clear();
+	SearchBox(0, GetSize(), x, y, GetEpsilon(), indices);
+
+	for(int i = 0; i < (int) indices->size(); i++)
+	{
+		(*indices)[i] = m_Index[(*indices)[i]];
+	}
+	return((int) indices->size());
+}
+
+/**
+ * Search a range of the tree for points inside a box.
+ */
+void
+PointIndex::SearchBox(
+	int lo,
+	int hi,
+	double x,
+	double y,
+	double epsilon,
+	std::vector<int> *indices) const
+{
+	int count = hi - lo;
+	if(count <= 0) return;
+
+	int mid = (lo + hi) / 2;
+	int first = (count <= LEAF_SIZE) ? lo : mid;
+	int last = (count <= LEAF_SIZE) ? hi : mid + 1;
+	for(int i = first; i < last; i++)
+	{
+		if(IsEqual(m_X[i], x, epsilon) && IsEqual(m_Y[i], y, epsilon))
+			indices->push_back(i);
+	}
+	if(count <= LEAF_SIZE) return;
+
+	double diff = m_Axis[mid] ? (y - m_Y[mid]) : (x - m_X[mid]);
+	if(diff <= epsilon)
+		SearchBox(lo, mid, x, y, epsilon, indices);
+	if(diff >= -epsilon)
+		SearchBox(mid + 1, hi, x, y, epsilon, indices);
+}
+
+/**
+ * Find the k nearest points for each of a set of search points.
+ * @param queries (input) Search points.
+ * @param k (input) Number of points to find for each search point.
+ * @param indices (output) queries.GetSize() * k point indices,
+ * row per search point, nearest first. Unfilled entries are -1.
+ * @param distances (optional output) Distances laid out as indices.
+ * @param metric (optional input) Distance measure to use.
+ */
+void
+PointIndex::FindNearestBatch(
+	const PointSet& queries,
+	int k,
+	std::vector<int> *indices,
+	std::vector<double> *distances,
+	TDistanceMetric metric) const
+{
+	int count = queries.GetSize();
+	if(k < 0) k = 0;
+
+	indices->assign(count * k, -1);
+	if(distances) distances->assign(count * k, 0);
+
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int q = 0; q < count; q++)
+	{
+		std::vector<int> found;
+		std::vector<double> dist;
+		int n = FindNearest(queries.GetX(q), queries.GetY(q), k,
+			&found, distances ? &dist : NULL, metric);
+		for(int i = 0; i < n; i++)
+		{
+			(*indices)[q*k + i] = found[i];
+			if(distances) (*distances)[q*k + i] = dist[i];
+		}
+	}
+}
+
+/**
+ * Find all points within a distance of each of a set of search
+ * points.
+ * @param queries (input) Search points.
+ * @param radius (input) Largest distance to include.
+ * @param results (output) One list of point indices per search point.
+ * @param metric (optional input) Distance measure to use.
+ */
+void
+PointIndex::FindWithinRadiusBatch(
+	const PointSet& queries,
+	double radius,
+	std::vector< std::vector<int> > *results,
+	TDistanceMetric metric) const
+{
+	int count = queries.GetSize();
+
+	results->clear();
+	results->resize(count);
+
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int q = 0; q < count; q++)
+	{
+		FindWithinRadius(queries.GetX(q), queries.GetY(q), radius,
+			&(*results)[q], metric);
+	}
+}
@@ -0,0 +1,241 @@
+/**
+ * Title: PointIndex.h
+ * Description: Spatial index (k-d tree) for searches over a point set.
+ * @author Mary Wyllie
+ */
+
+#ifndef POINTINDEX_H
+#define POINTINDEX_H 1
+
+#include "MathBase.h"
+#include "PointSet.h"
+#include <vector>
+
+/**
+ * Spatial index built over a PointSet.
+ * Points are arranged as a balanced k-d tree so nearest neighbour,
+ * radius and equality searches visit only the nearby part of the set
+ * instead of computing a distance to every point. Results are given
+ * as indices into the PointSet the index was built from.
+ *
+ * Searches do not modify the index, so a built index may be queried
+ * from several threads at once. The batch calls split their queries
+ * across threads when OpenMP is enabled.
+ */
+class PointIndex :
+	public MathBase
+{
+public:
+
+	/**
+ 	 * Constructor.
+ 	 * @param setting (optional input) setting (optional epsilon/angleMode).
+ 	 * @return None.
+ 	 */
+	PointIndex(
+		MathSetting *setting = NULL);
+
+	/**
+ 	 * Destructor.
+ 	 */
+	virtual
+	~PointIndex();
+
+	/**
+ 	 * Build the index over a set of points. Any previous contents are
+ 	 * discarded. The set is copied, so it may change afterwards.
+ 	 * @param points (input) Points to index.
+ 	 */
+	void
+	Build(const PointSet& points);
+
+	/**
+ 	 * GetSize
+ 	 * @return Number of points in the index.
+ 	 */
+	int
+	GetSize() const
+		{ return((int) m_Index.size()); };
+
+	/**
+ 	 * Find the single nearest point.
+ 	 * @param x (input) X coordinate of search point.
+ 	 * @param y (input) Y coordinate of search point.
+ 	 * @param distance (optional output) Distance to the nearest point.
+ 	 * @param metric (optional input) Distance measure to use.
+ 	 * @return Index of the nearest point, -1 if the index is empty.
+ 	 */
+	int
+	FindNearest(
+		double x,
+		double y,
+		double *distance = NULL,
+		TDistanceMetric metric = MATH_DISTANCE_EUCLIDEAN) const;
+
+	/**
+ 	 * Find the k nearest points.
+ 	 * @param x (input) X coordinate of search point.
+ 	 * @param y (input) Y coordinate of search point.
+ 	 * @param k (input) Number of points to find.
+ 	 * @param indices (output) Point indices, nearest first.
+ 	 * @param distances (optional output) Distance to each point found.
+ 	 * @param metric (optional input) Distance measure to use.
+ 	 * @return Number of points found (less than k for small sets).
+ 	 */
+	int
+	FindNearest(
+		double x,
+		double y,
+		int k,
+		std::vector<int> *indices,
+		std::vector<double> *distances = NULL,
+		TDistanceMetric metric = MATH_DISTANCE_EUCLIDEAN) const;
+
+	/**
+ 	 * Find all points within a distance of the search point.
+ 	 * @param x (input) X coordinate of search point.
+ 	 * @param y (input) Y coordinate of search point.
+ 	 * @param radius (input) Largest distance to include.
+ 	 * @param indices (output) Point indices, in no particular order.
+ 	 * @param metric (optional input) Distance measure to use.
+ 	 * @return Number of points found.
+ 	 */
+	int
+	FindWithinRadius(
+		double x,
+		double y,
+		double radius,
+		std::vector<int> *indices,
+		TDistanceMetric metric = MATH_DISTANCE_EUCLIDEAN) const;
+
+	/**
+ 	 * Find all points equal to the search point. Equality uses the
+ 	 * same test as Point::operator==, each coordinate within this
+ 	 * object's epsilon.
+ 	 * @param x (input) X coordinate of search point.
+ 	 * @param y (input) Y coordinate of search point.
+ 	 * @param indices (output) Point indices, in no particular order.
+ 	 * @return Number of points found.
+ 	 */
+	int
+	FindEqual(
+		double x,
+		double y,
+		std::vector<int> *indices) const;
+
+	/**
+ 	 * Find the k nearest points for each of a set of search points.
+ 	 * @param queries (input) Search points.
+ 	 * @param k (input) Number of points to find for each search point.
+ 	 * @param indices (output) queries.GetSize() * k point indices,
+ 	 * row per search point, nearest first. Unfilled entries are -1.
+ 	 * @param distances (optional output) Distances laid out as indices.
+ 	 * @param metric (optional input) Distance measure to use.
+ 	 */
+	void
+	FindNearestBatch(
+		const PointSet& queries,
+		int k,
+		std::vector<int> *indices,
+		std::vector<double> *distances = NULL,
+		TDistanceMetric metric = MATH_DISTANCE_EUCLIDEAN) const;
+
+	/**
+ 	 * Find all points within a distance of each of a set of search
+ 	 * points.
+ 	 * @param queries (input) Search points.
+ 	 * @param radius (input) Largest distance to include.
+ 	 * @param results (output) One list of point indices per search point.
+ 	 * @param metric (optional input) Distance measure to use.
+ 	 */
+	void
+	FindWithinRadiusBatch(
+		const PointSet& queries,
+		double radius,
+		std::vector< std::vector<int> > *results,
+		TDistanceMetric metric = MATH_DISTANCE_EUCLIDEAN) const;
+
+protected:
+
+	/**
+ 	 * Order a range of the tree arrays around its median.
+ 	 * @param lo (input) First position of the range.
+ 	 * @param hi (input) One past the last position of the range.
+ 	 */
+	void
+	BuildRange(
+		int lo,
+		int hi);
+
+	/**
+ 	 * Search a range of the tree for the k nearest points.
+ 	 * The heap holds (distance key, position) pairs, farthest on top.
+ 	 */
+	void
+	SearchNearest(
+		int lo,
+		int hi,
+		double x,
+		double y,
+		int k,
+		TDistanceMetric metric,
+		std::vector< std::pair<double, int> > *heap) const;
+
+	/**
+ 	 * Search a range of the tree for points within a distance key.
+ 	 */
+	void
+	SearchRadius(
+		int lo,
+		int hi,
+		double x,
+		double y,
+		double key,
+		TDistanceMetric metric,
+		std::vector<int> *indices) const;
+
+	/**
+ 	 * Search a range of the tree for points inside a box.
+ 	 */
+	void
+	SearchBox(
+		int lo,
+		int hi,
+		double x,
+		double y,
+		double epsilon,
+		std::vector<int> *indices) const;
+
+	/**
+ 	 * Distance key between a search point and a tree position.
+ 	 * Euclidean keys are squared distances so no sqrt is needed
+ 	 * while searching.
+ 	 */
+	double
+	DistanceKey(
+		int i,
+		double x,
+		double y,
+		TDistanceMetric metric) const;
+
+protected:
+
+	/**
+ 	 * Ranges this small are scanned rather than split.
+ 	 */
+	static const int LEAF_SIZE = 8;
+
+	/**
+ 	 * Tree arrays. Each range [lo, hi) of more than LEAF_SIZE points
+ 	 * is split at its middle position, which holds the median point
+ 	 * along m_Axis (0 = x, 1 = y). Lower points are to the left of
+ 	 * the middle and higher points to the right.
+ 	 */
+	std::vector<double> m_X;
+	std::vector<double> m_Y;
+	std::vector<int> m_Index;
+	std::vector<char> m_Axis;
+
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Title: PointSet.cpp
+ * Description: Math object for collections of points.
+ * @author Mary Wyllie
+ */
+
+#include "PointSet.h"
+#include <stdio.h>
+
+/**
+ * Collection of points for bulk math computations.
+ */
+
+/**
+ * Constructor.
+ * @param setting (optional input) setting (optional epsilon/angleMode).
+ * @return None.
+ */
+PointSet::PointSet(
+	MathSetting *setting) :
+	MathBase(setting)
+{
+}
+
+/**
+ * Destructor.
+ */
+PointSet::~PointSet()
+{
+}
+
+/**
+ * Reserve room for a number of points.
+ * @param count (input) Expected number of points.
+ */
+void
+PointSet::Reserve(int count)
+{
+	m_X.reserve(count);
+	m_Y.reserve(count);
+}
+
+/**
+ * Remove all points from the set.
+ */
+void
+PointSet::Clear()
+{
+	m_X.clear();
+	m_Y.clear();
+}
+
+/**
+ * Creates string output of the object. Output occurs in MathBase.
+ */
+void
+PointSet::PrintObject(char* stringToPrintObject)
+{
+	if( stringToPrintObject ) {
+		MathBase::PrintObject(stringToPrintObject);
+	}
+	else {
+		char buff[100];
+		for(int i = 0; i < GetSize(); i++)
+		{
+			sprintf(buff, "(%f, %f)", m_X[i], m_Y[i]);
+			MathBase::PrintObject(buff);
+		}
+	}
+}
@@ -0,0 +1,167 @@
+/**
+ * Title: PointSet.h
+ * Description: Class for a collection of points in the cartesian
+ * coordinate system.
+ * @author Mary Wyllie
+ */
+
+#ifndef POINTSET_H
+#define POINTSET_H 1
+
+#include "MathBase.h"
+#include "Point.h"
+#include "PointSink.h"
+#include <vector>
+
+/**
+ * Collection of points for bulk math computations.
+ * Coordinates are held in separate x and y arrays rather than as
+ * Point objects, so large sets stay compact and can be scanned
+ * without touching the per-point setting data.
+ * A PointSet is also a PointSink, so it can collect streamed points.
+ */
+class PointSet :
+	public MathBase,
+	public PointSink
+{
+public:
+
+	/**
+ 	 * Constructor.
+ 	 * @param setting (optional input) setting (optional epsilon/angleMode).
+ 	 * @return None.
+ 	 */
+	PointSet(
+		MathSetting *setting = NULL);
+
+	/**
+ 	 * Destructor.
+ 	 */
+	virtual
+	~PointSet();
+
+	/**
+ 	 * Add a point to the end of the set.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 */
+	void
+	Add(
+		double x,
+		double y)
+		{ m_X.push_back(x); m_Y.push_back(y); };
+
+	/**
+ 	 * Add a point to the end of the set.
+ 	 * @param pt (input) Existing point.
+ 	 */
+	void
+	Add(const Point& pt)
+		{ Add(pt.GetX(), pt.GetY()); };
+
+	/**
+ 	 * Receive a streamed point by adding it to the set.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 * @return True, a set always accepts more points.
+ 	 */
+	virtual bool
+	AddPoint(
+		double x,
+		double y)
+		{ Add(x, y); return(true); };
+
+	/**
+ 	 * GetSize
+ 	 * @return Number of points in the set.
+ 	 */
+	int
+	GetSize() const
+		{ return((int) m_X.size()); };
+
+	/**
+ 	 * GetX
+ 	 * @param i (input) Index of point.
+ 	 * @return X value of point.
+ 	 */
+	double
+	GetX(int i) const
+		{ return(m_X[i]); };
+
+	/**
+ 	 * GetY
+ 	 * @param i (input) Index of point.
+ 	 * @return Y value of point.
+ 	 */
+	double
+	GetY(int i) const
+		{ return(m_Y[i]); };
+
+	/**
+ 	 * GetPoint
+ 	 * @param i (input) Index of point.
+ 	 * @return Point sharing this set's setting.
+ 	 */
+	Point
+	GetPoint(int i) const
+		{ return(Point(m_X[i], m_Y[i], m_MathSetting)); };
+
+	/**
+ 	 * Set the coordinates of an existing point.
+ 	 * @param i (input) Index of point.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 */
+	void
+	Set(
+		int i,
+		double x,
+		double y)
+		{ m_X[i] = x; m_Y[i] = y; };
+
+	/**
+ 	 * Direct access to the x coordinates.
+ 	 * @return Pointer to GetSize() x values.
+ 	 */
+	const double*
+	GetXData() const
+		{ return(m_X.empty() ? NULL : &m_X[0]); };
+
+	/**
+ 	 * Direct access to the y coordinates.
+ 	 * @return Pointer to GetSize() y values.
+ 	 */
+	const double*
+	GetYData() const
+		{ return(m_Y.empty() ? NULL : &m_Y[0]); };
+
+	/**
+ 	 * Reserve room for a number of points.
+ 	 * @param count (input) Expected number of points.
+ 	 */
+	void
+	Reserve(int count);
+
+	/**
+ 	 * Remove all points from the set.
+ 	 */
+	void
+	Clear();
+
+	/**
+	 * Creates string output of the object. Output occurs in MathBase.
+	 */
+	void
+	PrintObject(char* stringToPrintObject = NULL);
+
+protected:
+
+	/**
+ 	 * X and Y values of the points.
+ 	 */
+	std::vector<double> m_X;
+	std::vector<double> m_Y;
+
+};
+
+#endif
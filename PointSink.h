@@ -0,0 +1,49 @@
+/**
+ * Title: PointSink.h
+ * Description: Interface for objects which receive streamed points.
+ * @author Mary Wyllie
+ */
+
+#ifndef POINTSINK_H
+#define POINTSINK_H 1
+
+/**
+ * Interface for a consumer of points produced one at a time, such
+ * as by function sampling. Points arrive in the producer's order and
+ * are not stored by the producer, so a sink may write, reduce or
+ * discard them as they come.
+ */
+class PointSink
+{
+public:
+
+	/**
+ 	 * Destructor.
+ 	 */
+	virtual
+	~PointSink()
+		{};
+
+	/**
+ 	 * Receive the next point.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 * @return True to continue, false to ask the producer to stop.
+ 	 */
+	virtual bool
+	AddPoint(
+		double x,
+		double y) = 0;
+
+	/**
+ 	 * The run of connected points ends with the last point received,
+ 	 * for example where a function becomes undefined. The next point
+ 	 * received starts a new run.
+ 	 */
+	virtual void
+	EndSegment()
+		{};
+
+};
+
+#endif
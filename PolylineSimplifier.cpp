@@ -0,0 +1,406 @@
+/**
+ * Title: PolylineSimplifier.cpp
+ * Description: Reduces the number of points in a polyline.
+ * @author Mary Wyllie
+ */
+
+#include "PolylineSimplifier.h"
+#include <algorithm>
+#include <functional>
+
+/**
+ * Squared distance from point p to the segment from a to b.
+ */
+static double
+SegmentDistanceSquared(
+	double px, double py,
+	double ax, double ay,
+	double bx, double by)
+{
+	double dx = bx - ax, dy = by - ay;
+	double ex = px - ax, ey = py - ay;
+	double len2 = dx*dx + dy*dy;
+	double dot = ex*dx + ey*dy;
+
+	if(len2 <= 0 || dot <= 0) return(ex*ex + ey*ey);
+	if(dot >= len2)
+	{
+		double fx = px - bx, fy = py - by;
+		return(fx*fx + fy*fy);
+	}
+	double cross = ex*dy - ey*dx;
+	return(cross*cross / len2);
+}
+
+/**
+ * Area of the triangle through points a, b and c.
+ */
+static double
+TriangleArea(
+	double ax, double ay,
+	double bx, double by,
+	double cx, double cy)
+{
+	double area = 0.5 * ((bx - ax)*(cy - ay) - (cx - ax)*(by - ay));
+	return(area < 0 ? -area : area);
+}
+
+/**
+ * Constructor.
+ * @param setting (optional input) setting (optional epsilon/angleMode).
+ * @return None.
+ */
+PolylineSimplifier::PolylineSimplifier(
+	MathSetting *setting) :
+	MathBase(setting),
+	m_Output(NULL),
+	m_Tolerance(0),
+	m_Method(MATH_SIMPLIFY_DOUGLAS_PEUCKER),
+	m_WindowSize(4096),
+	m_IsStopped(false)
+{
+}
+
+/**
+ * Destructor.
+ */
+PolylineSimplifier::~PolylineSimplifier()
+{
+}
+
+/**
+ * Simplify a curve.
+ * @param points (input) Curve points in order.
+ * @param tolerance (input) Distance tolerance. If 0, the object's
+ * epsilon will be used.
+ * @param result (output) Points kept, in order.
+ * @param method (optional input) Simplification method.
+ * @return Number of points kept.
+ */
+int
+PolylineSimplifier::Simplify(
+	const PointSet& points,
+	double tolerance,
+	PointSet *result,
+	TSimplifyMethod method) const
+{
+	std::vector<char> keep;
+	int count = points.GetSize();
+	int kept = Simplify(points.GetXData(), points.GetYData(), count,
+		tolerance, &keep, method);
+
+	result->Clear();
+	result->Reserve(kept);
+	for(int i = 0; i < count; i++)
+	{
+		if(keep[i]) result->Add(points.GetX(i), points.GetY(i));
+	}
+	return(kept);
+}
+
+/**
+ * Simplify a set of independent curves.
+ * @param curves (input) Curves to simplify.
+ * @param tolerance (input) Distance tolerance. If 0, the object's
+ * epsilon will be used.
+ * @param results (output) Simplified curve for each input curve.
+ * Must hold as many PointSets as there are curves.
+ * @param method (optional input) Simplification method.
+ */
+void
+PolylineSimplifier::SimplifyBatch(
+	const std::vector<PointSet*>& curves,
+	double tolerance,
+	const std::vector<PointSet*>& results,
+	TSimplifyMethod method) const
+{
+	int count = (int) curves.size();
+	if((int) results.size() < count) count = (int) results.size();
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int i = 0; i < count; i++)
+	{
+		if(curves[i] && results[i])
+			Simplify(*curves[i], tolerance, results[i], method);
+	}
+}
+
+/**
+ * Mark the points of a curve to keep.
+ * @param x (input) X coordinates of the curve.
+ * @param y (input) Y coordinates of the curve.
+ * @param count (input) Number of points.
+ * @param tolerance (input) Distance tolerance. If 0, the object's
+ * epsilon will be used.
+ * @param keep (output) Nonzero for each point kept.
+ * @param method (optional input) Simplification method.
+ * @return Number of points kept.
+ */
+int
+PolylineSimplifier::Simplify(
+	const double *x,
+	const double *y,
+	int count,
+	double tolerance,
+	std::vector<char> *keep,
+	TSimplifyMethod method) const
+{
+	if(tolerance <= 0) tolerance = GetEpsilon();
+
+	keep->assign(count, 0);
+	if(count <= 2)
+	{
+		keep->assign(count, 1);
+		return(count);
+	}
+
+	if(method == MATH_SIMPLIFY_VISVALINGAM)
+		Visvalingam(x, y, count, tolerance, keep);
+	else
+		DouglasPeucker(x, y, count, tolerance, keep);
+
+	int kept = 0;
+	for(int i = 0; i < count; i++)
+	{
+		if((*keep)[i]) kept++;
+	}
+	return(kept);
+}
+
+/**
+ * Douglas-Peucker with an explicit stack of index ranges.
+ * Each range keeps its farthest interior point when that point is
+ * outside the tolerance, and is then split there.
+ */
+void
+PolylineSimplifier::DouglasPeucker(
+	const double *x,
+	const double *y,
+	int count,
+	double tolerance,
+	std::vector<char> *keep) const
+{
+	double tolerance2 = tolerance * tolerance;
+	std::vector< std::pair<int, int> > stack;
+
+	(*keep)[0] = 1;
+	(*keep)[count - 1] = 1;
+	stack.push_back(std::make_pair(0, count - 1));
+
+	while(!stack.empty())
+	{
+		int first = stack.back().first;
+		int last = stack.back().second;
+		stack.pop_back();
+
+		int farthest = -1;
+		double farthest2 = tolerance2;
+		for(int i = first + 1; i < last; i++)
+		{
+			double d2 = SegmentDistanceSquared(x[i], y[i],
+				x[first], y[first], x[last], y[last]);
+			if(d2 > farthest2)
+			{
+				farthest2 = d2;
+				farthest = i;
+			}
+		}
+
+		if(farthest >= 0)
+		{
+			(*keep)[farthest] = 1;
+			if(farthest - first > 1)
+				stack.push_back(std::make_pair(first, farthest));
+			if(last - farthest > 1)
+				stack.push_back(std::make_pair(farthest, last));
+		}
+	}
+}
+
+/**
+ * Visvalingam-Whyatt with a heap of triangle areas.
+ * Removed points are unlinked from their neighbours, whose areas are
+ * then recomputed. Heap entries made stale by a recompute are skipped
+ * when they reach the top.
+ */
+void
+PolylineSimplifier::Visvalingam(
+	const double *x,
+	const double *y,
+	int count,
+	double tolerance,
+	std::vector<char> *keep) const
+{
+	typedef std::pair<double, int> TAreaEntry;
+	double threshold = tolerance * tolerance;
+	std::vector<int> prev(count), next(count);
+	std::vector<double> area(count, 0);
+	std::vector<TAreaEntry> heap;
+	std::greater<TAreaEntry> smallestFirst;
+
+	keep->assign(count, 1);
+	heap.reserve(count);
+	for(int i = 0; i < count; i++)
+	{
+		prev[i] = i - 1;
+		next[i] = i + 1;
+		if(i > 0 && i < count - 1)
+		{
+			area[i] = TriangleArea(x[i-1], y[i-1], x[i], y[i],
+				x[i+1], y[i+1]);
+			heap.push_back(std::make_pair(area[i], i));
+		}
+	}
+	std::make_heap(heap.begin(), heap.end(), smallestFirst);
+
+	while(!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), smallestFirst);
+		TAreaEntry top = heap.back();
+		heap.pop_back();
+
+		int i = top.second;
+		if(!(*keep)[i] || top.first != area[i]) continue;
+		if(top.first >= threshold) break;
+
+		//-----------------------------------------------
+		// Drop the point and rejoin its neighbours. The
+		// end points are never in the heap.
+		//-----------------------------------------------
+		(*keep)[i] = 0;
+		int p = prev[i], n = next[i];
+		next[p] = n;
+		prev[n] = p;
+
+		if(p > 0)
+		{
+			area[p] = TriangleArea(x[prev[p]], y[prev[p]], x[p], y[p],
+				x[n], y[n]);
+			heap.push_back(std::make_pair(area[p], p));
+			std::push_heap(heap.begin(), heap.end(), smallestFirst);
+		}
+		if(n < count - 1)
+		{
+			area[n] = TriangleArea(x[p], y[p], x[n], y[n],
+				x[next[n]], y[next[n]]);
+			heap.push_back(std::make_pair(area[n], n));
+			std::push_heap(heap.begin(), heap.end(), smallestFirst);
+		}
+	}
+}
+
+/**
+ * Start simplifying a stream of points. Points given to AddPoint
+ * are simplified and passed on to the output sink.
+ * @param output (input) Receives the simplified points.
+ * @param tolerance (input) Distance tolerance. If 0, the object's
+ * epsilon will be used.
+ * @param method (optional input) Simplification method.
+ * @param windowSize (optional input) Most points held at once.
+ */
+void
+PolylineSimplifier::SetOutput(
+	PointSink *output,
+	double tolerance,
+	TSimplifyMethod method,
+	int windowSize)
+{
+	m_Output = output;
+	m_Tolerance = tolerance;
+	m_Method = method;
+	m_WindowSize = (windowSize < 4) ? 4 : windowSize;
+	m_IsStopped = false;
+	m_Window.Clear();
+	m_Window.Reserve(m_WindowSize);
+}
+
+/**
+ * Receive the next point of the stream.
+ * @param x (input) X coordinate of point.
+ * @param y (input) Y coordinate of point.
+ * @return False once the output sink has asked to stop.
+ */
+bool
+PolylineSimplifier::AddPoint(
+	double x,
+	double y)
+{
+	if(!m_Output || m_IsStopped) return(false);
+
+	m_Window.Add(x, y);
+	if(m_Window.GetSize() >= m_WindowSize)
+		return(FlushWindow(false));
+	return(true);
+}
+
+/**
+ * End the current run of the stream. The rest of the window is
+ * simplified and passed on, followed by EndSegment on the output.
+ */
+void
+PolylineSimplifier::EndSegment()
+{
+	if(!m_Output || m_IsStopped) return;
+
+	FlushWindow(true);
+	m_Output->EndSegment();
+}
+
+/**
+ * Simplify the window and pass points on to the output.
+ * Unless final, the window restarts from its second to last kept
+ * point, so the join between windows is simplified again with the
+ * next points. If that would leave more than half a window, it
+ * restarts from the last point instead so the stream keeps moving.
+ * @param isFinal (input) Pass on the whole window rather than
+ * keeping its tail for the next one.
+ */
+bool
+PolylineSimplifier::FlushWindow(bool isFinal)
+{
+	std::vector<char> keep;
+	int count = m_Window.GetSize();
+	if(count == 0) return(true);
+
+	Simplify(m_Window.GetXData(), m_Window.GetYData(), count,
+		m_Tolerance, &keep, m_Method);
+
+	int restart = count;
+	if(!isFinal)
+	{
+		restart = count - 1;
+		for(int i = count - 2; i > 0; i--)
+		{
+			if(keep[i])
+			{
+				if(count - i <= m_WindowSize / 2) restart = i;
+				break;
+			}
+		}
+	}
+
+	for(int i = 0; i < restart; i++)
+	{
+		if(keep[i] && !m_Output->AddPoint(m_Window.GetX(i), m_Window.GetY(i)))
+		{
+			m_IsStopped = true;
+			break;
+		}
+	}
+
+	//-------------------------------------------
+	// Move the tail to the front of the window.
+	//-------------------------------------------
+	PointSet tail;
+	for(int i = restart; i < count; i++)
+	{
+		tail.Add(m_Window.GetX(i), m_Window.GetY(i));
+	}
+	m_Window.Clear();
+	for(int i = 0; i < tail.GetSize(); i++)
+	{
+		m_Window.Add(tail.GetX(i), tail.GetY(i));
+	}
+
+	return(!m_IsStopped);
+}
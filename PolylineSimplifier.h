@@ -0,0 +1,189 @@
+/**
+ * Title: PolylineSimplifier.h
+ * Description: Reduces the number of points in a polyline.
+ * @author Mary Wyllie
+ */
+
+#ifndef POLYLINESIMPLIFIER_H
+#define POLYLINESIMPLIFIER_H 1
+
+#include "MathBase.h"
+#include "PointSet.h"
+#include "PointSink.h"
+#include <vector>
+
+/**
+ * Polyline simplification for sampled curves.
+ * The tolerance is a distance in the same units as the object's
+ * epsilon (and is the epsilon when given as 0). Douglas-Peucker keeps
+ * every point needed so no dropped point is farther than the tolerance
+ * from the simplified line. Visvalingam-Whyatt drops points while the
+ * triangle each forms with its neighbours has an area below the
+ * tolerance squared. The first and last points are always kept.
+ *
+ * Whole curves are simplified with Simplify, or many curves at once
+ * with SimplifyBatch, which splits the curves across threads when
+ * OpenMP is enabled.
+ *
+ * The simplifier is also a PointSink for streams too long to hold in
+ * memory. Streamed points are gathered into a window of bounded size,
+ * each full window is simplified and its points passed on to an output
+ * sink, keeping only the tail of the window to join with the next one.
+ */
+class PolylineSimplifier :
+	public MathBase,
+	public PointSink
+{
+public:
+
+	/**
+ 	 * Constructor.
+ 	 * @param setting (optional input) setting (optional epsilon/angleMode).
+ 	 * @return None.
+ 	 */
+	PolylineSimplifier(
+		MathSetting *setting = NULL);
+
+	/**
+ 	 * Destructor.
+ 	 */
+	virtual
+	~PolylineSimplifier();
+
+	/**
+ 	 * Simplify a curve.
+ 	 * @param points (input) Curve points in order.
+ 	 * @param tolerance (input) Distance tolerance. If 0, the object's
+ 	 * epsilon will be used.
+ 	 * @param result (output) Points kept, in order.
+ 	 * @param method (optional input) Simplification method.
+ 	 * @return Number of points kept.
+ 	 */
+	int
+	Simplify(
+		const PointSet& points,
+		double tolerance,
+		PointSet *result,
+		TSimplifyMethod method = MATH_SIMPLIFY_DOUGLAS_PEUCKER) const;
+
+	/**
+ 	 * Simplify a set of independent curves.
+ 	 * @param curves (input) Curves to simplify.
+ 	 * @param tolerance (input) Distance tolerance. If 0, the object's
+ 	 * epsilon will be used.
+ 	 * @param results (output) Simplified curve for each input curve.
+ 	 * Must hold as many PointSets as there are curves.
+ 	 * @param method (optional input) Simplification method.
+ 	 */
+	void
+	SimplifyBatch(
+		const std::vector<PointSet*>& curves,
+		double tolerance,
+		const std::vector<PointSet*>& results,
+		TSimplifyMethod method = MATH_SIMPLIFY_DOUGLAS_PEUCKER) const;
+
+	/**
+ 	 * Mark the points of a curve to keep.
+ 	 * @param x (input) X coordinates of the curve.
+ 	 * @param y (input) Y coordinates of the curve.
+ 	 * @param count (input) Number of points.
+ 	 * @param tolerance (input) Distance tolerance. If 0, the object's
+ 	 * epsilon will be used.
+ 	 * @param keep (output) Nonzero for each point kept.
+ 	 * @param method (optional input) Simplification method.
+ 	 * @return Number of points kept.
+ 	 */
+	int
+	Simplify(
+		const double *x,
+		const double *y,
+		int count,
+		double tolerance,
+		std::vector<char> *keep,
+		TSimplifyMethod method = MATH_SIMPLIFY_DOUGLAS_PEUCKER) const;
+
+	/**
+ 	 * Start simplifying a stream of points. Points given to AddPoint
+ 	 * are simplified and passed on to the output sink.
+ 	 * @param output (input) Receives the simplified points.
+ 	 * @param tolerance (input) Distance tolerance. If 0, the object's
+ 	 * epsilon will be used.
+ 	 * @param method (optional input) Simplification method.
+ 	 * @param windowSize (optional input) Most points held at once.
+ 	 */
+	void
+	SetOutput(
+		PointSink *output,
+		double tolerance,
+		TSimplifyMethod method = MATH_SIMPLIFY_DOUGLAS_PEUCKER,
+		int windowSize = 4096);
+
+	/**
+ 	 * Receive the next point of the stream.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 * @return False once the output sink has asked to stop.
+ 	 */
+	virtual bool
+	AddPoint(
+		double x,
+		double y);
+
+	/**
+ 	 * End the current run of the stream. The rest of the window is
+ 	 * simplified and passed on, followed by EndSegment on the output.
+ 	 */
+	virtual void
+	EndSegment();
+
+protected:
+
+	/**
+ 	 * Douglas-Peucker with an explicit stack of index ranges.
+ 	 */
+	void
+	DouglasPeucker(
+		const double *x,
+		const double *y,
+		int count,
+		double tolerance,
+		std::vector<char> *keep) const;
+
+	/**
+ 	 * Visvalingam-Whyatt with a heap of triangle areas.
+ 	 */
+	void
+	Visvalingam(
+		const double *x,
+		const double *y,
+		int count,
+		double tolerance,
+		std::vector<char> *keep) const;
+
+	/**
+ 	 * Simplify the window and pass points on to the output.
+ 	 * @param isFinal (input) Pass on the whole window rather than
+ 	 * keeping its tail for the next one.
+ 	 */
+	bool
+	FlushWindow(bool isFinal);
+
+protected:
+
+	/**
+ 	 * Stream state.
+ 	 */
+	PointSink *m_Output;
+	double m_Tolerance;
+	TSimplifyMethod m_Method;
+	int m_WindowSize;
+	bool m_IsStopped;
+
+	/**
+ 	 * Points of the stream not yet passed on.
+ 	 */
+	PointSet m_Window;
+
+};
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "Polynomial.h"
 #include "MathFunction.h"
+#include "MathKernels.h"
 #include <math.h>
 
 /**
@@ -51,18 +52,632 @@ Polynomial::CalculateY(
 	double *y)
 {
 	TMathResult status = MATH_SUCCESS;
+
+	*y = Evaluate(m_Coefficients.empty() ? NULL : &m_Coefficients[0],
+		(int) m_Coefficients.size(), x);
+	return status;
+}
+
+/**
+ * Calculate a block of points by Horner's rule (see EvaluateBlock).
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Polynomial::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(x, y, status, count);
+}
+
+/**
+ * Calculate a block of points in single precision, by Horner's rule
+ * across the block.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Polynomial::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(x, y, status, count);
+}
+
+/**
+ * Calculate a block of points for either scalar type. Horner's rule
+ * needs one multiply-add per coefficient and point, however it is
+ * arranged, so the strategy decides how to keep the processor busy:
+ *
+ *	- A few points of a high degree: each point by EvaluateSplit,
+ *	  whose four chains hide the latency of each multiply-add.
+ *	- Otherwise: tiles of MATH_BLOCK_SIZE points, each coefficient
+ *	  applied across a tile while it stays in registers and cache,
+ *	  and the coefficients read once per tile. Tiles are shared
+ *	  between threads when there are MATH_POLYNOMIAL_PARALLEL_WORK
+ *	  multiply-adds or more.
+ *
+ * Subproduct tree methods need fewer operations for very high
+ * degrees, but lose too much accuracy in floating point.
+ */
+template <class T>
+void
+Polynomial::EvaluateBlock(
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count)
+{
+	int size = (int) m_Coefficients.size();
+	const double *coefficients = size ? &m_Coefficients[0] : (const double*) NULL;
+
+	if(count < MATH_POLYNOMIAL_SPLIT_POINTS && size > MATH_POLYNOMIAL_SPLIT_DEGREE)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			y[i] = (T) EvaluateSplit(coefficients, size, (double) x[i]);
+			status[i] = MATH_SUCCESS;
+		}
+		return;
+	}
+
+	//------------------------------------------------
+	// Starting threads costs more than a small block,
+	// even when the region then runs on one.
+	//------------------------------------------------
+	if((double) count * size < MATH_POLYNOMIAL_PARALLEL_WORK)
+	{
+		for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+		{
+			int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+			KernelPolynomialBlock(coefficients, size, x + start, y + start,
+				status + start, n);
+		}
+		return;
+	}
+
+	int tiles = (count + MATH_BLOCK_SIZE - 1) / MATH_BLOCK_SIZE;
+
+	#pragma omp parallel for
+	for(int t = 0; t < tiles; t++)
+	{
+		int start = t * MATH_BLOCK_SIZE;
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		KernelPolynomialBlock(coefficients, size, x + start, y + start,
+			status + start, n);
+	}
+}
+
+/**
+ * Calculate the value of a polynomial by Horner's rule split into four
+ * chains: p(x) = P0(x^4) + x P1(x^4) + x^2 P2(x^4) + x^3 P3(x^4), where
+ * Pr has every fourth coefficient from r. The chains do not wait on
+ * each other, so a long polynomial takes about a quarter of the time.
+ * @param coefficients (input) Coefficient for each power of x.
+ * @param count (input) Number of coefficients.
+ * @param x (input) x input value.
+ * @return Polynomial value at x.
+ */
+double
+Polynomial::EvaluateSplit(
+	const double *coefficients,
+	int count,
+	double x)
+{
+	double x2 = x * x;
+	double x4 = x2 * x2;
+	double chain[4] = {0, 0, 0, 0};
+
+	int top = count - 1;
+	for(int i = top - (top & 3); i >= 0; i -= 4)
+	{
+		for(int r = 0; r < 4; r++)
+		{
+			double c = (i + r < count) ? coefficients[i + r] : 0;
+			chain[r] = chain[r] * x4 + c;
+		}
+	}
+	return ((chain[3] * x + chain[2]) * x + chain[1]) * x + chain[0];
+}
+
+/**
+ * Calculate points at equally spaced x values from a table of forward
+ * differences. A polynomial of degree n has a constant n-th difference,
+ * so from the differences at one point the next value takes n
+ * additions. Each run of MATH_POLYNOMIAL_RUN points builds its own
+ * table from the Taylor coefficients at its first x (see SampleRun),
+ * which stops rounding error building up over long ranges and lets
+ * runs be shared between threads. Polynomials of degree above
+ * MATH_POLYNOMIAL_DIFFERENCE_DEGREE are calculated by Horner's rule
+ * across each run instead.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Polynomial::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateUniform(m_Coefficients.empty() ? NULL : &m_Coefficients[0],
+		(int) m_Coefficients.size(), xStart, step, y, status, count);
+}
+
+/**
+ * Calculate a polynomial at equally spaced x values by forward
+ * differences (see SampleUniform).
+ * @param coefficients (input) Coefficient for each power of x.
+ * @param size (input) Number of coefficients.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Polynomial::EvaluateUniform(
+	const double *coefficients,
+	int size,
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	int degree = size - 1;
+	while(degree > 0 && coefficients[degree] == 0) degree--;
+
+	int runs = (count + MATH_POLYNOMIAL_RUN - 1) / MATH_POLYNOMIAL_RUN;
+	if(count < MATH_POLYNOMIAL_PARALLEL)
+	{
+		for(int r = 0; r < runs; r++)
+		{
+			int first = r * MATH_POLYNOMIAL_RUN;
+			int n = (count - first < MATH_POLYNOMIAL_RUN) ? count - first : MATH_POLYNOMIAL_RUN;
+			SampleRun(coefficients, degree, xStart, step, first, y + first,
+				status + first, n);
+		}
+		return;
+	}
+
+	#pragma omp parallel for
+	for(int r = 0; r < runs; r++)
+	{
+		int first = r * MATH_POLYNOMIAL_RUN;
+		int n = (count - first < MATH_POLYNOMIAL_RUN) ? count - first : MATH_POLYNOMIAL_RUN;
+		SampleRun(coefficients, degree, xStart, step, first, y + first,
+			status + first, n);
+	}
+}
+
+/**
+ * Calculate one run of equally spaced points, x = x0 + i h with
+ * x0 = xStart + first h, by forward differences. Differencing
+ * calculated values would lose the small high differences to
+ * cancellation, so the table comes from the Taylor coefficients at
+ * x0 instead:
+ *
+ *	t_j = p^(j)(x0) h^j / j!
+ *	D^k p(x0) = sum over j >= k of t_j k! S(j, k)
+ *
+ * where k! S(j, k), S a Stirling number of the second kind, counts
+ * the ways j things map onto k, T(j, k) = k (T(j-1, k) + T(j-1, k-1)).
+ *
+ * An error in the k-th difference reaches the i-th point multiplied
+ * by C(i, k), so above MATH_POLYNOMIAL_DIFFERENCE_DEGREE the run would
+ * be swamped by rounding. Such runs, and runs too short to gain from
+ * the table, make their x values in place and use Horner's rule
+ * across them, as CalculateYBlock does.
+ * @param coefficients (input) Coefficient for each power of x.
+ * @param degree (input) Highest power with a coefficient, -1 if none.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points, at most MATH_POLYNOMIAL_RUN.
+ */
+void
+Polynomial::SampleRun(
+	const double *coefficients,
+	int degree,
+	double xStart,
+	double step,
+	int first,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	if(degree > MATH_POLYNOMIAL_DIFFERENCE_DEGREE || count <= degree + 1)
+	{
+		double x[MATH_POLYNOMIAL_RUN];
+		for(int i = 0; i < count; i++) x[i] = xStart + (double) (first + i) * step;
+		KernelPolynomialBlock(coefficients, degree + 1, x, y, status, count);
+		return;
+	}
+
+	for(int i = 0; i < count; i++) status[i] = MATH_SUCCESS;
+	if(degree < 0)
+	{
+		for(int i = 0; i < count; i++) y[i] = 0;
+		return;
+	}
+
+	double x0 = xStart + (double) first * step;
+
+	//------------------------------------------------
+	// Taylor coefficients at x0 by repeated synthetic
+	// division, then scaled by powers of the step.
+	//------------------------------------------------
+	double taylor[MATH_POLYNOMIAL_DIFFERENCE_DEGREE + 1];
+	double table[MATH_POLYNOMIAL_DIFFERENCE_DEGREE + 1];
+	double surjections[MATH_POLYNOMIAL_DIFFERENCE_DEGREE + 1];
+	for(int k = 0; k <= degree; k++) taylor[k] = coefficients[k];
+	for(int j = 0; j < degree; j++)
+	{
+		for(int k = degree - 1; k >= j; k--) taylor[k] += x0 * taylor[k + 1];
+	}
+	double power = 1;
+	for(int j = 0; j <= degree; j++)
+	{
+		taylor[j] *= power;
+		power *= step;
+	}
+
+	//------------------------------------------------
+	// table[k] is the k-th difference at x0. Row j of
+	// T(j, k) is built in place from row j - 1.
+	//------------------------------------------------
+	for(int k = 0; k <= degree; k++) table[k] = 0;
+	surjections[0] = 1;
+	table[0] = taylor[0];
+	for(int j = 1; j <= degree; j++)
+	{
+		surjections[j] = 0;
+		for(int k = j; k >= 1; k--)
+			surjections[k] = k * (surjections[k] + surjections[k - 1]);
+		surjections[0] = 0;
+		for(int k = 1; k <= j; k++) table[k] += taylor[j] * surjections[k];
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		y[i] = table[0];
+		for(int k = 0; k < degree; k++) table[k] += table[k + 1];
+	}
+}
+
+/**
+ * Bound this function over a range of x. Two enclosures are taken
+ * and intersected: Horner's rule in interval arithmetic, which is
+ * good for wide ranges, and the centered form, which is good for
+ * narrow ones. The centered form rewrites the polynomial in powers
+ * of t = x - c about the middle c of the range, so that each power
+ * of t is bounded exactly by [-r^k, r^k] or [0, r^k].
+ * @param x (input) Range of x values.
+ * @param y (output) Range of y values.
+ * @return MATH_SUCCESS; polynomials are always defined.
+ */
+TMathResult
+Polynomial::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	EvaluateInterval(m_Coefficients.empty() ? NULL : &m_Coefficients[0],
+		(int) m_Coefficients.size(), x, y);
+	return MATH_SUCCESS;
+}
+
+/**
+ * Bound a polynomial over a range of x (see CalculateInterval).
+ * @param coefficients (input) Coefficient for each power of x.
+ * @param count (input) Number of coefficients.
+ * @param x (input) Range of x values.
+ * @param y (output) Range of y values.
+ */
+void
+Polynomial::EvaluateInterval(
+	const double *coefficients,
+	int count,
+	const Interval& x,
+	Interval *y)
+{
+	if(count == 0)
+	{
+		*y = Interval(0);
+		y->SetMayBeUndefined(x.MayBeUndefined());
+		return;
+	}
+
+	Interval natural(coefficients[count - 1]);
+	for(int i = count - 2; i >= 0; i--)
+	{
+		natural = natural * x + Interval(coefficients[i]);
+	}
+	natural.SetMayBeUndefined(x.MayBeUndefined());
+
+	if(count <= 2 || !x.IsBounded())
+	{
+		*y = natural;
+		return;
+	}
+
+	//--------------------------------------------------
+	// Taylor coefficients about the center by repeated
+	// synthetic division, in interval arithmetic so the
+	// rounding of each step is kept.
+	//--------------------------------------------------
+	Interval center(x.GetMidpoint());
+	std::vector<Interval> shifted(count);
+	for(int i = 0; i < count; i++)
+	{
+		shifted[i] = Interval(coefficients[i]);
+	}
+	for(int i = 0; i < count - 1; i++)
+	{
+		for(int j = count - 2; j >= i; j--)
+		{
+			shifted[j] = shifted[j] + center * shifted[j + 1];
+		}
+	}
+
+	Interval t = x - center;
+	Interval centered = shifted[0];
+	for(int k = 1; k < count; k++)
+	{
+		centered = centered + shifted[k] * t.Power(k);
+	}
+
+	if(!natural.Intersect(centered, y)) *y = centered;
+	y->SetMayBeUndefined(x.MayBeUndefined());
+}
+
+/**
+ * Calculate the value of a polynomial.
+ * @param coefficients (input) Coefficient for each power of x.
+ * @param count (input) Number of coefficients.
+ * @param x (input) x input value.
+ * @return Polynomial value at x.
+ */
+double
+Polynomial::Evaluate(
+	const double *coefficients,
+	int count,
+	double x)
+{
 	double result = 0;
 
-	for(int i = 0; i < m_Coefficients.size(); i++)
+	for(int i = 0; i < count; i++)
 	{
-		if(! m_Coefficients[i]) continue;
+		if(! coefficients[i]) continue;
 
 		double power = 1;
 		if(i == 1) power = x;
 		if(i > 1) power = pow(x, i);
-		result += m_Coefficients[i] * power;
+		result += coefficients[i] * power;
 	}
-	*y = result;
-	return status;
+	return result;
+}
+
+
+//---------------------------------------------------------------
+// Polynomial arithmetic
+//---------------------------------------------------------------
+
+/**
+ * Sum of two polynomials.
+ * @param a (input) First polynomial.
+ * @param b (input) Second polynomial.
+ * @param result (output) a + b.
+ */
+void
+Polynomial::Add(
+	const std::vector<double>& a,
+	const std::vector<double>& b,
+	std::vector<double> *result)
+{
+	std::vector<double> sum(a.size() > b.size() ? a.size() : b.size(), 0);
+	for(size_t i = 0; i < a.size(); i++) sum[i] += a[i];
+	for(size_t i = 0; i < b.size(); i++) sum[i] += b[i];
+	result->swap(sum);
+}
+
+/**
+ * Difference of two polynomials.
+ * @param a (input) First polynomial.
+ * @param b (input) Second polynomial.
+ * @param result (output) a - b.
+ */
+void
+Polynomial::Subtract(
+	const std::vector<double>& a,
+	const std::vector<double>& b,
+	std::vector<double> *result)
+{
+	std::vector<double> difference(a.size() > b.size() ? a.size() : b.size(), 0);
+	for(size_t i = 0; i < a.size(); i++) difference[i] += a[i];
+	for(size_t i = 0; i < b.size(); i++) difference[i] -= b[i];
+	result->swap(difference);
+}
+
+/**
+ * Constant multiple of a polynomial.
+ * @param a (input) Polynomial.
+ * @param factor (input) Constant.
+ * @param result (output) factor a.
+ */
+void
+Polynomial::Scale(
+	const std::vector<double>& a,
+	double factor,
+	std::vector<double> *result)
+{
+	std::vector<double> scaled(a);
+	for(size_t i = 0; i < scaled.size(); i++) scaled[i] *= factor;
+	result->swap(scaled);
+}
+
+/**
+ * Product of two polynomials. Below MATH_POLYNOMIAL_KARATSUBA
+ * coefficients the product is formed term by term; above it,
+ * Karatsuba's method needs about n^1.58 multiplications rather than
+ * n^2. Products by FFT need fewer still for very long polynomials,
+ * but their error is relative to the largest coefficient, which
+ * loses the small ones.
+ * @param a (input) First polynomial.
+ * @param b (input) Second polynomial.
+ * @param result (output) a b, empty if either is empty.
+ */
+void
+Polynomial::Multiply(
+	const std::vector<double>& a,
+	const std::vector<double>& b,
+	std::vector<double> *result)
+{
+	std::vector<double> product;
+	if(!a.empty() && !b.empty())
+	{
+		product.assign(a.size() + b.size() - 1, 0);
+		MultiplyInto(&a[0], (int) a.size(), &b[0], (int) b.size(), &product[0]);
+	}
+	result->swap(product);
+}
+
+/**
+ * Add the product of two coefficient arrays into a result, of
+ * sizeA + sizeB - 1 coefficients. With both halves split at m,
+ *
+ *	(a0 + a1 x^m)(b0 + b1 x^m) = z0 + z1 x^m + z2 x^2m
+ *	z0 = a0 b0,  z2 = a1 b1,  z1 = (a0 + a1)(b0 + b1) - z0 - z2
+ *
+ * takes three half size products rather than four.
+ */
+void
+Polynomial::MultiplyInto(
+	const double *a,
+	int sizeA,
+	const double *b,
+	int sizeB,
+	double *result)
+{
+	if(sizeA < MATH_POLYNOMIAL_KARATSUBA || sizeB < MATH_POLYNOMIAL_KARATSUBA)
+	{
+		for(int i = 0; i < sizeA; i++)
+		{
+			if(a[i] == 0) continue;
+			for(int j = 0; j < sizeB; j++) result[i + j] += a[i] * b[j];
+		}
+		return;
+	}
+
+	//------------------------------------------------
+	// A much shorter operand is multiplied into each
+	// half of the longer one.
+	//------------------------------------------------
+	int m = ((sizeA > sizeB ? sizeA : sizeB) + 1) / 2;
+	if(sizeB <= m)
+	{
+		MultiplyInto(a, m, b, sizeB, result);
+		MultiplyInto(a + m, sizeA - m, b, sizeB, result + m);
+		return;
+	}
+	if(sizeA <= m)
+	{
+		MultiplyInto(a, sizeA, b, m, result);
+		MultiplyInto(a, sizeA, b + m, sizeB - m, result + m);
+		return;
+	}
+
+	int highA = sizeA - m, highB = sizeB - m;
+	std::vector<double> sumA(a, a + m), sumB(b, b + m);
+	for(int i = 0; i < highA; i++) sumA[i] += a[m + i];
+	for(int i = 0; i < highB; i++) sumB[i] += b[m + i];
+
+	std::vector<double> low(2 * m - 1, 0), high(highA + highB - 1, 0);
+	std::vector<double> middle(2 * m - 1, 0);
+	MultiplyInto(a, m, b, m, &low[0]);
+	MultiplyInto(a + m, highA, b + m, highB, &high[0]);
+	MultiplyInto(&sumA[0], m, &sumB[0], m, &middle[0]);
+
+	for(size_t i = 0; i < low.size(); i++)
+	{
+		result[i] += low[i];
+		middle[i] -= low[i];
+	}
+	for(size_t i = 0; i < high.size(); i++)
+	{
+		result[2 * m + i] += high[i];
+		middle[i] -= high[i];
+	}
+	for(size_t i = 0; i < middle.size(); i++) result[m + i] += middle[i];
 }
 
+/**
+ * Whole power of a polynomial by repeated squaring.
+ * @param a (input) Polynomial.
+ * @param n (input) Exponent, at least 0.
+ * @param result (output) a^n.
+ */
+void
+Polynomial::Power(
+	const std::vector<double>& a,
+	int n,
+	std::vector<double> *result)
+{
+	std::vector<double> power(1, 1.0), base(a);
+	while(n > 0)
+	{
+		if(n & 1) Multiply(power, base, &power);
+		n >>= 1;
+		if(n) Multiply(base, base, &base);
+	}
+	result->swap(power);
+}
+
+/**
+ * Composition of two polynomials, by Horner's rule with the inside
+ * polynomial in place of x.
+ * @param outside (input) Outside polynomial.
+ * @param inside (input) Inside polynomial.
+ * @param result (output) outside(inside(x)).
+ */
+void
+Polynomial::Compose(
+	const std::vector<double>& outside,
+	const std::vector<double>& inside,
+	std::vector<double> *result)
+{
+	std::vector<double> composed;
+	for(int i = (int) outside.size() - 1; i >= 0; i--)
+	{
+		Multiply(composed, inside, &composed);
+		if(composed.empty()) composed.push_back(0);
+		composed[0] += outside[i];
+	}
+	result->swap(composed);
+}
+
+/**
+ * Drop zero high order coefficients.
+ * @param coefficients (input/output) Polynomial.
+ * @return Degree, or -1 if every coefficient is zero.
+ */
+int
+Polynomial::Trim(
+	std::vector<double> *coefficients)
+{
+	while(!coefficients->empty() && coefficients->back() == 0)
+		coefficients->pop_back();
+	return (int) coefficients->size() - 1;
+}
@@ -10,6 +10,34 @@
 #include "MathOperation.h"
 #include <vector>
 
+//-----------------------------------------------
+// Points in each run of forward differences, the
+// highest degree sampled by them, and the fewest
+// points sampled with several threads.
+//-----------------------------------------------
+const int MATH_POLYNOMIAL_RUN = 64;
+const int MATH_POLYNOMIAL_DIFFERENCE_DEGREE = 8;
+const int MATH_POLYNOMIAL_PARALLEL = 65536;
+
+//-----------------------------------------------
+// Block evaluation: fewer points than this, of a
+// degree at least this, use split Horner chains
+// per point; blocks with more multiply-adds than
+// this are shared between threads.
+//-----------------------------------------------
+const int MATH_POLYNOMIAL_SPLIT_POINTS = 8;
+const int MATH_POLYNOMIAL_SPLIT_DEGREE = 32;
+const double MATH_POLYNOMIAL_PARALLEL_WORK = 1048576;
+
+//-----------------------------------------------
+// Arithmetic: products of polynomials with at
+// least this many coefficients each use
+// Karatsuba's method; no product, power or
+// composition is expanded beyond this degree.
+//-----------------------------------------------
+const int MATH_POLYNOMIAL_KARATSUBA = 32;
+const int MATH_POLYNOMIAL_MAX_DEGREE = 64;
+
 /**
  * Class to represent a polynomial function.
  * This is a convenience function to provide access to
@@ -66,13 +94,286 @@ public:
 		double x,
 		double *y);
 
+	/**
+	 * Calculate a block of points by Horner's rule. The strategy is
+	 * chosen from the degree and number of points: see EvaluateBlock.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values from a table of
+	 * forward differences, so that each point takes one addition per
+	 * degree. The table is built again from the Taylor coefficients
+	 * every MATH_POLYNOMIAL_RUN points, which bounds the growth of
+	 * rounding error; runs are independent, so long ranges are split
+	 * between threads. Above MATH_POLYNOMIAL_DIFFERENCE_DEGREE the
+	 * differences lose too much to rounding, and Horner's rule is used
+	 * across each run instead.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate the value of a polynomial.
+	 * @param coefficients (input) Coefficient for each power of x.
+	 * @param count (input) Number of coefficients.
+	 * @param x (input) x input value.
+	 * @return Polynomial value at x.
+	 */
+	static double
+	Evaluate(
+		const double *coefficients,
+		int count,
+		double x);
+
+	/**
+	 * Calculate a polynomial at equally spaced x values by forward
+	 * differences (see SampleUniform).
+	 * @param coefficients (input) Coefficient for each power of x.
+	 * @param size (input) Number of coefficients.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	static void
+	EvaluateUniform(
+		const double *coefficients,
+		int size,
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound a polynomial over a range of x, as CalculateInterval.
+	 * @param coefficients (input) Coefficient for each power of x.
+	 * @param count (input) Number of coefficients.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Range of y values.
+	 */
+	static void
+	EvaluateInterval(
+		const double *coefficients,
+		int count,
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate the value of a polynomial by Horner's rule split into
+	 * four chains in x^4, which do not wait on each other.
+	 * @param coefficients (input) Coefficient for each power of x.
+	 * @param count (input) Number of coefficients.
+	 * @param x (input) x input value.
+	 * @return Polynomial value at x.
+	 */
+	static double
+	EvaluateSplit(
+		const double *coefficients,
+		int count,
+		double x);
+
+	//-----------------------------------------------------------
+	// Polynomial arithmetic on coefficient lists, lowest power
+	// first. The result may be one of the operands. High order
+	// zero coefficients are kept; see Trim.
+	//-----------------------------------------------------------
+
+	/**
+	 * Sum of two polynomials.
+	 * @param a (input) First polynomial.
+	 * @param b (input) Second polynomial.
+	 * @param result (output) a + b.
+	 */
+	static void
+	Add(
+		const std::vector<double>& a,
+		const std::vector<double>& b,
+		std::vector<double> *result);
+
+	/**
+	 * Difference of two polynomials.
+	 * @param a (input) First polynomial.
+	 * @param b (input) Second polynomial.
+	 * @param result (output) a - b.
+	 */
+	static void
+	Subtract(
+		const std::vector<double>& a,
+		const std::vector<double>& b,
+		std::vector<double> *result);
+
+	/**
+	 * Constant multiple of a polynomial.
+	 * @param a (input) Polynomial.
+	 * @param factor (input) Constant.
+	 * @param result (output) factor a.
+	 */
+	static void
+	Scale(
+		const std::vector<double>& a,
+		double factor,
+		std::vector<double> *result);
+
+	/**
+	 * Product of two polynomials, term by term or, when both have at
+	 * least MATH_POLYNOMIAL_KARATSUBA coefficients, by Karatsuba's
+	 * method.
+	 * @param a (input) First polynomial.
+	 * @param b (input) Second polynomial.
+	 * @param result (output) a b, empty if either is empty.
+	 */
+	static void
+	Multiply(
+		const std::vector<double>& a,
+		const std::vector<double>& b,
+		std::vector<double> *result);
+
+	/**
+	 * Whole power of a polynomial by repeated squaring.
+	 * @param a (input) Polynomial.
+	 * @param n (input) Exponent, at least 0.
+	 * @param result (output) a^n.
+	 */
+	static void
+	Power(
+		const std::vector<double>& a,
+		int n,
+		std::vector<double> *result);
+
+	/**
+	 * Composition of two polynomials, by Horner's rule with the inside
+	 * polynomial in place of x.
+	 * @param outside (input) Outside polynomial.
+	 * @param inside (input) Inside polynomial.
+	 * @param result (output) outside(inside(x)).
+	 */
+	static void
+	Compose(
+		const std::vector<double>& outside,
+		const std::vector<double>& inside,
+		std::vector<double> *result);
+
+	/**
+	 * Drop zero high order coefficients.
+	 * @param coefficients (input/output) Polynomial.
+	 * @return Degree, or -1 if every coefficient is zero.
+	 */
+	static int
+	Trim(
+		std::vector<double> *coefficients);
+
+	/**
+	 * Constants are the coefficients, lowest power first.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return (int) m_Coefficients.size(); };
+
+	/**
+	 * Get a coefficient.
+	 * @param i (input) Power of x.
+	 * @return Coefficient value.
+	 */
+	virtual double
+	GetConstant(
+		int i)
+		{ return m_Coefficients[i]; };
+
+protected:
+
+	/**
+	 * Calculate a block of points for either scalar type.
+	 */
+	template <class T>
+	void
+	EvaluateBlock(
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Add the product of two coefficient arrays into a result.
+	 */
+	static void
+	MultiplyInto(
+		const double *a,
+		int sizeA,
+		const double *b,
+		int sizeB,
+		double *result);
+
+	/**
+	 * Calculate one run of equally spaced points by forward
+	 * differences.
+	 */
+	static void
+	SampleRun(
+		const double *coefficients,
+		int degree,
+		double xStart,
+		double step,
+		int first,
+		double *y,
+		TMathResult *status,
+		int count);
+
 protected:
 	/**
 	 * The vector of coefficents represents the coefficient
 	 * for each power of x. For example, the 0th term represents the 
 	 * constant, the 1st term represents the coefficient to x, etc.
 	 * There is some waste here, as zeros are needed when there is
-	 * no term.
+	 * no term; MathFunction uses a SparsePolynomial instead when
+	 * most of them are zero.
 	 */
 	std::vector<double> m_Coefficients;
 
@@ -0,0 +1,410 @@
+/**
+ * Title: PolynomialFitter.cpp
+ * Description: Least squares polynomial fits to streams of points.
+ * @author Mary Wyllie
+ */
+
+#include "PolynomialFitter.h"
+#include <float.h>
+#include <math.h>
+
+/**
+ * Multiply a polynomial in the Chebyshev basis by t, using
+ * t T_0 = T_1 and t T_k = (T_(k+1) + T_(k-1)) / 2.
+ */
+static void
+MultiplyByT(
+	std::vector<double> *coefficients)
+{
+	std::vector<double> product(coefficients->size() + 1, 0);
+	for(size_t k = 0; k < coefficients->size(); k++)
+	{
+		double c = (*coefficients)[k];
+		if(k == 0)
+		{
+			product[1] += c;
+			continue;
+		}
+		product[k + 1] += c / 2;
+		product[k - 1] += c / 2;
+	}
+	coefficients->swap(product);
+}
+
+/**
+ * Constructor.
+ * @param degree (input) Highest degree fitted.
+ * @param xMin (input) Lowest x expected.
+ * @param xMax (input) Highest x expected, above xMin.
+ * @param setting (optional input) setting (optional epsilon/angleMode).
+ */
+PolynomialFitter::PolynomialFitter(
+	int degree,
+	double xMin,
+	double xMax,
+	MathSetting *setting) :
+	MathBase(setting)
+{
+	m_Size = (degree < 0) ? 1 : degree + 1;
+	m_XMin = xMin;
+	m_XMax = xMax;
+	m_Scale = (xMax > xMin) ? 2 / (xMax - xMin) : 1;
+	m_Offset = (xMax > xMin) ? -(xMax + xMin) / (xMax - xMin) : -xMin;
+	Clear();
+}
+
+/**
+ * Destructor.
+ */
+PolynomialFitter::~PolynomialFitter()
+{
+}
+
+/**
+ * Forget every point.
+ */
+void
+PolynomialFitter::Clear()
+{
+	m_R.assign(m_Size * m_Size, 0);
+	m_QtY.assign(m_Size, 0);
+	m_Residual = 0;
+	m_Count = 0;
+	m_WeightSum = 0;
+	m_MeanY = 0;
+	m_SpreadY = 0;
+}
+
+/**
+ * Chebyshev polynomials T_0(t) ... T_(size-1)(t) at x, by
+ * T_(k+1) = 2t T_k - T_(k-1).
+ */
+void
+PolynomialFitter::GetBasis(
+	double x,
+	double *row) const
+{
+	double t = m_Scale * x + m_Offset;
+	row[0] = 1;
+	if(m_Size > 1) row[1] = t;
+	for(int k = 2; k < m_Size; k++)
+	{
+		row[k] = 2 * t * row[k - 1] - row[k - 2];
+	}
+}
+
+/**
+ * Add a weighted point.
+ * @param x (input) X coordinate of point.
+ * @param y (input) Y coordinate of point.
+ * @param weight (input) Weight, at least 0.
+ */
+void
+PolynomialFitter::AddWeighted(
+	double x,
+	double y,
+	double weight)
+{
+	if(!(weight > 0)) return;
+
+	std::vector<double> buffer;
+	double local[MATH_BLOCK_SIZE];
+	double *row = local;
+	if(m_Size > MATH_BLOCK_SIZE)
+	{
+		buffer.resize(m_Size);
+		row = &buffer[0];
+	}
+
+	double root = sqrt(weight);
+	GetBasis(x, row);
+	for(int k = 0; k < m_Size; k++) row[k] *= root;
+	AddRow(row, y * root);
+
+	//------------------------------------------------
+	// Weighted mean and spread of y, updated in the
+	// stable way (West's algorithm).
+	//------------------------------------------------
+	m_Count++;
+	m_WeightSum += weight;
+	double delta = y - m_MeanY;
+	m_MeanY += delta * weight / m_WeightSum;
+	m_SpreadY += weight * delta * (y - m_MeanY);
+}
+
+/**
+ * Rotate one row into the factorization. Each Givens rotation zeroes
+ * one element of the row against the diagonal of R; what is left of
+ * the right hand side is the part of y no combination of the columns
+ * can reach, and adds to the residual.
+ * @param row (input/output) Row, scaled by the square root of the
+ * weight. Destroyed.
+ * @param y (input) Right hand side, scaled the same way.
+ */
+void
+PolynomialFitter::AddRow(
+	double *row,
+	double y)
+{
+	for(int i = 0; i < m_Size; i++)
+	{
+		if(row[i] == 0) continue;
+
+		double *r = &m_R[i * m_Size];
+		double h = sqrt(r[i] * r[i] + row[i] * row[i]);
+		double c = r[i] / h;
+		double s = row[i] / h;
+
+		r[i] = h;
+		for(int j = i + 1; j < m_Size; j++)
+		{
+			double t = r[j];
+			r[j] = c * t + s * row[j];
+			row[j] = c * row[j] - s * t;
+		}
+		double t = m_QtY[i];
+		m_QtY[i] = c * t + s * y;
+		y = c * y - s * t;
+	}
+	m_Residual += y * y;
+}
+
+/**
+ * Add a block of points. Blocks of MATH_FIT_PARALLEL points or more
+ * are split into parts of that size, each fitted separately, in
+ * parallel when OpenMP is enabled, and merged in order, so the result
+ * does not depend on the number of threads.
+ * @param x (input) X coordinates.
+ * @param y (input) Y coordinates.
+ * @param weight (input) Weight of each point, or NULL for 1.
+ * @param count (input) Number of points.
+ */
+void
+PolynomialFitter::AddBlock(
+	const double *x,
+	const double *y,
+	const double *weight,
+	int count)
+{
+	if(count < MATH_FIT_PARALLEL)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			AddWeighted(x[i], y[i], weight ? weight[i] : 1.0);
+		}
+		return;
+	}
+
+	int parts = (count + MATH_FIT_PARALLEL - 1) / MATH_FIT_PARALLEL;
+	std::vector<PolynomialFitter*> fitters(parts);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int p = 0; p < parts; p++)
+	{
+		int start = p * MATH_FIT_PARALLEL;
+		int n = (count - start < MATH_FIT_PARALLEL) ? count - start : MATH_FIT_PARALLEL;
+		fitters[p] = new PolynomialFitter(m_Size - 1, m_XMin, m_XMax, m_MathSetting);
+		for(int i = start; i < start + n; i++)
+		{
+			fitters[p]->AddWeighted(x[i], y[i], weight ? weight[i] : 1.0);
+		}
+	}
+
+	for(int p = 0; p < parts; p++)
+	{
+		Merge(*fitters[p]);
+		delete fitters[p];
+	}
+}
+
+/**
+ * Add the points given to another fitter. Its R rows are rotated in
+ * as rows of data: stacking the two factorizations gives the same
+ * normal equations as stacking the points. Its residual, count and
+ * spread add to this one's.
+ * @param other (input) Fitter to merge.
+ * @return MATH_UNDEFINED if the degree or range differ.
+ */
+TMathResult
+PolynomialFitter::Merge(
+	const PolynomialFitter& other)
+{
+	if(other.m_Size != m_Size || other.m_XMin != m_XMin || other.m_XMax != m_XMax)
+		return MATH_UNDEFINED;
+	if(other.m_WeightSum == 0) return MATH_SUCCESS;
+
+	std::vector<double> row(m_Size);
+	for(int i = 0; i < m_Size; i++)
+	{
+		for(int j = 0; j < m_Size; j++) row[j] = other.m_R[i * m_Size + j];
+		AddRow(&row[0], other.m_QtY[i]);
+	}
+	m_Residual += other.m_Residual;
+
+	double weightSum = m_WeightSum + other.m_WeightSum;
+	double delta = other.m_MeanY - m_MeanY;
+	m_SpreadY += other.m_SpreadY + delta * delta * m_WeightSum * other.m_WeightSum / weightSum;
+	m_MeanY += delta * other.m_WeightSum / weightSum;
+	m_WeightSum = weightSum;
+	m_Count += other.m_Count;
+	return MATH_SUCCESS;
+}
+
+/**
+ * Least squares fit in the Chebyshev basis, by back substitution in
+ * the leading rows of R. A diagonal element negligible against the
+ * largest means the points do not determine the coefficients.
+ * @param coefficients (output) Coefficient of each T_k(t).
+ * @param degree (optional input) Degree to fit; -1 for the fitter's.
+ * @return MATH_UNDEFINED if the points do not determine the fit.
+ */
+TMathResult
+PolynomialFitter::GetChebyshevFit(
+	std::vector<double> *coefficients,
+	int degree) const
+{
+	int size = (degree < 0 || degree >= m_Size) ? m_Size : degree + 1;
+
+	double largest = 0;
+	for(int i = 0; i < size; i++)
+	{
+		if(fabs(m_R[i * m_Size + i]) > largest) largest = fabs(m_R[i * m_Size + i]);
+	}
+
+	coefficients->assign(size, 0);
+	for(int i = size - 1; i >= 0; i--)
+	{
+		const double *r = &m_R[i * m_Size];
+		if(fabs(r[i]) <= largest * size * DBL_EPSILON)
+			return MATH_UNDEFINED;
+
+		double sum = m_QtY[i];
+		for(int j = i + 1; j < size; j++) sum -= r[j] * (*coefficients)[j];
+		(*coefficients)[i] = sum / r[i];
+	}
+	return MATH_SUCCESS;
+}
+
+/**
+ * Least squares fit. The Chebyshev coefficients are turned into
+ * powers of t, then t is replaced by its expression in x.
+ * @param polynomial (output) Polynomial fitted, coefficients in x.
+ * @param statistics (optional output) How well it fits.
+ * @param degree (optional input) Degree to fit; -1 for the fitter's.
+ * @return MATH_UNDEFINED if the points do not determine the fit.
+ */
+TMathResult
+PolynomialFitter::GetFit(
+	Polynomial *polynomial,
+	TFitStatistics *statistics,
+	int degree) const
+{
+	std::vector<double> chebyshev;
+	TMathResult status = GetChebyshevFit(&chebyshev, degree);
+	if(status != MATH_SUCCESS) return status;
+
+	int size = (int) chebyshev.size();
+	std::vector<double> inT(1, 0.0), previous, current(1, 1.0), next, twoT(2, 0.0);
+	twoT[1] = 2;
+	for(int k = 0; k < size; k++)
+	{
+		std::vector<double> term;
+		Polynomial::Scale(current, chebyshev[k], &term);
+		Polynomial::Add(inT, term, &inT);
+
+		//-------------------------------------------
+		// T_(k+1) = 2t T_k - T_(k-1), with T_1 = t.
+		//-------------------------------------------
+		Polynomial::Multiply(twoT, current, &next);
+		if(k == 0)
+			Polynomial::Scale(next, 0.5, &next);
+		else
+			Polynomial::Subtract(next, previous, &next);
+		previous.swap(current);
+		current.swap(next);
+	}
+
+	std::vector<double> linear(2), inX;
+	linear[0] = m_Offset;
+	linear[1] = m_Scale;
+	Polynomial::Compose(inT, linear, &inX);
+	inX.resize(size, 0);
+	polynomial->SetCoefficients(inX);
+
+	if(statistics)
+	{
+		//-------------------------------------------------
+		// Columns past the degree fitted leave the rest of
+		// Q^T y unexplained.
+		//-------------------------------------------------
+		double residual = m_Residual;
+		for(int i = size; i < m_Size; i++) residual += m_QtY[i] * m_QtY[i];
+		SetStatistics(residual, size, statistics);
+	}
+	return MATH_SUCCESS;
+}
+
+/**
+ * Measure a polynomial against the points seen. Since Q is
+ * orthogonal, for any coefficients c in the Chebyshev basis the
+ * residual sum of squares is |R c - Q^T y|^2 plus the residual of the
+ * least squares fit.
+ * @param polynomial (input) Any polynomial up to the fitter's degree.
+ * @param statistics (output) How well it fits.
+ * @return MATH_UNDEFINED if its degree is too high.
+ */
+TMathResult
+PolynomialFitter::GetStatistics(
+	Polynomial& polynomial,
+	TFitStatistics *statistics) const
+{
+	std::vector<double> inX = polynomial.GetCoefficients();
+	if(Polynomial::Trim(&inX) >= m_Size) return MATH_UNDEFINED;
+
+	//-------------------------------------------------
+	// x = (t - offset) / scale, then Horner's rule in
+	// the Chebyshev basis.
+	//-------------------------------------------------
+	std::vector<double> linear(2), inT, chebyshev;
+	linear[0] = -m_Offset / m_Scale;
+	linear[1] = 1 / m_Scale;
+	Polynomial::Compose(inX, linear, &inT);
+	for(int i = (int) inT.size() - 1; i >= 0; i--)
+	{
+		MultiplyByT(&chebyshev);
+		if(chebyshev.empty()) chebyshev.push_back(0);
+		chebyshev[0] += inT[i];
+	}
+	chebyshev.resize(m_Size, 0);
+
+	double residual = m_Residual;
+	for(int i = 0; i < m_Size; i++)
+	{
+		double sum = -m_QtY[i];
+		for(int j = i; j < m_Size; j++) sum += m_R[i * m_Size + j] * chebyshev[j];
+		residual += sum * sum;
+	}
+	SetStatistics(residual, (int) inX.size(), statistics);
+	return MATH_SUCCESS;
+}
+
+/**
+ * Statistics from a residual sum of squares.
+ * @param residual (input) Weighted residual sum of squares.
+ * @param terms (input) Number of coefficients fitted.
+ * @param statistics (output) Statistics.
+ */
+void
+PolynomialFitter::SetStatistics(
+	double residual,
+	int terms,
+	TFitStatistics *statistics) const
+{
+	statistics->m_Count = m_Count;
+	statistics->m_WeightSum = m_WeightSum;
+	statistics->m_ResidualSumOfSquares = residual;
+	statistics->m_RmsResidual = (m_WeightSum > 0) ? sqrt(residual / m_WeightSum) : 0;
+	statistics->m_StandardError = (m_Count > terms) ?
+		sqrt(residual / (m_Count - terms)) : 0;
+	statistics->m_RSquared = (m_SpreadY > 0) ? 1 - residual / m_SpreadY : 1;
+}
@@ -0,0 +1,270 @@
+/**
+ * Title: PolynomialFitter.h
+ * Description: Least squares polynomial fits to streams of points.
+ * @author Mary Wyllie
+ */
+
+#ifndef POLYNOMIALFITTER_H
+#define POLYNOMIALFITTER_H 1
+
+#include "MathBase.h"
+#include "PointSet.h"
+#include "PointSink.h"
+#include "Polynomial.h"
+#include <vector>
+
+//-----------------------------------------------
+// Blocks of at least this many points are fitted
+// in parts of this size, shared between threads.
+//-----------------------------------------------
+const int MATH_FIT_PARALLEL = 65536;
+
+/**
+ * How well a polynomial fits the points given to a fitter. Sums are
+ * weighted.
+ */
+typedef struct TFitStatistics
+{
+	double m_Count;                 // Points given.
+	double m_WeightSum;
+	double m_ResidualSumOfSquares;  // Sum of w (y - p(x))^2
+	double m_RmsResidual;           // sqrt(residual sum / weight sum)
+	double m_StandardError;         // sqrt(residual sum / (count - terms))
+	double m_RSquared;              // 1 - residual sum / total sum about the mean
+} TFitStatistics;
+
+/**
+ * Least squares fit of a polynomial of a given degree to points which
+ * arrive a few at a time, such as a sensor stream far too long to hold
+ * in memory. Nothing is kept of the points but a QR factorization of
+ * their design matrix, (degree + 1)^2 / 2 numbers, which each point
+ * updates by Givens rotations. Unlike the normal equations, this does
+ * not square the condition number.
+ *
+ * The design matrix is in the Chebyshev polynomials T_k(t) of t, x
+ * mapped from the fitting range onto [-1, 1], rather than in powers of
+ * x, which are close to dependent for high degrees or ranges far from
+ * 0. Points may lie outside the fitting range, at some cost in
+ * conditioning.
+ *
+ * Fitters over parts of the same data, for example one for each
+ * thread, are combined with Merge; AddBlock does so itself for long
+ * blocks when OpenMP is enabled. Because columns are in increasing
+ * degree, the factorization also gives the fit of every lower degree.
+ * GetStatistics measures any polynomial, such as a fit whose
+ * coefficients have since been adjusted, against the data seen without
+ * reading it again.
+ *
+ * The fit as a Polynomial in powers of x loses digits when the range is
+ * far from 0 compared with its width; GetChebyshevFit gives the fit in
+ * the basis it was solved in.
+ */
+class PolynomialFitter :
+	public MathBase,
+	public PointSink
+{
+public:
+
+	/**
+ 	 * Constructor.
+ 	 * @param degree (input) Highest degree fitted.
+ 	 * @param xMin (input) Lowest x expected.
+ 	 * @param xMax (input) Highest x expected, above xMin.
+ 	 * @param setting (optional input) setting (optional epsilon/angleMode).
+ 	 */
+	PolynomialFitter(
+		int degree,
+		double xMin,
+		double xMax,
+		MathSetting *setting = NULL);
+
+	/**
+ 	 * Destructor.
+ 	 */
+	virtual
+	~PolynomialFitter();
+
+	/**
+ 	 * Receive the next point, of weight 1.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 * @return True.
+ 	 */
+	virtual bool
+	AddPoint(
+		double x,
+		double y)
+		{ AddWeighted(x, y, 1.0); return(true); };
+
+	/**
+ 	 * Add a weighted point.
+ 	 * @param x (input) X coordinate of point.
+ 	 * @param y (input) Y coordinate of point.
+ 	 * @param weight (input) Weight, at least 0; for example the inverse
+ 	 * of the variance of y.
+ 	 */
+	void
+	AddWeighted(
+		double x,
+		double y,
+		double weight);
+
+	/**
+ 	 * Add a block of points, shared between threads when long.
+ 	 * @param x (input) X coordinates.
+ 	 * @param y (input) Y coordinates.
+ 	 * @param weight (input) Weight of each point, or NULL for 1.
+ 	 * @param count (input) Number of points.
+ 	 */
+	void
+	AddBlock(
+		const double *x,
+		const double *y,
+		const double *weight,
+		int count);
+
+	/**
+ 	 * Add every point of a set.
+ 	 * @param points (input) Points, each of weight 1.
+ 	 */
+	void
+	AddPoints(
+		const PointSet& points)
+		{ AddBlock(points.GetXData(), points.GetYData(), NULL, points.GetSize()); };
+
+	/**
+ 	 * Add the points given to another fitter of the same degree and
+ 	 * range, as if they had been given to this one.
+ 	 * @param other (input) Fitter to merge.
+ 	 * @return MATH_UNDEFINED if the degree or range differ.
+ 	 */
+	TMathResult
+	Merge(
+		const PolynomialFitter& other);
+
+	/**
+ 	 * Forget every point.
+ 	 */
+	void
+	Clear();
+
+	/**
+ 	 * Least squares fit.
+ 	 * @param polynomial (output) Polynomial fitted, coefficients in x.
+ 	 * @param statistics (optional output) How well it fits.
+ 	 * @param degree (optional input) Degree to fit, at most the
+ 	 * fitter's; -1 for the fitter's.
+ 	 * @return MATH_UNDEFINED if the points do not determine the fit,
+ 	 * for example fewer distinct x values than coefficients.
+ 	 */
+	TMathResult
+	GetFit(
+		Polynomial *polynomial,
+		TFitStatistics *statistics = NULL,
+		int degree = -1) const;
+
+	/**
+ 	 * Least squares fit in the Chebyshev basis.
+ 	 * @param coefficients (output) Coefficient of each T_k(t), where
+ 	 * t = (2x - xMax - xMin) / (xMax - xMin).
+ 	 * @param degree (optional input) Degree to fit; -1 for the fitter's.
+ 	 * @return MATH_UNDEFINED if the points do not determine the fit.
+ 	 */
+	TMathResult
+	GetChebyshevFit(
+		std::vector<double> *coefficients,
+		int degree = -1) const;
+
+	/**
+ 	 * Measure a polynomial against the points seen, from the
+ 	 * factorization alone.
+ 	 * @param polynomial (input) Any polynomial up to the fitter's
+ 	 * degree, coefficients in x.
+ 	 * @param statistics (output) How well it fits.
+ 	 * @return MATH_UNDEFINED if its degree is too high.
+ 	 */
+	TMathResult
+	GetStatistics(
+		Polynomial& polynomial,
+		TFitStatistics *statistics) const;
+
+	/**
+ 	 * Get the highest degree fitted.
+ 	 * @return Degree.
+ 	 */
+	int
+	GetDegree() const
+		{ return(m_Size - 1); };
+
+	/**
+ 	 * Get the number of points given.
+ 	 * @return Number of points.
+ 	 */
+	double
+	GetCount() const
+		{ return(m_Count); };
+
+protected:
+
+	/**
+ 	 * Rotate one weighted row of the design matrix into the
+ 	 * factorization.
+ 	 * @param row (input/output) Row, scaled by the square root of the
+ 	 * weight. Destroyed.
+ 	 * @param y (input) Right hand side, scaled the same way.
+ 	 */
+	void
+	AddRow(
+		double *row,
+		double y);
+
+	/**
+ 	 * Chebyshev polynomials T_0(t) ... T_(size-1)(t) at x.
+ 	 */
+	void
+	GetBasis(
+		double x,
+		double *row) const;
+
+	/**
+ 	 * Statistics from a residual sum of squares.
+ 	 */
+	void
+	SetStatistics(
+		double residual,
+		int terms,
+		TFitStatistics *statistics) const;
+
+protected:
+
+	/**
+ 	 * Number of coefficients and the map from x to t = m_Scale x +
+ 	 * m_Offset.
+ 	 */
+	int m_Size;
+	double m_XMin;
+	double m_XMax;
+	double m_Scale;
+	double m_Offset;
+
+	/**
+ 	 * Upper triangle R of the factorization, row by row in a square
+ 	 * array, and Q^T y.
+ 	 */
+	std::vector<double> m_R;
+	std::vector<double> m_QtY;
+
+	/**
+ 	 * Sums over the points: the residual of the full degree fit,
+ 	 * and for the statistics the count, weight, weighted mean of y
+ 	 * and weighted sum of squares about it.
+ 	 */
+	double m_Residual;
+	double m_Count;
+	double m_WeightSum;
+	double m_MeanY;
+	double m_SpreadY;
+
+};
+
+#endif
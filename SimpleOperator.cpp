@@ -3,6 +3,8 @@
  */
 
 #include "SimpleOperator.h"
+#include "TrigFunction.h"
+#include "MathKernels.h"
 #include <math.h>
 
 /**
@@ -15,6 +17,8 @@ SimpleOperator::SimpleOperator()
 	m_Rhs = NULL;
 	m_RightConstant = NULL;
 	m_LeftConstant = NULL;
+	m_Power = ChoosePower(NULL, NULL);
+	m_IsSharedTrig = false;
 }
 
 /**
@@ -28,6 +32,11 @@ SimpleOperator::SimpleOperator(
 {
 	m_Lhs = lhs;
 	m_Rhs = rhs;
+	m_RightConstant = NULL;
+	m_LeftConstant = NULL;
+	m_Operator = oper;
+	m_Power = ChoosePower(NULL, NULL);
+	m_IsSharedTrig = TrigFunction::IsSameArgument(lhs, rhs);
 }
 
 /**
@@ -43,6 +52,9 @@ SimpleOperator::SimpleOperator(
 	m_Rhs = NULL;
 	m_RightConstant = new double(rightConstant);
 	m_LeftConstant = NULL;
+	m_Operator = oper;
+	m_Power = ChoosePower(NULL, m_RightConstant);
+	m_IsSharedTrig = false;
 }
 
 /**
@@ -59,6 +71,8 @@ SimpleOperator::SimpleOperator(
 	m_Rhs = rhs;
 	m_RightConstant = NULL;
 	m_Operator = oper;
+	m_Power = ChoosePower(m_LeftConstant, NULL);
+	m_IsSharedTrig = false;
 }
 
 /**
@@ -81,7 +95,6 @@ SimpleOperator::CalculateY(
 	double *y)
 {
 	TMathResult status = MATH_SUCCESS;
-	double result = 0;
 	double left = 0, right = 0;
 
 	//------------------------------------------------
@@ -108,10 +121,310 @@ SimpleOperator::CalculateY(
 	}
 	if(status != MATH_SUCCESS) return status;
 
+	return(Apply(GetOperatorType(), left, right, GetEpsilon(), y, &m_Power));
+}
+
+/**
+ * Calculate a block of points. Operands which are trig functions of
+ * the same argument are calculated together; otherwise each point is
+ * calculated in turn.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+SimpleOperator::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	if(m_IsSharedTrig)
+		CalculateSharedBlock(x, y, status, count);
+	else
+		MathOperation::CalculateYBlock(x, y, status, count);
+}
+
+/**
+ * Calculate a block of points in single precision. Operands are
+ * calculated a block at a time and then combined.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+SimpleOperator::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	float left[MATH_BLOCK_SIZE], right[MATH_BLOCK_SIZE];
+	TMathResult rightStatus[MATH_BLOCK_SIZE];
+
+	if(m_IsSharedTrig)
+	{
+		CalculateSharedBlock(x, y, status, count);
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+
+		if(m_Lhs)
+		{
+			m_Lhs->CalculateYBlock(x + start, left, blockStatus, n);
+		}
+		else
+		{
+			float value = m_LeftConstant ? (float) *m_LeftConstant : 0;
+			for(int j = 0; j < n; j++)
+			{
+				left[j] = value;
+				blockStatus[j] = MATH_SUCCESS;
+			}
+		}
+
+		if(m_Rhs)
+		{
+			m_Rhs->CalculateYBlock(x + start, right, rightStatus, n);
+			for(int j = 0; j < n; j++)
+			{
+				if(rightStatus[j] != MATH_SUCCESS) blockStatus[j] = MATH_UNDEFINED;
+			}
+		}
+		else
+		{
+			float value = m_RightConstant ? (float) *m_RightConstant : 0;
+			for(int j = 0; j < n; j++) right[j] = value;
+		}
+
+		KernelApplyBlock(GetOperatorType(), (float) GetEpsilon(),
+			left, right, y + start, blockStatus, n, &m_Power);
+	}
+}
+
+/**
+ * Calculate a block of points for either scalar type from one sine
+ * and cosine of the operands' shared argument (see
+ * TrigFunction::CalculateShared).
+ */
+template <class T>
+void
+SimpleOperator::CalculateSharedBlock(
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count)
+{
+	MathFunction *functions[2] = { m_Lhs, m_Rhs };
+	T left[MATH_BLOCK_SIZE], right[MATH_BLOCK_SIZE];
+	TMathResult rightStatus[MATH_BLOCK_SIZE];
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+		T *values[2] = { left, right };
+		TMathResult *statuses[2] = { blockStatus, rightStatus };
+
+		TrigFunction::CalculateShared(functions, 2, x + start, values, statuses, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(rightStatus[j] != MATH_SUCCESS) blockStatus[j] = MATH_UNDEFINED;
+		}
+		KernelApplyBlock(GetOperatorType(), (T) GetEpsilon(),
+			left, right, y + start, blockStatus, n, &m_Power);
+	}
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. Operands
+ * are calculated a block at a time and combined without branches;
+ * an undefined operand's NaN carries through the operator.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+SimpleOperator::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	double left[MATH_BLOCK_SIZE], right[MATH_BLOCK_SIZE];
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+
+		if(m_Lhs)
+		{
+			m_Lhs->CalculateYBlockNaN(x + start, left, n);
+		}
+		else
+		{
+			double value = m_LeftConstant ? *m_LeftConstant : 0;
+			for(int j = 0; j < n; j++) left[j] = value;
+		}
+
+		if(m_Rhs)
+		{
+			m_Rhs->CalculateYBlockNaN(x + start, right, n);
+		}
+		else
+		{
+			double value = m_RightConstant ? *m_RightConstant : 0;
+			for(int j = 0; j < n; j++) right[j] = value;
+		}
+
+		KernelApplyBlockNaN(GetOperatorType(), GetEpsilon(),
+			left, right, y + start, n, &m_Power);
+	}
+}
+
+/**
+ * Calculate points at equally spaced x values, sampling each operand
+ * function in the same way (see MathFunction::SampleUniform) and then
+ * combining them a block at a time.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+SimpleOperator::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	double left[MATH_BLOCK_SIZE], right[MATH_BLOCK_SIZE];
+	TMathResult rightStatus[MATH_BLOCK_SIZE];
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+		double blockStart = xStart + (double) start * step;
+
+		if(m_Lhs)
+		{
+			m_Lhs->SampleUniform(blockStart, step, left, blockStatus, n);
+		}
+		else
+		{
+			double value = m_LeftConstant ? *m_LeftConstant : 0;
+			for(int j = 0; j < n; j++)
+			{
+				left[j] = value;
+				blockStatus[j] = MATH_SUCCESS;
+			}
+		}
+
+		if(m_Rhs)
+		{
+			m_Rhs->SampleUniform(blockStart, step, right, rightStatus, n);
+			for(int j = 0; j < n; j++)
+			{
+				if(rightStatus[j] != MATH_SUCCESS) blockStatus[j] = MATH_UNDEFINED;
+			}
+		}
+		else
+		{
+			double value = m_RightConstant ? *m_RightConstant : 0;
+			for(int j = 0; j < n; j++) right[j] = value;
+		}
+
+		KernelApplyBlock(GetOperatorType(), GetEpsilon(),
+			left, right, y + start, blockStatus, n, &m_Power);
+	}
+}
+
+/**
+ * Bound this function over a range of x, from the bounds of the
+ * operands.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+SimpleOperator::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	TMathResult status = MATH_SUCCESS;
+	Interval left, right;
+
+	if(m_Lhs)
+		status = m_Lhs->CalculateInterval(x, &left);
+	else if(m_LeftConstant)
+		left = Interval(*m_LeftConstant);
+
+	if(status == MATH_SUCCESS)
+	{
+		if(m_Rhs)
+			status = m_Rhs->CalculateInterval(x, &right);
+		else if(m_RightConstant)
+			right = Interval(*m_RightConstant);
+	}
+	if(status != MATH_SUCCESS) return status;
+
+	switch(GetOperatorType())
+	{
+	case MATH_ADD:
+		*y = left + right;
+		break;
+	case MATH_SUBTRACT:
+		*y = left - right;
+		break;
+	case MATH_MULTIPLY:
+		*y = left * right;
+		break;
+	case MATH_DIVIDE:
+		return(left.Divide(right, GetEpsilon(), y));
+	case MATH_POWER:
+		return(left.Power(right, y));
+	default:
+		return MATH_UNDEFINED;
+	}
+	return status;
+}
+
+/**
+ * Apply an operator to its two operand values.
+ * @param type (input) MATH_ADD, MATH_SUBTRACT, MATH_MULTIPLY,
+ * MATH_DIVIDE or MATH_POWER.
+ * @param left (input) Left operand (base for MATH_POWER).
+ * @param right (input) Right operand (exponent for MATH_POWER).
+ * @param epsilon (input) Divisors within this of 0 are undefined.
+ * @param y (output) Result value.
+ * @param power (optional input) How to calculate MATH_POWER (see
+ * ChoosePower), pow if NULL.
+ * @return TMathResult for successful calculation (or not).
+ */
+TMathResult
+SimpleOperator::Apply(
+	TOperatorType type,
+	double left,
+	double right,
+	double epsilon,
+	double *y,
+	const TPowerStrategy *power)
+{
+	TMathResult status = MATH_SUCCESS;
+	double result = 0;
+
 	//----------------------
 	// Apply the operator.
 	//----------------------
-	switch(GetOperatorType())
+	switch(type)
 	{
 	case MATH_ADD:
 		result = left + right;
@@ -123,7 +436,7 @@ SimpleOperator::CalculateY(
 		result = left * right;
 		break;
 	case MATH_DIVIDE:
-		if(!IsEqual(right, 0))
+		if(!IsWithin(right, 0, epsilon))
 			result = left / right;
 		else
 			status = MATH_UNDEFINED;
@@ -133,7 +446,10 @@ SimpleOperator::CalculateY(
 		// In the case of the power, left hand side will
 		// be the base, and right hand side the exponent.
 		//------------------------------------------------
-		result = pow(left, right);
+		if(power)
+			result = KernelPower(*power, left, right);
+		else
+			result = pow(left, right);
 		break;
 	}
 
@@ -143,4 +459,66 @@ SimpleOperator::CalculateY(
 	return status;
 }
 
+/**
+ * Choose how to calculate a power from whichever of its operands
+ * are constant.
+ * @param base (input) Constant base, NULL if a function.
+ * @param exponent (input) Constant exponent, NULL if a function.
+ * @return Strategy.
+ */
+TPowerStrategy
+SimpleOperator::ChoosePower(
+	const double *base,
+	const double *exponent)
+{
+	TPowerStrategy power;
+	power.m_Method = MATH_POWER_GENERAL;
+	power.m_Exponent = 0;
+	power.m_IsReciprocal = false;
+	power.m_LogBase = 0;
+
+	if(exponent)
+	{
+		double size = fabs(*exponent);
+		double whole = floor(size);
+		if(size <= MATH_POWER_MAX_WHOLE && (size == whole || size - whole == 0.5))
+		{
+			power.m_Method = (size == whole) ? MATH_POWER_WHOLE : MATH_POWER_HALF;
+			power.m_Exponent = (int) whole;
+			power.m_IsReciprocal = (*exponent < 0);
+		}
+	}
+	else if(base && *base > 0 && *base != 1)
+	{
+		power.m_Method = MATH_POWER_EXP;
+		power.m_LogBase = log(*base);
+	}
+	return power;
+}
+
+/**
+ * Get the operand functions: left, then right. A constant
+ * operand is given as NULL.
+ * @param children (output) Operand functions.
+ */
+void
+SimpleOperator::GetChildren(
+	std::vector<MathFunction*> *children)
+{
+	children->clear();
+	children->push_back(m_Lhs);
+	children->push_back(m_Rhs);
+}
 
+/**
+ * Get a constant operand.
+ * @param i (input) 0 for the left operand, 1 for the right.
+ * @return Constant value.
+ */
+double
+SimpleOperator::GetConstant(
+	int i)
+{
+	double *value = (i == 0) ? m_LeftConstant : m_RightConstant;
+	return(value ? *value : 0);
+}
@@ -11,6 +11,11 @@
 #include "MathOperation.h"
 #include <string>
 
+/**
+ * Largest whole exponent calculated by repeated squaring.
+ */
+const int MATH_POWER_MAX_WHOLE = 64;
+
 /**
  * Base class for a mathematical function.
  */
@@ -68,6 +73,157 @@ public:
 		double x,
 		double *y);
 
+	/**
+	 * Calculate a block of points. Operands which are trig functions
+	 * of the same argument are calculated together; otherwise each
+	 * point is calculated in turn.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values, sampling each
+	 * operand function in the same way and then combining them.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Apply an operator to its two operand values.
+	 * @param type (input) MATH_ADD, MATH_SUBTRACT, MATH_MULTIPLY,
+	 * MATH_DIVIDE or MATH_POWER.
+	 * @param left (input) Left operand (base for MATH_POWER).
+	 * @param right (input) Right operand (exponent for MATH_POWER).
+	 * @param epsilon (input) Divisors within this of 0 are undefined.
+	 * @param y (output) Result value.
+	 * @param power (optional input) How to calculate MATH_POWER (see
+	 * ChoosePower), pow if NULL.
+	 * @return TMathResult for successful calculation (or not).
+	 */
+	static TMathResult
+	Apply(
+		TOperatorType type,
+		double left,
+		double right,
+		double epsilon,
+		double *y,
+		const TPowerStrategy *power = NULL);
+
+	/**
+	 * Choose how to calculate a power from whichever of its operands
+	 * are constant. Whole exponents up to MATH_POWER_MAX_WHOLE in size
+	 * use repeated squaring, and exponents a half more than those a
+	 * square root; a constant base above 0 (other than 1) uses exp of
+	 * a precomputed log. Anything else uses pow.
+	 *
+	 * The special methods round differently from pow: whole powers
+	 * lose up to about 2 log2(n) ulps, and exp(f ln b) about |f ln b|
+	 * ulps.
+	 * @param base (input) Constant base, NULL if a function.
+	 * @param exponent (input) Constant exponent, NULL if a function.
+	 * @return Strategy.
+	 */
+	static TPowerStrategy
+	ChoosePower(
+		const double *base,
+		const double *exponent);
+
+	/**
+	 * Get the operand functions: left, then right. A constant
+	 * operand is given as NULL.
+	 * @param children (output) Operand functions.
+	 */
+	virtual void
+	GetChildren(
+		std::vector<MathFunction*> *children);
+
+	/**
+	 * Constants are the left and then the right operand, 0 for
+	 * an operand which is a function.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return 2; };
+
+	/**
+	 * Get a constant operand.
+	 * @param i (input) 0 for the left operand, 1 for the right.
+	 * @return Constant value.
+	 */
+	virtual double
+	GetConstant(
+		int i);
+
+protected:
+
+	/**
+	 * Calculate a block of points for either scalar type from one
+	 * sine and cosine of the operands' shared argument.
+	 */
+	template <class T>
+	void
+	CalculateSharedBlock(
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count);
+
 protected:
 	/**
 	 * The left and right operands may be functions or
@@ -80,6 +236,19 @@ protected:
 	double *m_LeftConstant;
 	double *m_RightConstant;
 
+	//------------------------------------------
+	// How MATH_POWER is calculated, chosen from
+	// the constant operands when built.
+	//------------------------------------------
+	TPowerStrategy m_Power;
+
+	//------------------------------------------
+	// Both operands are trig functions of the
+	// same argument (see TrigFunction), so they
+	// can share one sine and cosine.
+	//------------------------------------------
+	bool m_IsSharedTrig;
+
 };
 
 #endif
@@ -0,0 +1,248 @@
+/**
+ * Title: SparsePolynomial
+ * Polynomial stored as its non-zero terms.
+ * @author Mary Wyllie
+ */
+
+#include "SparsePolynomial.h"
+#include "MathKernels.h"
+#include <algorithm>
+#include <utility>
+
+/**
+ * Constructor.
+ */
+SparsePolynomial::SparsePolynomial()
+{
+	m_Operator = MATH_POLYNOMIAL;
+	m_Size = 0;
+}
+
+/**
+ * Constructor from a coefficient for each power of x. Zero
+ * coefficients are left out.
+ * @param coefficients (input) List of coefficients, lowest power first.
+ */
+SparsePolynomial::SparsePolynomial(
+	const std::vector<double>& coefficients)
+{
+	m_Operator = MATH_POLYNOMIAL;
+	m_Size = (int) coefficients.size();
+	for(int i = 0; i < m_Size; i++)
+	{
+		if(coefficients[i] == 0) continue;
+		m_Exponents.push_back(i);
+		m_Coefficients.push_back(coefficients[i]);
+		m_FloatCoefficients.push_back((float) coefficients[i]);
+	}
+}
+
+/**
+ * Constructor from terms. Terms may be in any order; terms of the
+ * same exponent are added together and zero terms left out.
+ * @param exponents (input) Exponent of each term, at least 0.
+ * @param coefficients (input) Coefficient of each term.
+ */
+SparsePolynomial::SparsePolynomial(
+	const std::vector<int>& exponents,
+	const std::vector<double>& coefficients)
+{
+	m_Operator = MATH_POLYNOMIAL;
+	m_Size = 0;
+
+	std::vector< std::pair<int, double> > terms;
+	for(size_t i = 0; i < exponents.size() && i < coefficients.size(); i++)
+	{
+		terms.push_back(std::make_pair(exponents[i], coefficients[i]));
+	}
+	std::sort(terms.begin(), terms.end());
+
+	for(size_t i = 0; i < terms.size(); )
+	{
+		int exponent = terms[i].first;
+		double coefficient = 0;
+		for( ; i < terms.size() && terms[i].first == exponent; i++)
+		{
+			coefficient += terms[i].second;
+		}
+		if(coefficient == 0) continue;
+
+		m_Exponents.push_back(exponent);
+		m_Coefficients.push_back(coefficient);
+		m_FloatCoefficients.push_back((float) coefficient);
+		m_Size = exponent + 1;
+	}
+}
+
+/**
+ * Destructor.
+ */
+SparsePolynomial::~SparsePolynomial()
+{
+}
+
+/**
+ * Whether coefficients are sparse enough to be stored by term. Each
+ * term costs a few multiplications for the power ladder where a dense
+ * polynomial costs one multiply-add per power, so the terms must be
+ * well spread out to gain.
+ * @param coefficients (input) List of coefficients, lowest power first.
+ * @return true to store them as a SparsePolynomial.
+ */
+bool
+SparsePolynomial::IsSparse(
+	const std::vector<double>& coefficients)
+{
+	int size = (int) coefficients.size();
+	if(size < MATH_SPARSE_MIN_SIZE) return false;
+
+	int terms = 0;
+	for(int i = 0; i < size; i++)
+	{
+		if(coefficients[i] != 0) terms++;
+	}
+	return (terms <= MATH_SPARSE_DENSITY * size);
+}
+
+/**
+ * Virtual function to calculate a point for this function.
+ * @param x (input) x input value for this function.
+ * @return Y value corresponding to the x input.
+ */
+TMathResult
+SparsePolynomial::CalculateY(
+	double x,
+	double *y)
+{
+	*y = Evaluate(m_Exponents.empty() ? NULL : &m_Exponents[0],
+		m_Coefficients.empty() ? NULL : &m_Coefficients[0],
+		(int) m_Exponents.size(), x);
+	return MATH_SUCCESS;
+}
+
+/**
+ * Calculate a block of points, each term across the block.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+SparsePolynomial::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(m_Coefficients.empty() ? NULL : &m_Coefficients[0],
+		x, y, status, count);
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+SparsePolynomial::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(m_FloatCoefficients.empty() ? NULL : &m_FloatCoefficients[0],
+		x, y, status, count);
+}
+
+/**
+ * Calculate a block of points for either scalar type, a tile of
+ * MATH_BLOCK_SIZE points at a time.
+ */
+template <class T, class C>
+void
+SparsePolynomial::EvaluateBlock(
+	const C *coefficients,
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count)
+{
+	const int *exponents = m_Exponents.empty() ? NULL : &m_Exponents[0];
+	int terms = (int) m_Exponents.size();
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		KernelSparsePolynomialBlock(exponents, coefficients, terms,
+			x + start, y + start, status + start, n);
+	}
+}
+
+/**
+ * Bound this function over a range of x, as the sum of the bounds of
+ * the terms. Whole powers of an interval are exact, so each term is
+ * bounded exactly and only the sum overestimates; Horner's rule over
+ * the terms would multiply the overestimates together.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) for every x in the range.
+ * @return MATH_SUCCESS
+ */
+TMathResult
+SparsePolynomial::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	Interval result(0);
+	for(size_t i = 0; i < m_Exponents.size(); i++)
+	{
+		result = result + Interval(m_Coefficients[i]) * x.Power(m_Exponents[i]);
+	}
+	*y = result;
+	y->SetMayBeUndefined(x.MayBeUndefined());
+	return MATH_SUCCESS;
+}
+
+/**
+ * Calculate the value of a sparse polynomial by Horner's rule over the
+ * terms, stepping between neighbouring exponents by repeated squaring.
+ * @param exponents (input) Exponent of each term, increasing.
+ * @param coefficients (input) Coefficient of each term.
+ * @param terms (input) Number of terms.
+ * @param x (input) x input value.
+ * @return Polynomial value at x.
+ */
+double
+SparsePolynomial::Evaluate(
+	const int *exponents,
+	const double *coefficients,
+	int terms,
+	double x)
+{
+	if(terms <= 0) return 0;
+
+	double result = coefficients[terms - 1];
+	for(int i = terms - 2; i >= 0; i--)
+	{
+		result = result * KernelPowWhole(x, exponents[i + 1] - exponents[i]) +
+			coefficients[i];
+	}
+	if(exponents[0] > 0) result *= KernelPowWhole(x, exponents[0]);
+	return result;
+}
+
+/**
+ * Get a coefficient.
+ * @param i (input) Power of x.
+ * @return Coefficient value, 0 where there is no term.
+ */
+double
+SparsePolynomial::GetConstant(
+	int i)
+{
+	std::vector<int>::const_iterator found =
+		std::lower_bound(m_Exponents.begin(), m_Exponents.end(), i);
+	if(found == m_Exponents.end() || *found != i) return 0;
+	return m_Coefficients[found - m_Exponents.begin()];
+}
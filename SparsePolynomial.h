@@ -0,0 +1,224 @@
+/**
+ * Title: SparsePolynomial
+ * Polynomial stored as its non-zero terms.
+ * @author Mary Wyllie
+ */
+
+#ifndef SPARSEPOLYNOMIAL_H
+#define SPARSEPOLYNOMIAL_H
+
+#include "MathOperation.h"
+#include <vector>
+
+//-----------------------------------------------
+// MathFunction stores a polynomial sparse when it
+// has at least this many coefficients and no more
+// than this fraction of them are non-zero.
+//-----------------------------------------------
+const int MATH_SPARSE_MIN_SIZE = 16;
+const double MATH_SPARSE_DENSITY = 0.25;
+
+/**
+ * Class for a polynomial with few terms for its degree, such as
+ * x^1000 + 3x^7 + 1, stored as (exponent, coefficient) pairs in
+ * increasing order of exponent. Only the terms are stored and read.
+ *
+ * It is evaluated by Horner's rule over the terms, stepping between
+ * neighbouring exponents with a power ladder: x^1000 + 3x^7 + 1 is
+ * (x^993 + 3) x^7 + 1, and each power takes about 2 log2(gap)
+ * multiplications by repeated squaring.
+ *
+ * It is a MATH_POLYNOMIAL like Polynomial, and gives the same constants,
+ * one coefficient per power of x, so code working on polynomials
+ * through GetConstant need not know how it is stored. A MathFunction
+ * built with MATH_POLYNOMIAL chooses it when the coefficients are
+ * sparse enough (see IsSparse).
+ */
+class
+SparsePolynomial :
+	public MathOperation
+{
+public:
+
+	/**
+	 * Constructor.
+	 */
+	SparsePolynomial();
+
+	/**
+	 * Constructor from a coefficient for each power of x. Zero
+	 * coefficients are left out.
+	 * @param coefficients (input) List of coefficients, lowest power first.
+	 */
+	SparsePolynomial(
+		const std::vector<double>& coefficients);
+
+	/**
+	 * Constructor from terms. Terms may be in any order; terms of the
+	 * same exponent are added together and zero terms left out.
+	 * @param exponents (input) Exponent of each term, at least 0.
+	 * @param coefficients (input) Coefficient of each term.
+	 */
+	SparsePolynomial(
+		const std::vector<int>& exponents,
+		const std::vector<double>& coefficients);
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~SparsePolynomial();
+
+	/**
+	 * Whether coefficients are sparse enough to be stored by term:
+	 * at least MATH_SPARSE_MIN_SIZE of them, and at most
+	 * MATH_SPARSE_DENSITY of them non-zero.
+	 * @param coefficients (input) List of coefficients, lowest power first.
+	 * @return true to store them as a SparsePolynomial.
+	 */
+	static bool
+	IsSparse(
+		const std::vector<double>& coefficients);
+
+	/**
+	 * Get the number of terms.
+	 * @return Number of non-zero terms.
+	 */
+	int
+	GetTermCount()
+		{ return (int) m_Exponents.size(); };
+
+	/**
+	 * Get the exponent of a term.
+	 * @param i (input) Term, in increasing order of exponent.
+	 * @return Exponent.
+	 */
+	int
+	GetExponent(
+		int i)
+		{ return m_Exponents[i]; };
+
+	/**
+	 * Get the coefficient of a term.
+	 * @param i (input) Term, in increasing order of exponent.
+	 * @return Coefficient.
+	 */
+	double
+	GetCoefficient(
+		int i)
+		{ return m_Coefficients[i]; };
+
+	/**
+	 * Virtual function to calculate a point for this function.
+	 * @param x (input) x input value for this function.
+	 * @return Y value corresponding to the x input.
+	 */
+	virtual TMathResult
+	CalculateY(
+		double x,
+		double *y);
+
+	/**
+	 * Calculate a block of points, each term across the block.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x, as the sum of the exact
+	 * bounds of the terms.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) for every x in the range.
+	 * @return MATH_SUCCESS
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate the value of a sparse polynomial.
+	 * @param exponents (input) Exponent of each term, increasing.
+	 * @param coefficients (input) Coefficient of each term.
+	 * @param terms (input) Number of terms.
+	 * @param x (input) x input value.
+	 * @return Polynomial value at x.
+	 */
+	static double
+	Evaluate(
+		const int *exponents,
+		const double *coefficients,
+		int terms,
+		double x);
+
+	/**
+	 * Constants are the coefficients of every power of x up to the
+	 * degree, lowest first, as for Polynomial.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return m_Size; };
+
+	/**
+	 * Get a coefficient.
+	 * @param i (input) Power of x.
+	 * @return Coefficient value, 0 where there is no term.
+	 */
+	virtual double
+	GetConstant(
+		int i);
+
+protected:
+
+	/**
+	 * Calculate a block of points for either scalar type.
+	 */
+	template <class T, class C>
+	void
+	EvaluateBlock(
+		const C *coefficients,
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count);
+
+protected:
+	std::vector<int> m_Exponents;
+	std::vector<double> m_Coefficients;
+
+	//------------------------------------------
+	// Rounded once when built, for the float
+	// block kernel.
+	//------------------------------------------
+	std::vector<float> m_FloatCoefficients;
+
+	//------------------------------------------
+	// Number of coefficients of the dense form.
+	//------------------------------------------
+	int m_Size;
+};
+
+#endif
@@ -0,0 +1,421 @@
+/**
+ * Title: Spline
+ * Function interpolating a set of points.
+ * @author Mary Wyllie
+ */
+
+#include "Spline.h"
+#include "MathKernels.h"
+#include <math.h>
+#include <float.h>
+
+//-----------------------------------------------
+// Knots are evenly spaced when each is within
+// this fraction of the spacing of its place, so
+// that x divided by the spacing is at most one
+// segment out.
+//-----------------------------------------------
+static const double MATH_SPLINE_UNIFORM = 0.01;
+
+/**
+ * Bound a segment's cubic a + t(b + t(c + t d)) for t in [t0, t1], from
+ * its value at the ends and where its derivative is 0, widened by the
+ * rounding of evaluating it.
+ */
+static void
+BoundSegment(
+	const double *s,
+	double t0,
+	double t1,
+	double *lower,
+	double *upper)
+{
+	double roots[2];
+	int rootCount = 0;
+	double a = s[0], b = s[1], c = s[2], d = s[3];
+
+	if(d != 0)
+	{
+		double discriminant = c * c - 3 * d * b;
+		if(discriminant >= 0)
+		{
+			double root = sqrt(discriminant);
+			roots[rootCount++] = (-c + root) / (3 * d);
+			roots[rootCount++] = (-c - root) / (3 * d);
+		}
+	}
+	else if(c != 0)
+	{
+		roots[rootCount++] = -b / (2 * c);
+	}
+
+	double v0 = a + t0 * (b + t0 * (c + t0 * d));
+	double v1 = a + t1 * (b + t1 * (c + t1 * d));
+	*lower = (v0 < v1) ? v0 : v1;
+	*upper = (v0 < v1) ? v1 : v0;
+	for(int i = 0; i < rootCount; i++)
+	{
+		double t = roots[i];
+		if(!(t > t0 && t < t1)) continue;
+		double v = a + t * (b + t * (c + t * d));
+		if(v < *lower) *lower = v;
+		if(v > *upper) *upper = v;
+	}
+
+	double t = (fabs(t0) > fabs(t1)) ? fabs(t0) : fabs(t1);
+	double slack = 8 * DBL_EPSILON *
+		(fabs(a) + t * (fabs(b) + t * (fabs(c) + t * fabs(d))));
+	*lower = Interval::RoundDown(*lower - slack);
+	*upper = Interval::RoundUp(*upper + slack);
+}
+
+/**
+ * Constructor. No knots, undefined everywhere.
+ */
+Spline::Spline()
+{
+	m_Operator = MATH_SPLINE;
+	m_Method = MATH_SPLINE_NATURAL;
+	Build(NULL, NULL, 0);
+}
+
+/**
+ * Constructor.
+ * @param points (input) Knots, in increasing order of x. A point
+ * not to the right of the one before it is skipped.
+ * @param method (input) How knots are joined.
+ */
+Spline::Spline(
+	const PointSet& points,
+	TSplineMethod method)
+{
+	m_Operator = MATH_SPLINE;
+	m_Method = method;
+	Build(points.GetXData(), points.GetYData(), points.GetSize());
+}
+
+/**
+ * Constructor.
+ * @param x (input) Knot x values, increasing. A knot not to the
+ * right of the one before it is skipped.
+ * @param y (input) Knot y values.
+ * @param count (input) Number of knots.
+ * @param method (input) How knots are joined.
+ */
+Spline::Spline(
+	const double *x,
+	const double *y,
+	int count,
+	TSplineMethod method)
+{
+	m_Operator = MATH_SPLINE;
+	m_Method = method;
+	Build(x, y, count);
+}
+
+/**
+ * Destructor.
+ */
+Spline::~Spline()
+{
+}
+
+/**
+ * Fit the segments through a set of knots, and lay them out as
+ * constants.
+ * @param x (input) Knot x values, increasing.
+ * @param y (input) Knot y values.
+ * @param count (input) Number of knots.
+ */
+void
+Spline::Build(
+	const double *x,
+	const double *y,
+	int count)
+{
+	std::vector<double> knots, values;
+	for(int i = 0; i < count; i++)
+	{
+		if(!knots.empty() && !(x[i] > knots.back())) continue;
+		if(x[i] != x[i] || y[i] != y[i]) continue;
+		knots.push_back(x[i]);
+		values.push_back(y[i]);
+	}
+
+	int n = (int) knots.size();
+	m_Constants.clear();
+	m_Constants.push_back(n);
+	m_Constants.push_back(0);
+	m_Constants.insert(m_Constants.end(), knots.begin(), knots.end());
+	if(n < 2) return;
+
+	//-----------------------------------------------
+	// Evenly spaced knots are found by one multiply.
+	//-----------------------------------------------
+	double step = (knots[n - 1] - knots[0]) / (n - 1);
+	bool isUniform = true;
+	for(int i = 1; i < n - 1 && isUniform; i++)
+	{
+		isUniform = (fabs(knots[i] - (knots[0] + i * step)) <=
+			MATH_SPLINE_UNIFORM * step);
+	}
+	if(isUniform) m_Constants[1] = 1 / step;
+
+	std::vector<double> slopes, curvatures;
+	if(m_Method == MATH_SPLINE_MONOTONE)
+		GetMonotoneSlopes(knots, values, &slopes);
+	else if(m_Method == MATH_SPLINE_NATURAL)
+		GetNaturalCurvatures(knots, values, &curvatures);
+
+	for(int i = 0; i < n - 1; i++)
+	{
+		double h = knots[i + 1] - knots[i];
+		double secant = (values[i + 1] - values[i]) / h;
+		double b = secant, c = 0, d = 0;
+
+		if(m_Method == MATH_SPLINE_MONOTONE)
+		{
+			b = slopes[i];
+			c = (3 * secant - 2 * slopes[i] - slopes[i + 1]) / h;
+			d = (slopes[i] + slopes[i + 1] - 2 * secant) / (h * h);
+		}
+		else if(m_Method == MATH_SPLINE_NATURAL)
+		{
+			b = secant - h * (2 * curvatures[i] + curvatures[i + 1]) / 6;
+			c = curvatures[i] / 2;
+			d = (curvatures[i + 1] - curvatures[i]) / (6 * h);
+		}
+
+		m_Constants.push_back(values[i]);
+		m_Constants.push_back(b);
+		m_Constants.push_back(c);
+		m_Constants.push_back(d);
+	}
+}
+
+/**
+ * Slope at each knot for a monotone cubic (Fritsch-Carlson). Interior
+ * slopes start as the mean of the secants either side, or 0 at a peak
+ * or trough; then any pair too steep for its secant, which would make
+ * the cubic overshoot, is scaled back onto the circle of radius 3.
+ * @param x (input) Knot x values, at least 2.
+ * @param y (input) Knot y values.
+ * @param slopes (output) Slope at each knot.
+ */
+void
+Spline::GetMonotoneSlopes(
+	const std::vector<double>& x,
+	const std::vector<double>& y,
+	std::vector<double> *slopes)
+{
+	int n = (int) x.size();
+	std::vector<double> secants(n - 1);
+	for(int i = 0; i < n - 1; i++)
+	{
+		secants[i] = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+	}
+
+	slopes->assign(n, 0);
+	(*slopes)[0] = secants[0];
+	(*slopes)[n - 1] = secants[n - 2];
+	for(int i = 1; i < n - 1; i++)
+	{
+		if(secants[i - 1] * secants[i] > 0)
+			(*slopes)[i] = (secants[i - 1] + secants[i]) / 2;
+	}
+
+	for(int i = 0; i < n - 1; i++)
+	{
+		if(secants[i] == 0)
+		{
+			(*slopes)[i] = 0;
+			(*slopes)[i + 1] = 0;
+			continue;
+		}
+		double alpha = (*slopes)[i] / secants[i];
+		double beta = (*slopes)[i + 1] / secants[i];
+		double radius = alpha * alpha + beta * beta;
+		if(radius > 9)
+		{
+			double tau = 3 / sqrt(radius);
+			(*slopes)[i] = tau * alpha * secants[i];
+			(*slopes)[i + 1] = tau * beta * secants[i];
+		}
+	}
+}
+
+/**
+ * Second derivative at each knot for a natural cubic, 0 at the ends,
+ * by solving the tridiagonal system for continuous slopes (Thomas
+ * algorithm).
+ * @param x (input) Knot x values, at least 2.
+ * @param y (input) Knot y values.
+ * @param curvatures (output) Second derivative at each knot.
+ */
+void
+Spline::GetNaturalCurvatures(
+	const std::vector<double>& x,
+	const std::vector<double>& y,
+	std::vector<double> *curvatures)
+{
+	int n = (int) x.size();
+	curvatures->assign(n, 0);
+	if(n < 3) return;
+
+	//-----------------------------------------------
+	// Forward sweep over the interior knots, leaving
+	// an upper bidiagonal system.
+	//-----------------------------------------------
+	std::vector<double> upper(n, 0), right(n, 0);
+	for(int i = 1; i < n - 1; i++)
+	{
+		double h0 = x[i] - x[i - 1], h1 = x[i + 1] - x[i];
+		double rhs = 6 * ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0);
+		double diagonal = 2 * (h0 + h1) - h0 * upper[i - 1];
+		upper[i] = h1 / diagonal;
+		right[i] = (rhs - h0 * right[i - 1]) / diagonal;
+	}
+	for(int i = n - 2; i >= 1; i--)
+	{
+		(*curvatures)[i] = right[i] - upper[i] * (*curvatures)[i + 1];
+	}
+}
+
+/**
+ * Virtual function to calculate a point for this function.
+ * @param x (input) x input value for this function.
+ * @return Y value corresponding to the x input.
+ */
+TMathResult
+Spline::CalculateY(
+	double x,
+	double *y)
+{
+	return Evaluate(&m_Constants[0], x, y);
+}
+
+/**
+ * Calculate a block of points, the segment of every point found
+ * before any is evaluated.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Spline::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		KernelSplineBlock(&m_Constants[0], x + start, y + start,
+			status + start, n);
+	}
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Spline::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		KernelSplineBlock(&m_Constants[0], x + start, y + start,
+			status + start, n);
+	}
+}
+
+/**
+ * Bound this function over a range of x, from the extremes of each
+ * segment the range meets.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) for every x in the range between
+ * the knots, flagged if the range goes beyond them.
+ * @return MATH_UNDEFINED if the range misses the knots.
+ */
+TMathResult
+Spline::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	int n = GetKnotCount();
+	if(n < 2) return MATH_UNDEFINED;
+
+	const double *knots = &m_Constants[2];
+	const double *segments = knots + n;
+	double lower = (x.GetLower() > knots[0]) ? x.GetLower() : knots[0];
+	double upper = (x.GetUpper() < knots[n - 1]) ? x.GetUpper() : knots[n - 1];
+	if(!(lower <= upper)) return MATH_UNDEFINED;
+
+	int first = KernelSplineSearch(knots, n, lower);
+	int last = KernelSplineSearch(knots, n, upper);
+	double yLower = 0, yUpper = 0;
+	for(int i = first; i <= last; i++)
+	{
+		double t0 = ((lower > knots[i]) ? lower : knots[i]) - knots[i];
+		double t1 = ((upper < knots[i + 1]) ? upper : knots[i + 1]) - knots[i];
+		double segmentLower, segmentUpper;
+		BoundSegment(segments + 4 * i, t0, t1, &segmentLower, &segmentUpper);
+		if(i == first || segmentLower < yLower) yLower = segmentLower;
+		if(i == first || segmentUpper > yUpper) yUpper = segmentUpper;
+	}
+
+	*y = Interval(yLower, yUpper);
+	y->SetMayBeUndefined(x.MayBeUndefined() || x.GetLower() < knots[0] ||
+		x.GetUpper() > knots[n - 1]);
+	return MATH_SUCCESS;
+}
+
+/**
+ * Calculate a spline: find the segment holding x, by one multiply for
+ * evenly spaced knots and a binary search otherwise, and evaluate its
+ * cubic.
+ * @param constants (input) Constants, as GetConstant gives them.
+ * @param x (input) x input value.
+ * @param y (output) Spline value at x.
+ * @return MATH_UNDEFINED outside the knots.
+ */
+TMathResult
+Spline::Evaluate(
+	const double *constants,
+	double x,
+	double *y)
+{
+	int n = (int) constants[0];
+	if(n < 2) return MATH_UNDEFINED;
+
+	const double *knots = constants + 2;
+	if(!(x >= knots[0] && x <= knots[n - 1])) return MATH_UNDEFINED;
+
+	int i;
+	if(constants[1])
+	{
+		i = (int) ((x - knots[0]) * constants[1]);
+		if(i > n - 2) i = n - 2;
+		if(i > 0 && x < knots[i]) i--;
+		else if(i < n - 2 && x >= knots[i + 1]) i++;
+	}
+	else
+	{
+		i = KernelSplineSearch(knots, n, x);
+	}
+
+	const double *s = knots + n + 4 * i;
+	double t = x - knots[i];
+	*y = s[0] + t * (s[1] + t * (s[2] + t * s[3]));
+	return MATH_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/**
+ * Title: Spline
+ * Function interpolating a set of points.
+ * @author Mary Wyllie
+ */
+
+#ifndef SPLINE_H
+#define SPLINE_H
+
+#include "MathOperation.h"
+#include "PointSet.h"
+#include <vector>
+
+/**
+ * Class for a function defined by data rather than a formula: a
+ * piecewise polynomial through a set of points (knots), linear,
+ * monotone cubic or natural cubic (see TSplineMethod). It is defined
+ * from the first knot to the last and undefined outside them.
+ *
+ * Each segment is held as a cubic in the distance t from its first
+ * knot, a + t(b + t(c + t d)), so a point costs a segment lookup and
+ * three multiply-adds. Knots spaced evenly, to within 1% of the
+ * spacing, are found by one multiply; others by a branchless binary
+ * search.
+ *
+ * It is given to a MathFunction as an operation, and can then be used
+ * in any function tree:
+ *
+ *	MathFunction table(new Spline(points, MATH_SPLINE_MONOTONE));
+ *	MathFunction wave(MATH_COMPOSITE, &table, &sinX);
+ *
+ * The knots and coefficients are its constants, so a FunctionImage
+ * stores it.
+ */
+class
+Spline :
+	public MathOperation
+{
+public:
+
+	/**
+	 * Constructor. No knots, undefined everywhere.
+	 */
+	Spline();
+
+	/**
+	 * Constructor.
+	 * @param points (input) Knots, in increasing order of x. A point
+	 * not to the right of the one before it is skipped.
+	 * @param method (input) How knots are joined.
+	 */
+	Spline(
+		const PointSet& points,
+		TSplineMethod method = MATH_SPLINE_NATURAL);
+
+	/**
+	 * Constructor.
+	 * @param x (input) Knot x values, increasing. A knot not to the
+	 * right of the one before it is skipped.
+	 * @param y (input) Knot y values.
+	 * @param count (input) Number of knots.
+	 * @param method (input) How knots are joined.
+	 */
+	Spline(
+		const double *x,
+		const double *y,
+		int count,
+		TSplineMethod method = MATH_SPLINE_NATURAL);
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~Spline();
+
+	/**
+	 * Get how the knots are joined.
+	 * @return Method.
+	 */
+	TSplineMethod
+	GetMethod()
+		{ return m_Method; };
+
+	/**
+	 * Get the number of knots.
+	 * @return Number of knots kept.
+	 */
+	int
+	GetKnotCount()
+		{ return (int) m_Constants[0]; };
+
+	/**
+	 * Are the knots evenly spaced, so found without a search?
+	 * @return True if evenly spaced.
+	 */
+	bool
+	IsUniform()
+		{ return m_Constants[1] != 0; };
+
+	/**
+	 * Virtual function to calculate a point for this function.
+	 * @param x (input) x input value for this function.
+	 * @return Y value corresponding to the x input.
+	 */
+	virtual TMathResult
+	CalculateY(
+		double x,
+		double *y);
+
+	/**
+	 * Calculate a block of points, the segment of every point found
+	 * before any is evaluated.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x, from the extremes of each
+	 * segment the range meets.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) for every x in the range between
+	 * the knots, flagged if the range goes beyond them.
+	 * @return MATH_UNDEFINED if the range misses the knots.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate a spline.
+	 * @param constants (input) Constants, as GetConstant gives them.
+	 * @param x (input) x input value.
+	 * @param y (output) Spline value at x.
+	 * @return MATH_UNDEFINED outside the knots.
+	 */
+	static TMathResult
+	Evaluate(
+		const double *constants,
+		double x,
+		double *y);
+
+	/**
+	 * Constants are the number of knots n, the inverse of the knot
+	 * spacing (0 if uneven), the n knot x values, then a, b, c and d
+	 * for each of the n - 1 segments.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return (int) m_Constants.size(); };
+
+	/**
+	 * Get a constant.
+	 * @param i (input) Index of the constant.
+	 * @return Constant value.
+	 */
+	virtual double
+	GetConstant(
+		int i)
+		{ return m_Constants[i]; };
+
+protected:
+
+	/**
+	 * Fit the segments through a set of knots.
+	 */
+	void
+	Build(
+		const double *x,
+		const double *y,
+		int count);
+
+	/**
+	 * Slope at each knot for a monotone cubic (Fritsch-Carlson).
+	 */
+	static void
+	GetMonotoneSlopes(
+		const std::vector<double>& x,
+		const std::vector<double>& y,
+		std::vector<double> *slopes);
+
+	/**
+	 * Second derivative at each knot for a natural cubic.
+	 */
+	static void
+	GetNaturalCurvatures(
+		const std::vector<double>& x,
+		const std::vector<double>& y,
+		std::vector<double> *curvatures);
+
+protected:
+	TSplineMethod m_Method;
+	std::vector<double> m_Constants;
+};
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ * Title: Transform
+ * A function shifted and scaled in x and y.
+ * @author Mary Wyllie
+ */
+
+#include "Transform.h"
+#include "TrigFunction.h"
+#include "MathKernels.h"
+
+/**
+ * Constructor. The identity of no function, undefined everywhere.
+ */
+Transform::Transform()
+{
+	m_Operator = MATH_TRANSFORM;
+	m_Function = NULL;
+	m_Trig = NULL;
+	m_Constants[0] = 1;
+	m_Constants[1] = 0;
+	m_Constants[2] = 1;
+	m_Constants[3] = 0;
+}
+
+/**
+ * Constructor. A transform of a transform,
+ * c1 (c2 f(a2 (a1 x + b1) + b2) + d2) + d1, is built as the one
+ * transform c1 c2 f(a2 a1 x + a2 b1 + b2) + c1 d2 + d1.
+ * @param function (input) Function transformed.
+ * @param xScale (input) a, scale of x.
+ * @param xOffset (input) b, added to a x.
+ * @param yScale (input) c, scale of f.
+ * @param yOffset (input) d, added to c f.
+ */
+Transform::Transform(
+	MathFunction *function,
+	double xScale,
+	double xOffset,
+	double yScale,
+	double yOffset)
+{
+	m_Operator = MATH_TRANSFORM;
+	m_Trig = NULL;
+
+	MathOperation *operation = function ? function->GetMathOperation() : NULL;
+	while(operation && operation->GetOperatorType() == MATH_TRANSFORM)
+	{
+		Transform *inner = (Transform*) operation;
+		xOffset = inner->m_Constants[0] * xOffset + inner->m_Constants[1];
+		xScale = inner->m_Constants[0] * xScale;
+		yOffset = yScale * inner->m_Constants[3] + yOffset;
+		yScale = yScale * inner->m_Constants[2];
+		function = inner->m_Function;
+		operation = function ? function->GetMathOperation() : NULL;
+	}
+
+	m_Function = function;
+	m_Constants[0] = xScale;
+	m_Constants[1] = xOffset;
+	m_Constants[2] = yScale;
+	m_Constants[3] = yOffset;
+
+	if(operation && operation->GetOperatorType() >= MATH_SIN &&
+		operation->GetOperatorType() <= MATH_CSC)
+	{
+		m_Trig = (TrigFunction*) operation;
+	}
+}
+
+/**
+ * Destructor.
+ */
+Transform::~Transform()
+{
+}
+
+/**
+ * Virtual function to calculate a point for this function.
+ * @param x (input) x input value for this function.
+ * @return Y value corresponding to the x input.
+ */
+TMathResult
+Transform::CalculateY(
+	double x,
+	double *y)
+{
+	TMathResult status = MATH_UNDEFINED;
+	double inside = m_Constants[0] * x + m_Constants[1], result = 0;
+
+	if(m_Trig)
+		status = TrigFunction::Evaluate(m_Trig->GetOperatorType(),
+			KernelAngle(m_Trig->GetAngleMode() == MATH_ANGLES_IN_DEGREES, inside),
+			m_Trig->GetEpsilon(), &result);
+	else if(m_Function)
+		status = m_Function->CalculateY(inside, &result);
+
+	if(status == MATH_SUCCESS) *y = m_Constants[2] * result + m_Constants[3];
+	return status;
+}
+
+/**
+ * Calculate a block of points, a tile of transformed x values at a
+ * time.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Transform::CalculateYBlock(
+	const double *x,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(x, y, status, count);
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Transform::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	EvaluateBlock(x, y, status, count);
+}
+
+/**
+ * Calculate a block of points for either scalar type: a x + b for a
+ * tile, the function, or the trig kernel, over the tile, then c f + d.
+ */
+template <class T>
+void
+Transform::EvaluateBlock(
+	const T *x,
+	T *y,
+	TMathResult *status,
+	int count)
+{
+	T inside[MATH_BLOCK_SIZE], outside[MATH_BLOCK_SIZE];
+
+	if(!m_Function)
+	{
+		for(int i = 0; i < count; i++) status[i] = MATH_UNDEFINED;
+		return;
+	}
+
+	T a = (T) m_Constants[0], b = (T) m_Constants[1];
+	T c = (T) m_Constants[2], d = (T) m_Constants[3];
+	bool isDegrees = (m_Trig && m_Trig->GetAngleMode() == MATH_ANGLES_IN_DEGREES);
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+
+		#pragma omp simd
+		for(int j = 0; j < n; j++) inside[j] = a * x[start + j] + b;
+
+		if(m_Trig)
+			KernelTrigBlock(m_Trig->GetOperatorType(), isDegrees,
+				(T) m_Trig->GetEpsilon(), inside, outside, blockStatus, n);
+		else
+			m_Function->CalculateYBlock(inside, outside, blockStatus, n);
+
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] == MATH_SUCCESS) y[start + j] = c * outside[j] + d;
+		}
+	}
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. NaNs pass
+ * through c f + d unchanged.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+Transform::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	double inside[MATH_BLOCK_SIZE];
+	double a = m_Constants[0], b = m_Constants[1];
+	double c = m_Constants[2], d = m_Constants[3];
+
+	if(!m_Function)
+	{
+		double nan = KernelNaN<double>();
+		for(int i = 0; i < count; i++) y[i] = nan;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		double *yb = y + start;
+
+		#pragma omp simd
+		for(int j = 0; j < n; j++) inside[j] = a * x[start + j] + b;
+		m_Function->CalculateYBlockNaN(inside, yb, n);
+		#pragma omp simd
+		for(int j = 0; j < n; j++) yb[j] = c * yb[j] + d;
+	}
+}
+
+/**
+ * Calculate points at equally spaced x values. a x + b steps from
+ * a xStart + b by a step, so the function is sampled over those and
+ * keeps whatever it does with the spacing.
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+Transform::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	double values[MATH_BLOCK_SIZE];
+	double a = m_Constants[0], b = m_Constants[1];
+	double c = m_Constants[2], d = m_Constants[3];
+
+	if(!m_Function)
+	{
+		for(int i = 0; i < count; i++) status[i] = MATH_UNDEFINED;
+		return;
+	}
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+		TMathResult *blockStatus = status + start;
+
+		m_Function->SampleUniform(a * (xStart + (double) start * step) + b,
+			a * step, values, blockStatus, n);
+		for(int j = 0; j < n; j++)
+		{
+			if(blockStatus[j] == MATH_SUCCESS) y[start + j] = c * values[j] + d;
+		}
+	}
+}
+
+/**
+ * Bound this function over a range of x, by bounding the function over
+ * a x + b.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+Transform::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	Interval inside, outside;
+	if(!m_Function) return MATH_UNDEFINED;
+
+	inside = Interval(m_Constants[0]) * x + Interval(m_Constants[1]);
+	inside.SetMayBeUndefined(x.MayBeUndefined());
+	TMathResult status = m_Function->CalculateInterval(inside, &outside);
+	if(status != MATH_SUCCESS) return status;
+
+	*y = Interval(m_Constants[2]) * outside + Interval(m_Constants[3]);
+	y->SetMayBeUndefined(outside.MayBeUndefined());
+	return MATH_SUCCESS;
+}
+
+/**
+ * Get the function transformed.
+ * @param children (output) Operand functions.
+ */
+void
+Transform::GetChildren(
+	std::vector<MathFunction*> *children)
+{
+	children->clear();
+	children->push_back(m_Function);
+}
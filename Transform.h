@@ -0,0 +1,201 @@
+/**
+ * Title: Transform
+ * A function shifted and scaled in x and y.
+ * @author Mary Wyllie
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "MathFunction.h"
+#include "MathOperation.h"
+
+class TrigFunction;
+
+/**
+ * Class for a function shifted and scaled in x and y,
+ * c f(a x + b) + d, as one node. It does the work of a linear
+ * polynomial inside a CompositeFunction and two SimpleOperators
+ * around it, with one call to f and a multiply-add either side of it:
+ *
+ *	MathFunction sin = MathFunction(MATH_SIN);
+ *	MathFunction wave = MathFunction(new Transform(&sin, 2, 0, 3, 1));
+ *
+ * is 3 sin(2x) + 1. The function is not owned.
+ *
+ * A transform of a transform is built as one transform of the inner
+ * function, and a transform of a trig function calls the trig kernels
+ * directly, converting a x + b from degrees as the function would.
+ */
+class
+Transform :
+	public MathOperation
+{
+public:
+
+	/**
+	 * Constructor. The identity of no function, undefined everywhere.
+	 */
+	Transform();
+
+	/**
+	 * Constructor.
+	 * @param function (input) Function transformed. A Transform's own
+	 * function is taken instead, and the two transforms combined.
+	 * @param xScale (input) a, scale of x.
+	 * @param xOffset (input) b, added to a x.
+	 * @param yScale (input) c, scale of f.
+	 * @param yOffset (input) d, added to c f.
+	 */
+	Transform(
+		MathFunction *function,
+		double xScale = 1.0,
+		double xOffset = 0.0,
+		double yScale = 1.0,
+		double yOffset = 0.0);
+
+	/**
+	 * Destructor.
+	 */
+	virtual
+	~Transform();
+
+	/**
+	 * Get the function transformed.
+	 * @return Pointer to MathFunction.
+	 */
+	MathFunction*
+	GetFunction()
+		{ return m_Function; };
+
+	/**
+	 * Virtual function to calculate a point for this function.
+	 * @param x (input) x input value for this function.
+	 * @return Y value corresponding to the x input.
+	 */
+	virtual TMathResult
+	CalculateY(
+		double x,
+		double *y);
+
+	/**
+	 * Calculate a block of points, a tile of transformed x values at
+	 * a time.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const double *x,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values. a x + b is equally
+	 * spaced too, so the function is sampled over it.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Get the function transformed.
+	 * @param children (output) Operand functions.
+	 */
+	virtual void
+	GetChildren(
+		std::vector<MathFunction*> *children);
+
+	/**
+	 * Constants are a, b, c and d of c f(a x + b) + d.
+	 * @return Number of constants.
+	 */
+	virtual int
+	GetConstantCount()
+		{ return 4; };
+
+	/**
+	 * Get a constant.
+	 * @param i (input) Index of the constant.
+	 * @return Constant value.
+	 */
+	virtual double
+	GetConstant(
+		int i)
+		{ return m_Constants[i]; };
+
+protected:
+
+	/**
+	 * Calculate a block of points for either scalar type.
+	 */
+	template <class T>
+	void
+	EvaluateBlock(
+		const T *x,
+		T *y,
+		TMathResult *status,
+		int count);
+
+protected:
+	MathFunction *m_Function;
+
+	//------------------------------------------
+	// The function's operation if it is a trig
+	// function, evaluated directly.
+	//------------------------------------------
+	TrigFunction *m_Trig;
+
+	double m_Constants[4];
+};
+
+#endif
@@ -6,7 +6,10 @@
 
 #include "TrigFunction.h"
 #include "MathFunction.h"
+#include "CompositeFunction.h"
+#include "MathKernels.h"
 #include <math.h>
+#include <vector>
 
 /**
  * Class for a trig functions.
@@ -26,6 +29,7 @@ TrigFunction::TrigFunction()
 TrigFunction::TrigFunction(
 	TOperatorType function)
 {
+	m_Operator = function;
 }
 
 /**
@@ -45,15 +49,160 @@ TrigFunction::CalculateY(
 	double x,
 	double *y)
 {
-	TMathResult status = MATH_SUCCESS;
-	double result = 0;
-	double angle = x;
+	double angle = KernelAngle(GetAngleMode() == MATH_ANGLES_IN_DEGREES, x);
+	return(Evaluate(GetOperatorType(), angle, GetEpsilon(), y));
+}
+
+/**
+ * Calculate a block of points in single precision.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+TrigFunction::CalculateYBlock(
+	const float *x,
+	float *y,
+	TMathResult *status,
+	int count)
+{
+	KernelTrigBlock(GetOperatorType(),
+		GetAngleMode() == MATH_ANGLES_IN_DEGREES, (float) GetEpsilon(),
+		x, y, status, count);
+}
+
+/**
+ * Calculate a block of points with undefined points as NaN. Every
+ * point is calculated, and the reciprocal functions select NaN where
+ * the value they divide by is within epsilon of 0, as Evaluate does.
+ * @param x (input) x input values for this function.
+ * @param y (output) y output values, NaN where undefined.
+ * @param count (input) Number of points.
+ */
+void
+TrigFunction::CalculateYBlockNaN(
+	const double *x,
+	double *y,
+	int count)
+{
+	bool isDegrees = (GetAngleMode() == MATH_ANGLES_IN_DEGREES);
+	double epsilon = GetEpsilon();
+	double nan = KernelNaN<double>();
+
+	switch(GetOperatorType())
+	{
+	case MATH_SIN:
+		for(int i = 0; i < count; i++) y[i] = sin(KernelAngle(isDegrees, x[i]));
+		break;
+	case MATH_COS:
+		for(int i = 0; i < count; i++) y[i] = cos(KernelAngle(isDegrees, x[i]));
+		break;
+	case MATH_TAN:
+		for(int i = 0; i < count; i++) y[i] = tan(KernelAngle(isDegrees, x[i]));
+		break;
+	case MATH_COT:
+		for(int i = 0; i < count; i++)
+		{
+			double t = tan(KernelAngle(isDegrees, x[i]));
+			y[i] = KernelIsNearZero(t, epsilon) ? nan : 1/t;
+		}
+		break;
+	case MATH_SEC:
+		for(int i = 0; i < count; i++)
+		{
+			double c = cos(KernelAngle(isDegrees, x[i]));
+			y[i] = KernelIsNearZero(c, epsilon) ? nan : 1/c;
+		}
+		break;
+	case MATH_CSC:
+		for(int i = 0; i < count; i++)
+		{
+			double s = sin(KernelAngle(isDegrees, x[i]));
+			y[i] = KernelIsNearZero(s, epsilon) ? nan : 1/s;
+		}
+		break;
+	default:
+		for(int i = 0; i < count; i++) y[i] = nan;
+		break;
+	}
+}
+
+/**
+ * Calculate points at equally spaced x values by stepping sine and
+ * cosine through the step angle, calculating them directly every
+ * KERNEL_SINCOS_RUN points so rounding cannot build up. The other
+ * trig functions are found from sine and cosine, as for trig
+ * functions of the same argument (see CalculateShared).
+ * @param xStart (input) First x value.
+ * @param step (input) Distance between x values.
+ * @param y (output) y output values. Left unchanged where undefined.
+ * @param status (output) TMathResult for each point.
+ * @param count (input) Number of points.
+ */
+void
+TrigFunction::SampleUniform(
+	double xStart,
+	double step,
+	double *y,
+	TMathResult *status,
+	int count)
+{
+	double s[MATH_BLOCK_SIZE], c[MATH_BLOCK_SIZE];
+	bool isDegrees = (GetAngleMode() == MATH_ANGLES_IN_DEGREES);
+
+	for(int start = 0; start < count; start += MATH_BLOCK_SIZE)
+	{
+		int n = (count - start < MATH_BLOCK_SIZE) ? count - start : MATH_BLOCK_SIZE;
+
+		KernelSinCosUniform(xStart, step, start, isDegrees, s, c, n);
+		for(int j = 0; j < n; j++) status[start + j] = MATH_SUCCESS;
+		KernelTrigFromSinCos(GetOperatorType(), GetEpsilon(), s, c,
+			y + start, status + start, n);
+	}
+}
+
+/**
+ * Bound this function over a range of x.
+ * @param x (input) Range of x values.
+ * @param y (output) Contains f(x) wherever f is defined in the range.
+ * @return MATH_UNDEFINED if f is undefined over the whole range.
+ */
+TMathResult
+TrigFunction::CalculateInterval(
+	const Interval& x,
+	Interval *y)
+{
+	Interval angle = x;
 	if(GetAngleMode() == MATH_ANGLES_IN_DEGREES)
 	{
-		angle = DegreesToRadians(x);
+		angle = x * Interval(Interval::RoundDown(MATH_PI_OVER_180),
+			Interval::RoundUp(MATH_PI_OVER_180));
 	}
+	return(EvaluateInterval(GetOperatorType(), angle, GetEpsilon(), y));
+}
 
-	switch(GetOperatorType())
+/**
+ * Calculate a trig function of an angle in radians.
+ * @param type (input) MATH_SIN, MATH_COS, MATH_TAN, MATH_COT,
+ * MATH_SEC or MATH_CSC.
+ * @param angle (input) Angle in radians.
+ * @param epsilon (input) Reciprocals of values within this of 0
+ * are undefined.
+ * @param y (output) Result value.
+ * @return TMathResult for successful calculation (or not).
+ */
+TMathResult
+TrigFunction::Evaluate(
+	TOperatorType type,
+	double angle,
+	double epsilon,
+	double *y)
+{
+	TMathResult status = MATH_SUCCESS;
+	double result = 0;
+
+	switch(type)
 	{
 	case MATH_SIN:
 		result = sin(angle);
@@ -66,21 +215,21 @@ TrigFunction::CalculateY(
 		break;
 	case MATH_COT:
 		result = tan(angle);
-		if(!IsEqual(result, 0))
+		if(!IsWithin(result, 0, epsilon))
 			result = 1/result;
 		else
 			status = MATH_UNDEFINED;
 		break;
 	case MATH_SEC:
 		result = cos(angle);
-		if(!IsEqual(result, 0))
+		if(!IsWithin(result, 0, epsilon))
 			result = 1/result;
 		else
 			status = MATH_UNDEFINED;
 		break;
 	case MATH_CSC:
 		result = sin(angle);
-		if(!IsEqual(result, 0))
+		if(!IsWithin(result, 0, epsilon))
 			result = 1/result;
 		else
 			status = MATH_UNDEFINED;
@@ -93,3 +242,339 @@ TrigFunction::CalculateY(
 	return status;
 }
 
+/**
+ * Does [lower, upper] contain phase + k * period for some whole k?
+ * Leans towards yes by a little, since both the bounds and the
+ * multiples of pi are rounded.
+ */
+static bool
+ContainsPeriodicPoint(
+	double lower,
+	double upper,
+	double phase,
+	double period)
+{
+	double a = (lower - phase) / period;
+	double b = (upper - phase) / period;
+	double slack = 1e-12 * (1 + fabs(a) + fabs(b));
+	return(ceil(a - slack) <= floor(b + slack));
+}
+
+/**
+ * Bound sin or cos over a range of angles. Between its turning
+ * points each is monotonic, so the range is that of the end points
+ * widened to 1 or -1 where a turning point is inside.
+ */
+static Interval
+SinCosInterval(
+	bool isSin,
+	const Interval& angle)
+{
+	Interval result(-1, 1);
+	result.SetMayBeUndefined(angle.MayBeUndefined());
+	if(!angle.IsBounded() || angle.GetWidth() >= MATH_2PI) return(result);
+
+	double a = angle.GetLower(), b = angle.GetUpper();
+	double fa = isSin ? sin(a) : cos(a);
+	double fb = isSin ? sin(b) : cos(b);
+	double lower = Interval::RoundDown((fa < fb) ? fa : fb);
+	double upper = Interval::RoundUp((fa < fb) ? fb : fa);
+
+	if(ContainsPeriodicPoint(a, b, isSin ? MATH_PI / 2 : 0, MATH_2PI))
+		upper = 1;
+	if(ContainsPeriodicPoint(a, b, isSin ? -MATH_PI / 2 : MATH_PI, MATH_2PI))
+		lower = -1;
+
+	result = Interval((lower < -1) ? -1 : lower, (upper > 1) ? 1 : upper);
+	result.SetMayBeUndefined(angle.MayBeUndefined());
+	return(result);
+}
+
+/**
+ * Bound a trig function over a range of angles in radians.
+ * sin and cos follow their turning points; sec and csc divide 1 by
+ * them with the same epsilon as a single reciprocal; tan and cot are
+ * monotonic between poles, and a range reaching a pole is unbounded.
+ * @param type (input) MATH_SIN, MATH_COS, MATH_TAN, MATH_COT,
+ * MATH_SEC or MATH_CSC.
+ * @param angle (input) Range of angles in radians.
+ * @param epsilon (input) Reciprocals of values within this of 0
+ * are undefined.
+ * @param y (output) Range of values, flagged if the range of
+ * angles may reach a pole or an undefined reciprocal.
+ * @return MATH_UNDEFINED if every angle is undefined.
+ */
+TMathResult
+TrigFunction::EvaluateInterval(
+	TOperatorType type,
+	const Interval& angle,
+	double epsilon,
+	Interval *y)
+{
+	TMathResult status = MATH_SUCCESS;
+	double lower = angle.GetLower(), upper = angle.GetUpper();
+	bool isBounded = angle.IsBounded();
+
+	switch(type)
+	{
+	case MATH_SIN:
+	case MATH_COS:
+		*y = SinCosInterval(type == MATH_SIN, angle);
+		break;
+	case MATH_SEC:
+	case MATH_CSC:
+		status = Interval(1).Divide(SinCosInterval(type == MATH_CSC, angle),
+			epsilon, y);
+		break;
+	case MATH_TAN:
+		if(!isBounded || upper - lower >= MATH_PI ||
+			ContainsPeriodicPoint(lower, upper, MATH_PI / 2, MATH_PI))
+		{
+			*y = Interval::Entire();
+			y->SetMayBeUndefined(true);
+		}
+		else
+		{
+			*y = Interval(Interval::RoundDown(tan(lower)),
+				Interval::RoundUp(tan(upper)));
+		}
+		break;
+	case MATH_COT:
+		{
+			//--------------------------------------------
+			// cot is undefined where tan is within epsilon
+			// of 0, around each multiple of pi.
+			//--------------------------------------------
+			double tanLower = tan(lower), tanUpper = tan(upper);
+			bool isLowerUndefined = IsWithin(tanLower, 0, epsilon);
+			bool isUpperUndefined = IsWithin(tanUpper, 0, epsilon);
+
+			if(isBounded && upper - lower < MATH_PI / 2 &&
+				isLowerUndefined && isUpperUndefined)
+			{
+				return MATH_UNDEFINED;
+			}
+			if(!isBounded || upper - lower >= MATH_PI ||
+				ContainsPeriodicPoint(lower, upper, 0, MATH_PI))
+			{
+				*y = Interval::Entire();
+				y->SetMayBeUndefined(true);
+			}
+			else
+			{
+				*y = Interval(
+					Interval::RoundDown(Interval::RoundDown(1 / tanUpper)),
+					Interval::RoundUp(Interval::RoundUp(1 / tanLower)));
+				y->SetMayBeUndefined(isLowerUndefined || isUpperUndefined);
+			}
+		}
+		break;
+	default:
+		return MATH_UNDEFINED;
+	}
+
+	if(status == MATH_SUCCESS && angle.MayBeUndefined())
+		y->SetMayBeUndefined(true);
+	return status;
+}
+
+/**
+ * Find the trig operation in a function which is a trig function of
+ * x, or a composite with a trig function outside.
+ * @param function (input) Function to look at.
+ * @param trig (output) Trig operation.
+ * @param argument (output) Function the trig function is of, NULL
+ * for x itself.
+ * @return false if the function is neither.
+ */
+bool
+TrigFunction::GetTrigArgument(
+	MathFunction *function,
+	TrigFunction **trig,
+	MathFunction **argument)
+{
+	MathOperation *operation = function ? function->GetMathOperation() : NULL;
+	if(!operation) return false;
+
+	*argument = NULL;
+	if(operation->GetOperatorType() == MATH_COMPOSITE)
+	{
+		CompositeFunction *composite = (CompositeFunction*) operation;
+		*argument = composite->GetInsideFunction();
+		operation = composite->GetOutsideFunction() ?
+			composite->GetOutsideFunction()->GetMathOperation() : NULL;
+		if(!operation || !*argument) return false;
+	}
+
+	TOperatorType type = operation->GetOperatorType();
+	if(type < MATH_SIN || type > MATH_CSC) return false;
+	*trig = (TrigFunction*) operation;
+	return true;
+}
+
+/**
+ * Are two functions trig functions of the same argument in the same
+ * angle mode? Arguments are the same if they are the same function,
+ * or polynomials with the same coefficients.
+ * @param a (input) First function.
+ * @param b (input) Second function.
+ * @return True/false
+ */
+bool
+TrigFunction::IsSameArgument(
+	MathFunction *a,
+	MathFunction *b)
+{
+	TrigFunction *trigA, *trigB;
+	MathFunction *argumentA, *argumentB;
+
+	if(!GetTrigArgument(a, &trigA, &argumentA) ||
+		!GetTrigArgument(b, &trigB, &argumentB))
+	{
+		return false;
+	}
+	if(trigA->GetAngleMode() != trigB->GetAngleMode()) return false;
+	if(argumentA == argumentB) return true;
+	if(!argumentA || !argumentB) return false;
+
+	MathOperation *operationA = argumentA->GetMathOperation();
+	MathOperation *operationB = argumentB->GetMathOperation();
+	if(!operationA || !operationB ||
+		operationA->GetOperatorType() != MATH_POLYNOMIAL ||
+		operationB->GetOperatorType() != MATH_POLYNOMIAL ||
+		operationA->GetConstantCount() != operationB->GetConstantCount())
+	{
+		return false;
+	}
+	for(int i = 0; i < operationA->GetConstantCount(); i++)
+	{
+		if(operationA->GetConstant(i) != operationB->GetConstant(i)) return false;
+	}
+	return true;
+}
+
+/**
+ * Calculate a block of points for several functions at once, sharing
+ * sine and cosine between trig functions of the same argument.
+ * @param functions (input) Functions to calculate.
+ * @param count (input) Number of functions.
+ * @param x (input) x input values.
+ * @param values (output) y output values for each function. Left
+ * unchanged where undefined.
+ * @param status (output) TMathResult for each function and point.
+ * @param n (input) Number of points.
+ */
+template <class T>
+void
+TrigFunction::CalculateShared(
+	MathFunction *const *functions,
+	int count,
+	const T *x,
+	T *const *values,
+	TMathResult *const *status,
+	int n)
+{
+	char doneBuffer[MATH_BLOCK_SIZE];
+	int groupBuffer[MATH_BLOCK_SIZE];
+	std::vector<char> moreDone;
+	std::vector<int> moreGroup;
+	char *isDone = doneBuffer;
+	int *group = groupBuffer;
+	if(count > MATH_BLOCK_SIZE)
+	{
+		moreDone.resize(count);
+		moreGroup.resize(count);
+		isDone = &moreDone[0];
+		group = &moreGroup[0];
+	}
+	for(int i = 0; i < count; i++) isDone[i] = false;
+	T argument[MATH_BLOCK_SIZE], angle[MATH_BLOCK_SIZE];
+	T s[MATH_BLOCK_SIZE], c[MATH_BLOCK_SIZE];
+	TMathResult argumentStatus[MATH_BLOCK_SIZE];
+
+	for(int i = 0; i < count; i++)
+	{
+		if(isDone[i] || !functions[i]) continue;
+
+		//----------------------------------------------
+		// Gather the later functions with the same
+		// argument as this one.
+		//----------------------------------------------
+		int size = 0;
+		group[size++] = i;
+		for(int k = i + 1; k < count; k++)
+		{
+			if(!isDone[k] && IsSameArgument(functions[i], functions[k]))
+			{
+				group[size++] = k;
+				isDone[k] = true;
+			}
+		}
+		if(size == 1)
+		{
+			functions[i]->CalculateYBlock(x, values[i], status[i], n);
+			continue;
+		}
+
+		TrigFunction *trig;
+		MathFunction *inside;
+		GetTrigArgument(functions[i], &trig, &inside);
+		bool isDegrees = (trig->GetAngleMode() == MATH_ANGLES_IN_DEGREES);
+
+		for(int start = 0; start < n; start += MATH_BLOCK_SIZE)
+		{
+			int m = (n - start < MATH_BLOCK_SIZE) ? n - start : MATH_BLOCK_SIZE;
+
+			if(inside)
+			{
+				inside->CalculateYBlock(x + start, argument, argumentStatus, m);
+				for(int j = 0; j < m; j++)
+				{
+					if(argumentStatus[j] != MATH_SUCCESS) argument[j] = 0;
+				}
+			}
+			else
+			{
+				for(int j = 0; j < m; j++)
+				{
+					argument[j] = x[start + j];
+					argumentStatus[j] = MATH_SUCCESS;
+				}
+			}
+
+			KernelAngleBlock(isDegrees, argument, angle, m);
+			KernelSinCosBlock(angle, s, c, m);
+
+			for(int g = 0; g < size; g++)
+			{
+				int k = group[g];
+				TrigFunction *member;
+				MathFunction *memberArgument;
+				GetTrigArgument(functions[k], &member, &memberArgument);
+				TMathResult *memberStatus = status[k] + start;
+				for(int j = 0; j < m; j++) memberStatus[j] = argumentStatus[j];
+				KernelTrigFromSinCos(member->GetOperatorType(),
+					(T) member->GetEpsilon(), s, c, values[k] + start,
+					memberStatus, m);
+			}
+		}
+	}
+}
+
+template void
+TrigFunction::CalculateShared<double>(
+	MathFunction *const *functions,
+	int count,
+	const double *x,
+	double *const *values,
+	TMathResult *const *status,
+	int n);
+
+template void
+TrigFunction::CalculateShared<float>(
+	MathFunction *const *functions,
+	int count,
+	const float *x,
+	float *const *values,
+	TMathResult *const *status,
+	int n);
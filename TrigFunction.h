@@ -48,6 +48,154 @@ public:
 		double x,
 		double *y);
 
+	using MathOperation::CalculateYBlock;
+
+	/**
+	 * Calculate a block of points in single precision.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlock(
+		const float *x,
+		float *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Calculate a block of points with undefined points as NaN.
+	 * @param x (input) x input values for this function.
+	 * @param y (output) y output values, NaN where undefined.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	CalculateYBlockNaN(
+		const double *x,
+		double *y,
+		int count);
+
+	/**
+	 * Calculate points at equally spaced x values by stepping sine
+	 * and cosine through the step angle (see KernelSinCosUniform),
+	 * calculating them directly every few points so rounding cannot
+	 * build up.
+	 * @param xStart (input) First x value.
+	 * @param step (input) Distance between x values.
+	 * @param y (output) y output values. Left unchanged where undefined.
+	 * @param status (output) TMathResult for each point.
+	 * @param count (input) Number of points.
+	 */
+	virtual void
+	SampleUniform(
+		double xStart,
+		double step,
+		double *y,
+		TMathResult *status,
+		int count);
+
+	/**
+	 * Bound this function over a range of x.
+	 * @param x (input) Range of x values.
+	 * @param y (output) Contains f(x) wherever f is defined in the range.
+	 * @return MATH_UNDEFINED if f is undefined over the whole range.
+	 */
+	virtual TMathResult
+	CalculateInterval(
+		const Interval& x,
+		Interval *y);
+
+	/**
+	 * Calculate a trig function of an angle in radians.
+	 * @param type (input) MATH_SIN, MATH_COS, MATH_TAN, MATH_COT,
+	 * MATH_SEC or MATH_CSC.
+	 * @param angle (input) Angle in radians.
+	 * @param epsilon (input) Reciprocals of values within this of 0
+	 * are undefined.
+	 * @param y (output) Result value.
+	 * @return TMathResult for successful calculation (or not).
+	 */
+	static TMathResult
+	Evaluate(
+		TOperatorType type,
+		double angle,
+		double epsilon,
+		double *y);
+
+	/**
+	 * Bound a trig function over a range of angles in radians.
+	 * @param type (input) MATH_SIN, MATH_COS, MATH_TAN, MATH_COT,
+	 * MATH_SEC or MATH_CSC.
+	 * @param angle (input) Range of angles in radians.
+	 * @param epsilon (input) Reciprocals of values within this of 0
+	 * are undefined.
+	 * @param y (output) Range of values, flagged if the range of
+	 * angles may reach a pole or an undefined reciprocal.
+	 * @return MATH_UNDEFINED if every angle is undefined.
+	 */
+	static TMathResult
+	EvaluateInterval(
+		TOperatorType type,
+		const Interval& angle,
+		double epsilon,
+		Interval *y);
+
+	/**
+	 * Find the trig operation in a function which is a trig function
+	 * of x, or a composite with a trig function outside.
+	 * @param function (input) Function to look at.
+	 * @param trig (output) Trig operation.
+	 * @param argument (output) Function the trig function is of, NULL
+	 * for x itself.
+	 * @return false if the function is neither.
+	 */
+	static bool
+	GetTrigArgument(
+		MathFunction *function,
+		TrigFunction **trig,
+		MathFunction **argument);
+
+	/**
+	 * Are two functions trig functions of the same argument in the
+	 * same angle mode? Arguments are the same if they are the same
+	 * function, or polynomials with the same coefficients.
+	 * @param a (input) First function.
+	 * @param b (input) Second function.
+	 * @return True/false
+	 */
+	static bool
+	IsSameArgument(
+		MathFunction *a,
+		MathFunction *b);
+
+	/**
+	 * Calculate a block of points for several functions at once.
+	 * Trig functions of the same argument (see IsSameArgument) share
+	 * one calculation of the argument and one range reduction for
+	 * sine and cosine together, and each is found from that pair:
+	 * tan as sin/cos, sec as 1/cos and so on, with the same epsilon
+	 * tests as Evaluate. Results may differ from calculating each
+	 * function on its own in the last bits. Other functions are
+	 * calculated as usual, and NULL functions are skipped.
+	 * @param functions (input) Functions to calculate.
+	 * @param count (input) Number of functions.
+	 * @param x (input) x input values.
+	 * @param values (output) y output values for each function. Left
+	 * unchanged where undefined.
+	 * @param status (output) TMathResult for each function and point.
+	 * @param n (input) Number of points.
+	 */
+	template <class T>
+	static void
+	CalculateShared(
+		MathFunction *const *functions,
+		int count,
+		const T *x,
+		T *const *values,
+		TMathResult *const *status,
+		int n);
+
 protected:
 
 };